@@ -0,0 +1,321 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API and u64
+#include <common/MPMCRingBuffer.hpp> // for com::MPMCRingBuffer
+
+#include <atomic> // for std::atomic<>
+#include <functional> // for std::function
+#include <memory> // for std::shared_ptr, std::weak_ptr and std::unique_ptr
+#include <mutex> // for std::mutex
+#include <vector> // for std::vector
+#include <utility> // for std::move and std::swap
+#include <algorithm> // for std::find_if
+
+namespace com
+{
+	// Thread-safe object pool, the concurrent counterpart of com::DynamicPool
+	// Each thread keeps two magazines (arrays of up to MagazineSize free objects) of its own, so get() and put() don't touch any shared state
+	// as long as the thread's magazines can serve them. Only whole magazines move from one thread to another, through a lock-free depot
+	// (a com::MPMCRingBuffer of full magazines and another of empty ones), so the objects put back on one thread are reused on another
+	// at the cost of one depot operation per MagazineSize objects.
+	// The magazines of a thread go back into the depot when the thread exits.
+	// NOTE: there is no notion of active objects (no reclaim() or getActives()) as it would need shared bookkeeping on every get() and put()
+	template<typename T>
+	class COMMON_API ConcurrentDynamicPool
+	{
+	public:
+		typedef std::function<T()> OnCreate;
+		typedef std::function<void(T&)> OnDestroy;
+		typedef std::function<void(T&)> OnReturn;
+		typedef std::function<void(T&)> OnRecycle;
+		using ElementType = T;
+
+		static constexpr std::size_t MagazineSize = 32;
+		static constexpr std::size_t DefaultDepotCapacity = 1024;
+
+	private:
+		typedef std::vector<T> Magazine;
+
+		struct ThreadCache
+		{
+			// get() and put() work on the loaded one, the previous one is either full or empty
+			Magazine* loaded;
+			Magazine* previous;
+		};
+
+		// State shared with the threads' caches, it outlives the pool if a thread is flushing its cache while the pool is being destroyed
+		struct Shared
+		{
+			u64 id;
+			OnCreate onCreate;
+			OnDestroy onDestroy;
+			OnReturn onReturn;
+			OnRecycle onRecycle;
+			MPMCRingBuffer<Magazine*> fullMagazines;
+			MPMCRingBuffer<Magazine*> emptyMagazines;
+			std::atomic<std::size_t> objectCount;
+			std::mutex cachesMutex;
+			std::vector<std::unique_ptr<ThreadCache>> caches;
+
+			Shared(OnCreate onCreate, OnDestroy onDestroy, OnReturn onReturn, OnRecycle onRecycle, std::size_t depotCapacity);
+			~Shared() noexcept;
+
+			Magazine* getEmptyMagazine();
+			void putEmptyMagazine(Magazine* magazine) noexcept;
+			// Destroys the objects if the depot is full
+			void putFullMagazine(Magazine* magazine) noexcept;
+			void destroyObjects(Magazine* magazine) noexcept;
+			// Called on the thread's exit
+			void releaseCache(ThreadCache* cache) noexcept;
+		};
+
+		struct ThreadCacheEntry
+		{
+			u64 poolId;
+			std::weak_ptr<Shared> shared;
+			ThreadCache* cache;
+		};
+
+		// The caches of a thread, one for each pool the thread has used
+		struct ThreadCaches
+		{
+			std::vector<ThreadCacheEntry> entries;
+			~ThreadCaches() noexcept;
+		};
+
+		std::shared_ptr<Shared> m_shared;
+		// Copy of m_shared->id, saves a dereference on every get() and put()
+		u64 m_id;
+
+		static ThreadCaches& getThreadCaches() noexcept
+		{
+			thread_local ThreadCaches caches;
+			return caches;
+		}
+		ThreadCache& getThreadCache();
+		ThreadCache& createThreadCache();
+
+	public:
+		// 'depotCapacity' is the maximum number of magazines in the depot, the objects put back beyond that are destroyed
+		ConcurrentDynamicPool(OnCreate onCreate,
+							OnDestroy onDestroy = nullptr,
+							OnReturn onReturn = nullptr,
+							OnRecycle onRecycle = nullptr,
+							std::size_t depotCapacity = DefaultDepotCapacity);
+		ConcurrentDynamicPool(const ConcurrentDynamicPool&) = delete;
+		ConcurrentDynamicPool& operator=(const ConcurrentDynamicPool&) = delete;
+		// Destroys all the objects in the pool (calls OnDestroy on them)
+		// NOTE: no other thread may be using the pool while it is being destroyed
+		~ConcurrentDynamicPool() noexcept = default;
+
+		T get();
+		void put(T value);
+		// Creates 'count' objects into the depot, as many of them as it can hold
+		void reserve(std::size_t count);
+
+		// Number of objects created and not yet destroyed, both the ones in the pool and the ones taken out of it
+		std::size_t size() const noexcept { return m_shared->objectCount.load(std::memory_order_relaxed); }
+	};
+
+	template<typename T>
+	ConcurrentDynamicPool<T>::Shared::Shared(OnCreate onCreate, OnDestroy onDestroy, OnReturn onReturn, OnRecycle onRecycle, std::size_t depotCapacity) :
+																														onCreate(std::move(onCreate)),
+																														onDestroy(std::move(onDestroy)),
+																														onReturn(std::move(onReturn)),
+																														onRecycle(std::move(onRecycle)),
+																														fullMagazines(depotCapacity),
+																														emptyMagazines(depotCapacity),
+																														objectCount(0)
+	{
+		static std::atomic<u64> idCounter = 0;
+		// Never reused, so a thread's cache entry of a destroyed pool can't be mistaken for a new pool's
+		id = ++idCounter;
+	}
+
+	template<typename T>
+	ConcurrentDynamicPool<T>::Shared::~Shared() noexcept
+	{
+		for(auto& cache : caches)
+		{
+			destroyObjects(cache->loaded);
+			destroyObjects(cache->previous);
+			delete cache->loaded;
+			delete cache->previous;
+		}
+		Magazine* magazine;
+		while(fullMagazines.tryPop(magazine))
+		{
+			destroyObjects(magazine);
+			delete magazine;
+		}
+		while(emptyMagazines.tryPop(magazine))
+			delete magazine;
+	}
+
+	template<typename T>
+	typename ConcurrentDynamicPool<T>::Magazine* ConcurrentDynamicPool<T>::Shared::getEmptyMagazine()
+	{
+		Magazine* magazine;
+		if(emptyMagazines.tryPop(magazine))
+			return magazine;
+		magazine = new Magazine();
+		magazine->reserve(MagazineSize);
+		return magazine;
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::Shared::putEmptyMagazine(Magazine* magazine) noexcept
+	{
+		if(!emptyMagazines.tryPush(magazine))
+			delete magazine;
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::Shared::putFullMagazine(Magazine* magazine) noexcept
+	{
+		if(fullMagazines.tryPush(magazine))
+			return;
+		destroyObjects(magazine);
+		putEmptyMagazine(magazine);
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::Shared::destroyObjects(Magazine* magazine) noexcept
+	{
+		if(onDestroy)
+			for(T& object : *magazine)
+				onDestroy(object);
+		objectCount.fetch_sub(magazine->size(), std::memory_order_relaxed);
+		magazine->clear();
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::Shared::releaseCache(ThreadCache* cache) noexcept
+	{
+		for(Magazine* magazine : { cache->loaded, cache->previous })
+		{
+			if(magazine->empty())
+				putEmptyMagazine(magazine);
+			else
+				putFullMagazine(magazine);
+		}
+		std::lock_guard<std::mutex> lock(cachesMutex);
+		auto it = std::find_if(caches.begin(), caches.end(), [cache](const auto& ptr) { return ptr.get() == cache; });
+		if(it != caches.end())
+			caches.erase(it);
+	}
+
+	template<typename T>
+	ConcurrentDynamicPool<T>::ThreadCaches::~ThreadCaches() noexcept
+	{
+		for(auto& entry : entries)
+			// The pool might have been destroyed already, in which case it has destroyed this cache as well
+			if(auto shared = entry.shared.lock())
+				shared->releaseCache(entry.cache);
+	}
+
+	template<typename T>
+	ConcurrentDynamicPool<T>::ConcurrentDynamicPool(OnCreate onCreate, OnDestroy onDestroy, OnReturn onReturn, OnRecycle onRecycle, std::size_t depotCapacity) :
+																		m_shared(std::make_shared<Shared>(std::move(onCreate), std::move(onDestroy), std::move(onReturn), std::move(onRecycle), depotCapacity)),
+																		m_id(m_shared->id)
+	{
+
+	}
+
+	template<typename T>
+	typename ConcurrentDynamicPool<T>::ThreadCache& ConcurrentDynamicPool<T>::getThreadCache()
+	{
+		for(auto& entry : getThreadCaches().entries)
+			if(entry.poolId == m_id)
+				return *entry.cache;
+		return createThreadCache();
+	}
+
+	template<typename T>
+	typename ConcurrentDynamicPool<T>::ThreadCache& ConcurrentDynamicPool<T>::createThreadCache()
+	{
+		auto& entries = getThreadCaches().entries;
+		// Forget the pools which have been destroyed since this thread used them
+		std::erase_if(entries, [](const ThreadCacheEntry& entry) { return entry.shared.expired(); });
+		auto cache = std::make_unique<ThreadCache>(ThreadCache { m_shared->getEmptyMagazine(), m_shared->getEmptyMagazine() });
+		ThreadCache* ptr = cache.get();
+		{
+			std::lock_guard<std::mutex> lock(m_shared->cachesMutex);
+			m_shared->caches.push_back(std::move(cache));
+		}
+		entries.push_back({ m_id, m_shared, ptr });
+		return *ptr;
+	}
+
+	template<typename T>
+	T ConcurrentDynamicPool<T>::get()
+	{
+		ThreadCache& cache = getThreadCache();
+		if(cache.loaded->empty())
+		{
+			if(!cache.previous->empty())
+				std::swap(cache.loaded, cache.previous);
+			else
+			{
+				// Both are empty, exchange one of them for a full one from the depot
+				Magazine* magazine;
+				if(!m_shared->fullMagazines.tryPop(magazine))
+				{
+					m_shared->objectCount.fetch_add(1, std::memory_order_relaxed);
+					return m_shared->onCreate();
+				}
+				m_shared->putEmptyMagazine(cache.previous);
+				cache.previous = cache.loaded;
+				cache.loaded = magazine;
+			}
+		}
+		T value = std::move(cache.loaded->back());
+		cache.loaded->pop_back();
+		if(m_shared->onRecycle)
+			m_shared->onRecycle(value);
+		return value;
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::put(T value)
+	{
+		if(m_shared->onReturn)
+			m_shared->onReturn(value);
+		ThreadCache& cache = getThreadCache();
+		if(cache.loaded->size() == MagazineSize)
+		{
+			if(cache.previous->empty())
+				std::swap(cache.loaded, cache.previous);
+			else
+			{
+				// Both are full, hand one of them over to the depot
+				m_shared->putFullMagazine(cache.previous);
+				cache.previous = cache.loaded;
+				cache.loaded = m_shared->getEmptyMagazine();
+			}
+		}
+		cache.loaded->push_back(std::move(value));
+	}
+
+	template<typename T>
+	void ConcurrentDynamicPool<T>::reserve(std::size_t count)
+	{
+		while(count > 0)
+		{
+			Magazine* magazine = m_shared->getEmptyMagazine();
+			for(; (count > 0) && (magazine->size() < MagazineSize); --count)
+			{
+				magazine->push_back(m_shared->onCreate());
+				m_shared->objectCount.fetch_add(1, std::memory_order_relaxed);
+				if(m_shared->onReturn)
+					m_shared->onReturn(magazine->back());
+			}
+			if(!m_shared->fullMagazines.tryPush(magazine))
+			{
+				m_shared->destroyObjects(magazine);
+				m_shared->putEmptyMagazine(magazine);
+				break;
+			}
+		}
+	}
+}
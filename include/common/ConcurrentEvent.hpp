@@ -0,0 +1,247 @@
+#pragma once
+
+#include <common/id_generator.h> // for generating unique ids for each subscription
+#include <common/debug.h> // for com_debug_log_error
+#include <common/defines.hpp> // for com::no_publish_ptr_t
+#include <common/Event.hpp> // for com::EventHandlerProto and com::args_checker
+#include <common/EpochDomain.hpp> // for com::EpochDomain
+
+#include <atomic> // for std::atomic<>
+#include <mutex> // for std::mutex and std::lock_guard
+#include <vector> // for std::vector
+#include <type_traits> // for std::is_same_v
+#include <utility> // for std::move and std::forward
+
+namespace com
+{
+	// com::Event which may be published, subscribed and unsubscribed on any thread at the same time
+	// publish() takes no lock: it invokes the handlers of an immutable snapshot of the active subscriptions, loaded from an atomic pointer.
+	// subscribe(), unsubscribe(), activate() and deactivate() are serialized by a mutex, each of them builds a new snapshot
+	// and swaps it in, and the old one is deleted by com::EpochDomain once the publishers which might still be invoking it have returned.
+	// So a mutation costs a copy of the active handlers, it is meant for events subscribed rarely and published often.
+	// NOTE: a publish() running on another thread may still invoke a handler after unsubscribe() has returned,
+	// call synchronize() before destroying anything the handler uses
+	// NOTE: the handlers may be invoked on several threads at the same time
+	// NOTE: no handler (nor anything captured in it) is destroyed while the mutex is locked, so their destructors may subscribe or unsubscribe
+	template<typename PublisherType, typename... Args>
+	class COMMON_API ConcurrentEvent
+	{
+	public:
+		static constexpr bool IsOrderedEventType = false;
+		typedef PublisherType* PublisherTypePtr;
+		typedef id_generator_id_type_t SubscriptionID;
+		typedef typename EventHandlerProto<PublisherType, Args...>::type EventHandler;
+		static constexpr id_generator_id_type_t InvalidSubscriptionID = ID_GENERATOR_ID_TYPE_MAX;
+
+	private:
+		struct Subscription
+		{
+			SubscriptionID id;
+			EventHandler handler;
+			bool isActive;
+		};
+
+		// Never modified once it has been swapped in
+		struct Snapshot
+		{
+			std::vector<EventHandler> handlers;
+		};
+
+		EpochDomain& m_domain;
+		// nullptr while there is no active subscription
+		std::atomic<Snapshot*> m_snapshot;
+		PublisherTypePtr m_publisher;
+		// Guards everything below
+		std::mutex m_mutex;
+		id_generator_t m_id_generator;
+		std::vector<Subscription> m_subscriptions;
+
+		Subscription* findSubscription(SubscriptionID id) noexcept;
+		// Swaps in a snapshot of m_subscriptions, m_mutex must be locked
+		// Returns the old snapshot (may be nullptr), to be retired once m_mutex is unlocked, as retiring it may destroy the handlers
+		Snapshot* updateSnapshot();
+		void retire(Snapshot* snapshot) { if(snapshot != nullptr) m_domain.retire(snapshot); }
+		void setActive(SubscriptionID id, bool isActive);
+
+	public:
+		template<typename T = PublisherType>
+		requires(std::is_same_v<T, no_publish_ptr_t>)
+		ConcurrentEvent() noexcept;
+		template<typename T = PublisherType>
+		requires(!std::is_same_v<T, no_publish_ptr_t>)
+		ConcurrentEvent(T* publisher) noexcept;
+		ConcurrentEvent(const ConcurrentEvent&) = delete;
+		ConcurrentEvent& operator=(const ConcurrentEvent&) = delete;
+		// NOTE: no other thread may be using the event while it is being destroyed
+		~ConcurrentEvent() noexcept;
+
+		// Description: Returns the number of subscriptions to this event
+		// Params: None
+		// Returns: an integer (unsigned)
+		COM_NO_DISCARD std::size_t size() noexcept;
+
+		template<typename F>
+		SubscriptionID subscribe(F&& f);
+		void unsubscribe(SubscriptionID id);
+		void activate(SubscriptionID id) { setActive(id, true); }
+		void deactivate(SubscriptionID id) { setActive(id, false); }
+		void clear();
+
+		// Waits until the publish() calls which might invoke the handlers unsubscribed (or deactivated) so far have returned
+		// NOTE: must not be called by a handler, it would wait for the publish() invoking it
+		void synchronize() { m_domain.synchronize(); }
+
+		template<typename... CallArgs>
+		void publish(CallArgs&&... args) noexcept;
+	};
+
+	template<typename PublisherType, typename... Args>
+	template<typename T>
+	requires(std::is_same_v<T, no_publish_ptr_t>)
+	ConcurrentEvent<PublisherType, Args...>::ConcurrentEvent() noexcept : m_domain(EpochDomain::global()),
+																		m_snapshot(nullptr),
+																		m_publisher(nullptr),
+																		m_id_generator(id_generator_create(0, NULL))
+	{
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename T>
+	requires(!std::is_same_v<T, no_publish_ptr_t>)
+	ConcurrentEvent<PublisherType, Args...>::ConcurrentEvent(T* publisher) noexcept : m_domain(EpochDomain::global()),
+																					m_snapshot(nullptr),
+																					m_publisher(publisher),
+																					m_id_generator(id_generator_create(0, NULL))
+	{
+	}
+
+	template<typename PublisherType, typename... Args>
+	ConcurrentEvent<PublisherType, Args...>::~ConcurrentEvent() noexcept
+	{
+		delete m_snapshot.load(std::memory_order_acquire);
+		id_generator_destroy(&m_id_generator);
+	}
+
+	template<typename PublisherType, typename... Args>
+	typename ConcurrentEvent<PublisherType, Args...>::Subscription* ConcurrentEvent<PublisherType, Args...>::findSubscription(SubscriptionID id) noexcept
+	{
+		for(auto& subscription : m_subscriptions)
+			if(subscription.id == id)
+				return &subscription;
+		com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
+		return nullptr;
+	}
+
+	template<typename PublisherType, typename... Args>
+	typename ConcurrentEvent<PublisherType, Args...>::Snapshot* ConcurrentEvent<PublisherType, Args...>::updateSnapshot()
+	{
+		Snapshot* snapshot = nullptr;
+		for(auto& subscription : m_subscriptions)
+		{
+			if(!subscription.isActive)
+				continue;
+			if(snapshot == nullptr)
+			{
+				snapshot = new Snapshot { };
+				snapshot->handlers.reserve(m_subscriptions.size());
+			}
+			snapshot->handlers.push_back(subscription.handler);
+		}
+		// seq_cst, see com::EpochDomain::enter()
+		return m_snapshot.exchange(snapshot, std::memory_order_seq_cst);
+	}
+
+	template<typename PublisherType, typename... Args>
+	void ConcurrentEvent<PublisherType, Args...>::setActive(SubscriptionID id, bool isActive)
+	{
+		Snapshot* oldSnapshot;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Subscription* subscription = findSubscription(id);
+			if((subscription == nullptr) || (subscription->isActive == isActive))
+				return;
+			subscription->isActive = isActive;
+			oldSnapshot = updateSnapshot();
+		}
+		retire(oldSnapshot);
+	}
+
+	template<typename PublisherType, typename... Args>
+	std::size_t ConcurrentEvent<PublisherType, Args...>::size() noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_subscriptions.size();
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename F>
+	typename ConcurrentEvent<PublisherType, Args...>::SubscriptionID ConcurrentEvent<PublisherType, Args...>::subscribe(F&& f)
+	{
+		EventHandler handler(std::forward<F>(f));
+		Snapshot* oldSnapshot;
+		SubscriptionID id;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			id = id_generator_get(&m_id_generator);
+			m_subscriptions.push_back({ id, std::move(handler), true });
+			oldSnapshot = updateSnapshot();
+		}
+		retire(oldSnapshot);
+		return id;
+	}
+
+	template<typename PublisherType, typename... Args>
+	void ConcurrentEvent<PublisherType, Args...>::unsubscribe(SubscriptionID id)
+	{
+		// Destroyed after the lock_guard, along with the old snapshot
+		Subscription removed { };
+		Snapshot* oldSnapshot = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Subscription* subscription = findSubscription(id);
+			if(subscription == nullptr)
+				return;
+			removed = std::move(*subscription);
+			if(subscription != &m_subscriptions.back())
+				*subscription = std::move(m_subscriptions.back());
+			m_subscriptions.pop_back();
+			if(removed.isActive)
+				oldSnapshot = updateSnapshot();
+		}
+		retire(oldSnapshot);
+	}
+
+	template<typename PublisherType, typename... Args>
+	void ConcurrentEvent<PublisherType, Args...>::clear()
+	{
+		// Destroyed after the lock_guard, along with the old snapshot
+		std::vector<Subscription> removed;
+		Snapshot* oldSnapshot;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			removed.swap(m_subscriptions);
+			oldSnapshot = updateSnapshot();
+		}
+		retire(oldSnapshot);
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename... CallArgs>
+	void ConcurrentEvent<PublisherType, Args...>::publish(CallArgs&&... args) noexcept
+	{
+		static_assert(args_checker<Args...>::template check<CallArgs...>(),
+					"publish() arguments count or types do not match handler arguments");
+		EpochDomain::ReadScope scope(m_domain);
+		// The snapshot can't be deleted before the scope exits
+		const Snapshot* snapshot = m_snapshot.load(std::memory_order_seq_cst);
+		if(snapshot == nullptr)
+			return;
+		for(auto& handler : snapshot->handlers)
+		{
+			if constexpr(std::is_same_v<PublisherType, no_publish_ptr_t>)
+				handler(std::forward<CallArgs>(args)...);
+			else
+				handler(m_publisher, std::forward<CallArgs>(args)...);
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API
+
+#include <cstddef> // for std::byte, std::size_t and std::max_align_t
+#include <cstring> // for std::memcpy
+#include <type_traits> // for std::is_trivially_copyable_v, std::decay_t and std::is_invocable_r_v
+#include <utility> // for std::forward and std::move
+#include <functional> // for std::invoke
+#include <new> // for placement new
+
+namespace com
+{
+	// Enough for a lambda capturing 'this' and two more pointers (or references)
+	static constexpr std::size_t DelegateDefaultInlineBytes = 3 * sizeof(void*);
+
+	template<typename Signature, std::size_t InlineBytes = DelegateDefaultInlineBytes>
+	class Delegate;
+
+	// Replacement of std::function for callbacks, which doesn't allocate memory for the small callables (the common ones)
+	// A callable is stored inline (in the Delegate object itself) if it fits in InlineBytes and is trivially copyable and destructible,
+	// as the lambdas capturing 'this', pointers, references or numbers are. Any other callable is allocated on the heap.
+	// Either way, the bytes of a Delegate can be moved to another place without calling anything (it is trivially relocatable),
+	// so moving it is a copy of a few words, and a container of Delegates never calls the callables' move constructors.
+	template<typename R, typename... Args, std::size_t InlineBytes>
+	class COMMON_API Delegate<R(Args...), InlineBytes>
+	{
+	public:
+		// True if Delegate doesn't allocate memory for a callable of type F
+		template<typename F>
+		static constexpr bool IsInline = (sizeof(F) <= InlineBytes) && (alignof(F) <= alignof(std::max_align_t))
+											&& std::is_trivially_copyable_v<F> && std::is_trivially_destructible_v<F>;
+
+	private:
+		enum class ManageOperation
+		{
+			Clone,
+			Destroy
+		};
+
+		typedef R (*InvokeFunction)(void* storage, Args&&... args);
+		// Only the callables allocated on the heap need to be managed
+		typedef void (*ManageFunction)(ManageOperation operation, void* storage, void* destinationStorage);
+
+		// Zeroed, as moving and copying a Delegate copies all of it, even the bytes a small callable (or no callable) leaves unused
+		alignas(std::max_align_t) mutable std::byte m_storage[InlineBytes < sizeof(void*) ? sizeof(void*) : InlineBytes] { };
+		InvokeFunction m_invoke;
+		ManageFunction m_manage;
+
+		template<typename F>
+		static F* getCallable(void* storage) noexcept
+		{
+			if constexpr(IsInline<F>)
+				return reinterpret_cast<F*>(storage);
+			else
+				return *reinterpret_cast<F**>(storage);
+		}
+
+		template<typename F>
+		static R invoke(void* storage, Args&&... args)
+		{
+			if constexpr(std::is_void_v<R>)
+				std::invoke(*getCallable<F>(storage), std::forward<Args>(args)...);
+			else
+				return std::invoke(*getCallable<F>(storage), std::forward<Args>(args)...);
+		}
+
+		template<typename F>
+		static void manage(ManageOperation operation, void* storage, void* destinationStorage)
+		{
+			F* callable = getCallable<F>(storage);
+			switch(operation)
+			{
+				case ManageOperation::Clone:
+				{
+					F* clone = new F(*callable);
+					std::memcpy(destinationStorage, &clone, sizeof(clone));
+					break;
+				}
+				case ManageOperation::Destroy:
+				{
+					delete callable;
+					break;
+				}
+			}
+		}
+
+		void reset() noexcept
+		{
+			if(m_manage)
+				m_manage(ManageOperation::Destroy, m_storage, nullptr);
+			m_invoke = nullptr;
+			m_manage = nullptr;
+		}
+
+		void copyFrom(const Delegate& delegate)
+		{
+			if(delegate.m_manage)
+				delegate.m_manage(ManageOperation::Clone, delegate.m_storage, m_storage);
+			else
+				std::memcpy(m_storage, delegate.m_storage, sizeof(m_storage));
+			m_invoke = delegate.m_invoke;
+			m_manage = delegate.m_manage;
+		}
+
+		void moveFrom(Delegate& delegate) noexcept
+		{
+			std::memcpy(m_storage, delegate.m_storage, sizeof(m_storage));
+			m_invoke = delegate.m_invoke;
+			m_manage = delegate.m_manage;
+			delegate.m_invoke = nullptr;
+			delegate.m_manage = nullptr;
+		}
+
+	public:
+		Delegate() noexcept : m_invoke(nullptr), m_manage(nullptr) { }
+		Delegate(std::nullptr_t) noexcept : Delegate() { }
+
+		template<typename F>
+		requires(!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+		Delegate(F&& f) : m_invoke(&invoke<std::decay_t<F>>)
+		{
+			using Callable = std::decay_t<F>;
+			if constexpr(IsInline<Callable>)
+			{
+				new(m_storage) Callable(std::forward<F>(f));
+				m_manage = nullptr;
+			}
+			else
+			{
+				Callable* callable = new Callable(std::forward<F>(f));
+				std::memcpy(m_storage, &callable, sizeof(callable));
+				m_manage = &manage<Callable>;
+			}
+		}
+
+		Delegate(const Delegate& delegate) { copyFrom(delegate); }
+		Delegate(Delegate&& delegate) noexcept { moveFrom(delegate); }
+		~Delegate() noexcept { reset(); }
+
+		Delegate& operator=(const Delegate& delegate)
+		{
+			if(this != &delegate)
+			{
+				reset();
+				copyFrom(delegate);
+			}
+			return *this;
+		}
+
+		Delegate& operator=(Delegate&& delegate) noexcept
+		{
+			if(this != &delegate)
+			{
+				reset();
+				moveFrom(delegate);
+			}
+			return *this;
+		}
+
+		Delegate& operator=(std::nullptr_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+
+		explicit operator bool() const noexcept { return m_invoke != nullptr; }
+		bool operator==(std::nullptr_t) const noexcept { return m_invoke == nullptr; }
+
+		// NOTE: calling an empty Delegate is undefined behaviour
+		R operator()(Args... args) const
+		{
+			return m_invoke(m_storage, std::forward<Args>(args)...);
+		}
+	};
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <common/defines.hpp>
+#include <common/dictionary.h> // for dictionary_t
+#include <common/HashTable.hpp> // for com::Hash
+
+#include <functional> // for std::equal_to
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <cstring> // for std::memcpy and std::memset
+
+namespace com
+{
+	// Typed wrapper over the hash indexed dictionary_t (see dictionary_create_hashed)
+	// The entries are stored contiguously in the insertion order (so they can be iterated as a plain array of Entry)
+	// and the key lookups go through the index inline with HashT and EqT, instead of calling the function pointers for each probe
+	// NOTE: the pointers to the entries are invalidated when the dictionary grows
+	template<typename K, typename V, typename HashT = Hash<K>, typename EqT = std::equal_to<K>>
+	class Dictionary
+	{
+		static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "dictionary_t copies the keys and the values bytewise");
+		static_assert(std::is_empty_v<HashT> && std::is_empty_v<EqT>, "HashT and EqT must be stateless as the C API calls them through plain function pointers");
+	public:
+		struct Entry
+		{
+			K key;
+			V value;
+		};
+		static_assert(alignof(Entry) <= 16, "the storage of dictionary_t is aligned to at most 16 bytes");
+
+		typedef K KeyType;
+		typedef V ValueType;
+		typedef Entry* iterator;
+		typedef const Entry* const_iterator;
+
+	private:
+		// dictionary_t stores the key-value pairs packed, so the padding in between 'key' and 'value' is made a part of the key
+		// and the padding at the end a part of the value, that way each pair is laid out exactly as Entry and stays aligned
+		static constexpr u32 ValueOffset = static_cast<u32>((sizeof(K) + alignof(V) - 1) / alignof(V) * alignof(V));
+
+		dictionary_t m_dictionary;
+
+		static hash_t getHashThunk(void* key) noexcept { return HashT { } (*reinterpret_cast<const K*>(key)); }
+		static bool isEqualThunk(void* lhs, void* rhs) noexcept { return EqT { } (*reinterpret_cast<const K*>(lhs), *reinterpret_cast<const K*>(rhs)); }
+
+		Entry* getEntries() const noexcept { return reinterpret_cast<Entry*>(buf_get_ptr(const_cast<BUFFER*>(&m_dictionary.buffer))); }
+
+	public:
+		Dictionary(buf_ucount_t capacity = 0) noexcept : m_dictionary(__dictionary_create_hashed(ValueOffset, sizeof(Entry) - ValueOffset, capacity, isEqualThunk, getHashThunk)) { }
+		Dictionary(Dictionary&& dictionary) noexcept;
+		Dictionary(const Dictionary&) = delete;
+		~Dictionary() noexcept;
+
+		Dictionary& operator=(Dictionary&& dictionary) noexcept;
+		Dictionary& operator=(const Dictionary&) = delete;
+
+		// Appends a key-value pair (the keys are not checked for duplicates, just like dictionary_push())
+		void add(const K& key, const V& value) noexcept
+		{
+			Entry entry { key, value };
+			dictionary_push_n(&m_dictionary, &entry, 1);
+		}
+		// Appends a key-value pair and returns reference to its value, which must be assigned by the caller
+		V& emplace(const K& key) noexcept
+		{
+			alignas(Entry) u8 bytes[sizeof(Entry)];
+			std::memcpy(bytes, &key, sizeof(K));
+			return *reinterpret_cast<V*>(dictionary_emplace(&m_dictionary, bytes));
+		}
+		// Appends 'count' entries at once
+		void add(const Entry* entries, buf_ucount_t count) noexcept { dictionary_push_n(&m_dictionary, const_cast<Entry*>(entries), count); }
+		// Returns true if the key has been removed, otherwise false (not found)
+		// NOTE: it is O(n), as the entries after the removed one are shifted
+		bool remove(const K& key) noexcept
+		{
+			if(findIndex(key) == DICTIONARY_INVALID_INDEX)
+				return false;
+			dictionary_remove(&m_dictionary, const_cast<K*>(&key));
+			return true;
+		}
+		void clear() noexcept { dictionary_clear(&m_dictionary); }
+
+		// Returns index of the entry with the key 'key', otherwise DICTIONARY_INVALID_INDEX
+		// Same as index_find_slot() in dictionary.c, or dictionary_find_index_of() once the dictionary has no index (frozen through getHandle())
+		buf_ucount_t findIndex(const K& key) const noexcept;
+		// Returns pointer to the value, or nullptr if the key doesn't exist
+		V* find(const K& key) noexcept
+		{
+			buf_ucount_t index = findIndex(key);
+			return (index == DICTIONARY_INVALID_INDEX) ? nullptr : &getEntries()[index].value;
+		}
+		const V* find(const K& key) const noexcept { return const_cast<Dictionary*>(this)->find(key); }
+		bool contains(const K& key) const noexcept { return findIndex(key) != DICTIONARY_INVALID_INDEX; }
+
+		Entry& operator[](buf_ucount_t index) noexcept { return getEntries()[index]; }
+		const Entry& operator[](buf_ucount_t index) const noexcept { return getEntries()[index]; }
+		buf_ucount_t size() const noexcept { return buf_get_element_count(const_cast<BUFFER*>(&m_dictionary.buffer)); }
+		bool empty() const noexcept { return size() == 0; }
+		// For passing the underlying dictionary to the C API
+		dictionary_t* getHandle() noexcept { return &m_dictionary; }
+
+		iterator begin() noexcept { return getEntries(); }
+		iterator end() noexcept { return getEntries() + size(); }
+		const_iterator begin() const noexcept { return getEntries(); }
+		const_iterator end() const noexcept { return getEntries() + size(); }
+	};
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	Dictionary<K, V, HashT, EqT>::Dictionary(Dictionary&& dictionary) noexcept : m_dictionary(dictionary.m_dictionary)
+	{
+		// the moved-from dictionary can only be destroyed or assigned to
+		std::memset(&dictionary.m_dictionary, 0, sizeof(dictionary_t));
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	Dictionary<K, V, HashT, EqT>::~Dictionary() noexcept
+	{
+		// a moved-from dictionary is all zeros
+		if(m_dictionary.key_comparer != NULL)
+			dictionary_free(&m_dictionary);
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	Dictionary<K, V, HashT, EqT>& Dictionary<K, V, HashT, EqT>::operator=(Dictionary&& dictionary) noexcept
+	{
+		if(this == &dictionary)
+			return *this;
+		if(m_dictionary.key_comparer != NULL)
+			dictionary_free(&m_dictionary);
+		m_dictionary = dictionary.m_dictionary;
+		std::memset(&dictionary.m_dictionary, 0, sizeof(dictionary_t));
+		return *this;
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	buf_ucount_t Dictionary<K, V, HashT, EqT>::findIndex(const K& key) const noexcept
+	{
+		if(m_dictionary.index_slots == NULL)
+			return dictionary_find_index_of(const_cast<dictionary_t*>(&m_dictionary), const_cast<K*>(&key));
+		u32 hash = static_cast<u32>(HashT { } (key));
+		u32 mask = m_dictionary.index_slot_count - 1;
+		const Entry* entries = getEntries();
+		// the index is at most half full, so the probing always ends at an empty slot
+		for(u32 i = hash & mask;; i = (i + 1) & mask)
+		{
+			const dictionary_index_slot_t& slot = m_dictionary.index_slots[i];
+			if(slot.index == DICTIONARY_INDEX_SLOT_EMPTY)
+				return DICTIONARY_INVALID_INDEX;
+			if((slot.hash == hash) && EqT { } (entries[slot.index].key, key))
+				return slot.index;
+		}
+	}
+}
@@ -5,14 +5,45 @@
 #include <common/debug.h> // for debug_log_error()
 
 #include <functional> // for std::function
-#include <utility> // for std::swap
+#include <utility> // for std::swap and std::in_place
 #include <vector> // for std::vector
 #include <algorithm> // for std::find
+#include <iterator> // for std::distance
+#include <concepts> // for std::same_as, std::convertible_to and std::equality_comparable
 
 namespace com
 {
+	// Identifies an object taken out of a DynamicPool with getHandle(), put(Handle) is then constant time
+	// The generation changes every time the object is put back, so a stale or a double put is detected with a single comparison
+	struct DynamicPoolHandle
+	{
+		u32 slot;
+		u32 generation;
+
+		bool operator==(const DynamicPoolHandle&) const noexcept = default;
+	};
+
+	// A DynamicPool calls these hooks of its policy (a class with static or non-static member functions):
+	//	T create() or T create(u32 slot) - required, 'slot' is the slot the new object is going to occupy in the pool
+	//	void destroy(T&), void onReturn(T&), void onRecycle(T&) - optional
+	//	bool isEqual(T&, T&) - optional, put(T) compares the objects with operator== if it is missing
+	// The hooks are called directly, so the ones defined inline in the policy cost nothing more than the code in them
+	template<typename Policy, typename T>
+	concept DynamicPoolCreateHook = requires(Policy& policy) { { policy.create() } -> std::convertible_to<T>; };
+	template<typename Policy, typename T>
+	concept DynamicPoolSlotCreateHook = requires(Policy& policy, u32 slot) { { policy.create(slot) } -> std::convertible_to<T>; };
+	template<typename Policy, typename T>
+	concept DynamicPoolDestroyHook = requires(Policy& policy, T& value) { policy.destroy(value); };
+	template<typename Policy, typename T>
+	concept DynamicPoolReturnHook = requires(Policy& policy, T& value) { policy.onReturn(value); };
+	template<typename Policy, typename T>
+	concept DynamicPoolRecycleHook = requires(Policy& policy, T& value) { policy.onRecycle(value); };
+	template<typename Policy, typename T>
+	concept DynamicPoolEqualHook = requires(Policy& policy, T& value1, T& value2) { { policy.isEqual(value1, value2) } -> std::convertible_to<bool>; };
+
+	// The default policy, the hooks are set at runtime as std::function objects and any of them (except OnCreate) can be left null
 	template<typename T>
-	class DynamicPool
+	class COMMON_API DynamicPoolFunctionPolicy
 	{
 	public:
 		typedef std::function<T()> OnCreate;
@@ -20,50 +51,145 @@ namespace com
 		typedef std::function<void(T&)> OnReturn;
 		typedef std::function<void(T&)> OnRecycle;
 		typedef std::function<bool(T&, T&)> OnEqual;
-		typedef std::function<typename std::vector<T>::iterator(const T&)> FindValueCallback;
-		using ElementType = T;
 
 	private:
-		std::vector<T> m_storage;
-		std::size_t m_activeCount;
 		OnCreate m_onCreate;
 		OnDestroy m_onDestroy;
 		OnReturn m_onReturn;
 		OnRecycle m_onRecycle;
 		OnEqual m_onEqual;
 
+	public:
+		DynamicPoolFunctionPolicy(OnCreate onCreate = nullptr,
+								OnDestroy onDestroy = nullptr,
+								OnReturn onReturn = nullptr,
+								OnRecycle onRecycle = nullptr,
+								OnEqual onEqual = nullptr) noexcept : m_onCreate(std::move(onCreate)),
+																	m_onDestroy(std::move(onDestroy)),
+																	m_onReturn(std::move(onReturn)),
+																	m_onRecycle(std::move(onRecycle)),
+																	m_onEqual(std::move(onEqual)) { }
+
+		T create() { return m_onCreate(); }
+		void destroy(T& value) { if(m_onDestroy) m_onDestroy(value); }
+		void onReturn(T& value) { if(m_onReturn) m_onReturn(value); }
+		void onRecycle(T& value) { if(m_onRecycle) m_onRecycle(value); }
+		bool isEqual(T& value1, T& value2)
+		{
+			if constexpr(std::equality_comparable<T>)
+			{
+				if(!m_onEqual)
+					return value1 == value2;
+			}
+			else
+			{
+				_com_assert(m_onEqual);
+			}
+			return m_onEqual(value1, value2);
+		}
+
+		void setOnCreate(OnCreate onCreate) { m_onCreate = std::move(onCreate); }
+		void setOnDestroy(OnDestroy onDestroy) { m_onDestroy = std::move(onDestroy); }
+		void setOnReturn(OnReturn onReturn) { m_onReturn = std::move(onReturn); }
+		void setOnRecycle(OnRecycle onRecycle) { m_onRecycle = std::move(onRecycle); }
+	};
+
+	// DynamicPool<T> is the std::function form, pass a policy of your own as the second argument to have the hooks inlined
+	template<typename T, typename Policy = DynamicPoolFunctionPolicy<T>>
+	class COMMON_API DynamicPool
+	{
+		static_assert(DynamicPoolCreateHook<Policy, T> || DynamicPoolSlotCreateHook<Policy, T>, "The policy must have T create() or T create(u32 slot)");
+
+	public:
+		typedef std::function<T()> OnCreate;
+		typedef std::function<void(T&)> OnDestroy;
+		typedef std::function<void(T&)> OnReturn;
+		typedef std::function<void(T&)> OnRecycle;
+		typedef std::function<bool(T&, T&)> OnEqual;
+		using ElementType = T;
+		using PolicyType = Policy;
+		using Handle = DynamicPoolHandle;
+
+	private:
+		static constexpr bool IsFunctionPolicy = std::same_as<Policy, DynamicPoolFunctionPolicy<T>>;
+
+		struct Slot
+		{
+			u32 position;
+			u32 generation;
+		};
+
+		std::vector<T> m_storage;
+		std::size_t m_activeCount;
+		// A slot is the position at which an object has been created, the object keeps it while it is moved around by put()
+		// Slot of the object at each position of m_storage
+		std::vector<u32> m_positionSlots;
+		// Position and generation of each slot, the generations are kept across clear() so that the old handles stay invalid
+		std::vector<Slot> m_slots;
+		[[no_unique_address]] Policy m_policy;
+
 		typename std::vector<T>::iterator getLastActive() noexcept;
+		// Calls the policy's create hook for the object to be appended to m_storage
+		T create() noexcept;
+		void onReturn(T& value) noexcept;
+		// Creates or recycles an object and returns it
+		T& activate() noexcept;
+		// Must be called after every push_back on m_storage
+		void onPushed() noexcept;
+		void swapPositions(std::size_t position1, std::size_t position2) noexcept;
+		// Swaps the object at 'position' with the last active one and deactivates it
+		template<typename SwapFn>
+		void deactivate(std::size_t position, SwapFn swap) noexcept;
+		// Constructs the pool for the constructors below
+		DynamicPool(std::in_place_t, Policy policy, bool isReturn, std::size_t initialCount) noexcept;
 
 	protected:
-		template<typename SwapFn>
-		void put_(T value, FindValueCallback findValueCallback, SwapFn swap) noexcept;
+		// The std::function policy has no create hook until setOnCreate() is called, so only a derived pool may leave it out
+		explicit DynamicPool(Policy policy, bool isReturn = false, std::size_t initialCount = 0) noexcept requires IsFunctionPolicy : DynamicPool(std::in_place, std::move(policy), isReturn, initialCount) { }
 
-		std::vector<T>& getStorage() { return m_storage; }
+		// 'findValue' returns the iterator to the active object equal to the value, or the end of the active objects
+		template<typename FindFn, typename SwapFn>
+		void put_(T value, FindFn findValue, SwapFn swap) noexcept;
 
-		void setOnCreate(OnCreate onCreate) { m_onCreate = onCreate; }
-		void setOnDestroy(OnDestroy onDestroy) { m_onDestroy = onDestroy; }
-		void setOnReturn(OnReturn onReturn) { m_onReturn = onReturn; }
-		void setOnRecycle(OnRecycle onRecycle) { m_onRecycle = onRecycle; }
+		std::vector<T>& getStorage() { return m_storage; }
+		bool isSlotActive(u32 slot) const noexcept { return (slot < m_storage.size()) && (m_slots[slot].position < m_activeCount); }
+		std::size_t getSlotPosition(u32 slot) const noexcept { return m_slots[slot].position; }
 
-		DynamicPool(OnDestroy onDestroy = nullptr,
-					OnReturn onReturn = nullptr,
-					OnRecycle onRecycle = nullptr) noexcept;
+		void setOnCreate(OnCreate onCreate) requires IsFunctionPolicy { m_policy.setOnCreate(std::move(onCreate)); }
+		void setOnDestroy(OnDestroy onDestroy) requires IsFunctionPolicy { m_policy.setOnDestroy(std::move(onDestroy)); }
+		void setOnReturn(OnReturn onReturn) requires IsFunctionPolicy { m_policy.setOnReturn(std::move(onReturn)); }
+		void setOnRecycle(OnRecycle onRecycle) requires IsFunctionPolicy { m_policy.setOnRecycle(std::move(onRecycle)); }
 
 	public:
+		explicit DynamicPool(Policy policy = { }, bool isReturn = false, std::size_t initialCount = 0) noexcept requires(!IsFunctionPolicy) : DynamicPool(std::in_place, std::move(policy), isReturn, initialCount) { }
 		DynamicPool(OnCreate onCreate,
 					OnDestroy onDestroy = nullptr, 
 					OnReturn onReturn = nullptr, 
 					OnRecycle onRecycle = nullptr,
 					OnEqual onEqual = nullptr,
 					bool isReturn = false, 
-					std::size_t initialCount = 0) noexcept;
+					std::size_t initialCount = 0) noexcept requires IsFunctionPolicy : DynamicPool(std::in_place, Policy(std::move(onCreate), std::move(onDestroy), std::move(onReturn), std::move(onRecycle), std::move(onEqual)), isReturn, initialCount) { }
 		DynamicPool(DynamicPool&& pool) noexcept;
 		~DynamicPool() noexcept;
 
 		DynamicPool& operator =(DynamicPool&& pool) noexcept;
 
+		Policy& getPolicy() noexcept { return m_policy; }
+
 		T get() noexcept;
+		// Linear time, it has to look for the value among the active objects
 		void put(T value) noexcept;
+		// Same as get(), but returns a handle to the object
+		Handle getHandle() noexcept;
+		// Constant time, a stale handle (of an object already put back) is reported and ignored
+		void put(Handle handle) noexcept;
+		bool isValid(Handle handle) const noexcept { return (handle.slot < m_slots.size()) && (m_slots[handle.slot].generation == handle.generation) && isSlotActive(handle.slot); }
+		// NOTE: the reference is invalidated by the next get(), put(), reserve() or clear()
+		T& getValue(Handle handle) noexcept
+		{
+			_com_assert(isValid(handle));
+			return m_storage[m_slots[handle.slot].position];
+		}
 		// Puts all the active objects back into the pool
 		// NOTE: this operation doesn't destroy the objects, it just cals OnReturn on every object
 		void reclaim() noexcept;
@@ -85,86 +211,147 @@ namespace com
 		}
 	};
 
-	template<typename T>
-	DynamicPool<T>::DynamicPool(OnDestroy onDestroy, OnReturn onReturn, OnRecycle onRecycle) noexcept : m_activeCount(0),
-																										m_onDestroy(onDestroy),
-																										m_onReturn(onReturn),
-																										m_onRecycle(onRecycle) { }
-
-
-	template<typename T>
-	DynamicPool<T>::DynamicPool(OnCreate onCreate, OnDestroy onDestroy, OnReturn onReturn, OnRecycle onRecycle, OnEqual onEqual, bool isReturn, std::size_t initialCount) noexcept : 
-																																				m_activeCount(0),
-																																				m_onCreate(onCreate),
-																																				m_onDestroy(onDestroy),
-																																				m_onReturn(onReturn),
-																																				m_onRecycle(onRecycle),
-																																				m_onEqual(onEqual)
+	template<typename T, typename Policy>
+	DynamicPool<T, Policy>::DynamicPool(std::in_place_t, Policy policy, bool isReturn, std::size_t initialCount) noexcept : m_activeCount(0), m_policy(std::move(policy))
 	{
 		m_storage.reserve(initialCount);
 		for(std::size_t i = 0; i < initialCount; ++i)
 		{
-			m_storage.push_back(onCreate());
-			if(isReturn && m_onReturn)
-				m_onReturn(m_storage[i]);
+			m_storage.push_back(create());
+			onPushed();
+			if(isReturn)
+				onReturn(m_storage[i]);
 		}
 	}
 
-	template<typename T>
-	DynamicPool<T>::DynamicPool(DynamicPool<T>&& pool) noexcept : m_storage(std::move(pool.m_storage)),
-																m_activeCount(pool.m_activeCount),
-																m_onCreate(std::move(m_onCreate)),
-																m_onDestroy(std::move(m_onDestroy)),
-																m_onReturn(std::move(m_onReturn)),
-																m_onRecycle(std::move(m_onRecycle)),
-																m_onEqual(std::move(m_onEqual))
+	template<typename T, typename Policy>
+	DynamicPool<T, Policy>::DynamicPool(DynamicPool&& pool) noexcept : m_storage(std::move(pool.m_storage)),
+																		m_activeCount(pool.m_activeCount),
+																		m_positionSlots(std::move(pool.m_positionSlots)),
+																		m_slots(std::move(pool.m_slots)),
+																		m_policy(std::move(pool.m_policy))
 	{
-
+		pool.m_activeCount = 0;
 	}
 
-	template<typename T>
-	DynamicPool<T>::~DynamicPool() noexcept
+	template<typename T, typename Policy>
+	DynamicPool<T, Policy>::~DynamicPool() noexcept
 	{
 		clear();
 	}
 
-	template<typename T>
-	DynamicPool<T>& DynamicPool<T>::operator=(DynamicPool<T>&& pool) noexcept
+	template<typename T, typename Policy>
+	DynamicPool<T, Policy>& DynamicPool<T, Policy>::operator=(DynamicPool&& pool) noexcept
 	{
-		m_storage = std::move(pool);
+		clear();
+		m_storage = std::move(pool.m_storage);
 		m_activeCount = pool.m_activeCount;
-		m_onCreate = pool.m_onCreate;
-		m_onDestroy = pool.m_onDestroy;
-		m_onReturn = pool.m_onReturn;
-		m_onRecycle = pool.m_onRecycle;
-		m_onEqual = pool.m_onEqual;
+		m_positionSlots = std::move(pool.m_positionSlots);
+		m_slots = std::move(pool.m_slots);
+		m_policy = std::move(pool.m_policy);
+		pool.m_activeCount = 0;
 		return *this;
 	}
 
-	template<typename T>
-	T DynamicPool<T>::get() noexcept
+	template<typename T, typename Policy>
+	T DynamicPool<T, Policy>::create() noexcept
+	{
+		if constexpr(DynamicPoolSlotCreateHook<Policy, T>)
+			return m_policy.create(static_cast<u32>(m_storage.size()));
+		else
+			return m_policy.create();
+	}
+
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::onReturn(T& value) noexcept
+	{
+		if constexpr(DynamicPoolReturnHook<Policy, T>)
+			m_policy.onReturn(value);
+	}
+
+	template<typename T, typename Policy>
+	T DynamicPool<T, Policy>::get() noexcept
+	{
+		return activate();
+	}
+
+	template<typename T, typename Policy>
+	T& DynamicPool<T, Policy>::activate() noexcept
 	{
 		_com_assert(m_activeCount <= m_storage.size());
 
 		// If no more inactive objects left, then create new
 		if(m_activeCount == m_storage.size())
-			m_storage.push_back(m_onCreate());
+		{
+			m_storage.push_back(create());
+			onPushed();
+		}
 		// Otherwise recycle the existing one
-		else
-			if(m_onRecycle)
-				m_onRecycle(m_storage[m_activeCount]);
+		else if constexpr(DynamicPoolRecycleHook<Policy, T>)
+			m_policy.onRecycle(m_storage[m_activeCount]);
 		// And return
 		return m_storage[m_activeCount++];
 	}
 
-	template<typename T>
-	typename std::vector<T>::iterator DynamicPool<T>::getLastActive() noexcept
+	template<typename T, typename Policy>
+	typename DynamicPool<T, Policy>::Handle DynamicPool<T, Policy>::getHandle() noexcept
+	{
+		activate();
+		u32 slot = m_positionSlots[m_activeCount - 1];
+		return { slot, m_slots[slot].generation };
+	}
+
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::put(Handle handle) noexcept
+	{
+		if(!isValid(handle))
+		{
+			com_debug_log_error("Stale handle, the object has already been put back into the pool");
+			return;
+		}
+		deactivate(m_slots[handle.slot].position, [](T& a, T& b) { std::swap(a, b); });
+	}
+
+	template<typename T, typename Policy>
+	typename std::vector<T>::iterator DynamicPool<T, Policy>::getLastActive() noexcept
 	{
 		_com_assert(m_activeCount > 0);
 		return std::next(m_storage.begin(), m_activeCount - 1);
 	}
 
-	decltype(auto) findOnEqual(auto itbegin, auto itend, auto value, auto onEqual)
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::onPushed() noexcept
+	{
+		u32 slot = static_cast<u32>(m_storage.size() - 1);
+		m_positionSlots.push_back(slot);
+		if(slot < m_slots.size())
+			m_slots[slot].position = slot;
+		else
+			m_slots.push_back({ slot, 0 });
+	}
+
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::swapPositions(std::size_t position1, std::size_t position2) noexcept
+	{
+		std::swap(m_positionSlots[position1], m_positionSlots[position2]);
+		m_slots[m_positionSlots[position1]].position = static_cast<u32>(position1);
+		m_slots[m_positionSlots[position2]].position = static_cast<u32>(position2);
+	}
+
+	template<typename T, typename Policy>
+	template<typename SwapFn>
+	void DynamicPool<T, Policy>::deactivate(std::size_t position, SwapFn swap) noexcept
+	{
+		std::size_t lastActivePosition = m_activeCount - 1;
+		swap(m_storage[position], m_storage[lastActivePosition]);
+		swapPositions(position, lastActivePosition);
+		// Invalidates the handles to this object
+		++m_slots[m_positionSlots[lastActivePosition]].generation;
+		onReturn(m_storage[lastActivePosition]);
+		--m_activeCount;
+	}
+
+	decltype(auto) findOnEqual(auto itbegin, auto itend, auto& value, auto onEqual)
 	{
 		for(auto it = itbegin; it != itend; ++it)
 			if(onEqual(*it, value))
@@ -172,36 +359,29 @@ namespace com
 		return itend;
 	}
 
-	template<typename T>
-	void DynamicPool<T>::put(T value) noexcept
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::put(T value) noexcept
 	{
-		put_(value, [this](const T& value)
+		put_(std::move(value), [this](T& value)
 			{
 				auto lastActiveEnd = std::next(getLastActive(), 1);
-				if constexpr(std::equality_comparable<T>)
-				{
-					if(m_onEqual)
-						return findOnEqual(m_storage.begin(), lastActiveEnd, value, m_onEqual);
-					return std::find(m_storage.begin(), lastActiveEnd, value);;
-				}
+				if constexpr(DynamicPoolEqualHook<Policy, T>)
+					return findOnEqual(m_storage.begin(), lastActiveEnd, value, [this](T& value1, T& value2) { return m_policy.isEqual(value1, value2); });
 				else
-				{
-					_com_assert(m_onEqual);
-					return findOnEqual(m_storage.begin(), lastActiveEnd, value, m_onEqual);
-				}
+					return std::find(m_storage.begin(), lastActiveEnd, value);
 			},
 			[](T& a, T& b) { std::swap(a, b); });
 	}
 
-	template<typename T>
-	template<typename SwapFn>
-	void DynamicPool<T>::put_(T value, FindValueCallback findValueCallback, SwapFn swap) noexcept
+	template<typename T, typename Policy>
+	template<typename FindFn, typename SwapFn>
+	void DynamicPool<T, Policy>::put_(T value, FindFn findValue, SwapFn swap) noexcept
 	{
 		_com_assert(m_activeCount > 0);
 
 		// Check if such value was ever taken out of the pool
 		auto lastActive = getLastActive();
-		auto it = findValueCallback(value);
+		auto it = findValue(value);
 		if(it == std::next(lastActive, 1))
 		{
 			com_debug_log_error("No such value ever gotten from the pool, but you're still trying to return/put back into it");
@@ -210,48 +390,50 @@ namespace com
 		*it = std::move(value);
 
 		// If yes then swap this value with the last active value
-		swap(*it, *lastActive);
-		if(m_onReturn)
-			m_onReturn(*lastActive);
-		--m_activeCount;
+		deactivate(std::distance(m_storage.begin(), it), swap);
 	}
 
-	template<typename T>
-	void DynamicPool<T>::reclaim() noexcept
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::reclaim() noexcept
 	{
 		if(m_activeCount == 0)
 			return;
 
-		auto lastActiveEnd = std::next(getLastActive(), 1);
-		if(m_onReturn)
+		if constexpr(DynamicPoolReturnHook<Policy, T>)
 		{
+			auto lastActiveEnd = std::next(getLastActive(), 1);
 			for(auto it = m_storage.begin(); it != lastActiveEnd; it++)
-				m_onReturn(*it);
+				m_policy.onReturn(*it);
 		}
+		for(std::size_t i = 0; i < m_activeCount; ++i)
+			++m_slots[m_positionSlots[i]].generation;
 		m_activeCount = 0;
 	}
 
-	template<typename T>
-	void DynamicPool<T>::clear() noexcept
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::clear() noexcept
 	{
 		if(m_activeCount == 0)
 			return;
-		if(m_onDestroy)
+		if constexpr(DynamicPoolDestroyHook<Policy, T>)
 		{
 			for(auto it = m_storage.begin(); it != m_storage.end(); it++)
-				m_onDestroy(*it);
+				m_policy.destroy(*it);
 		}
+		for(std::size_t i = 0; i < m_activeCount; ++i)
+			++m_slots[m_positionSlots[i]].generation;
 		m_storage.clear();
+		m_positionSlots.clear();
 		m_activeCount = 0;
 	}
 
 
-	template<typename T>
-	void DynamicPool<T>::reserve(std::size_t count, bool isReturn) noexcept
+	template<typename T, typename Policy>
+	void DynamicPool<T, Policy>::reserve(std::size_t count, bool isReturn) noexcept
 	{
 		// For now, we don't know what should happen if poolSize shrink is requested.
 		// I mean, right now we can't destroy SUTK::Container or SUTK::Renderable objects.
-		// Ideally, this should call m_onDestroy for every object being discarded during the size
+		// Ideally, this should call the destroy hook for every object being discarded during the size
 		// shrinking.
 		_com_assert(count >= m_storage.size());
 
@@ -259,9 +441,10 @@ namespace com
 		m_storage.reserve(count);
 		for(std::size_t i = 0; i < diff; ++i)
 		{
-			m_storage.push_back(m_onCreate());
-			if(isReturn && m_onReturn)
-				m_onReturn(m_storage.back());
+			m_storage.push_back(create());
+			onPushed();
+			if(isReturn)
+				onReturn(m_storage.back());
 		}
 	}
-}
\ No newline at end of file
+}
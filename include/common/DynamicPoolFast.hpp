@@ -6,13 +6,19 @@
 
 namespace com
 {
-	template<typename T>
+	template<typename T, typename Policy = DynamicPoolFunctionPolicy<T>>
 	class DynamicPoolFast;
 
+	template<typename T, typename Policy>
+	class DynamicPoolFastPolicy;
+
 	template<typename T>
 	class DynamicPoolFastElement
 	{
-		friend class DynamicPoolFast<T>;
+		template<typename, typename>
+		friend class DynamicPoolFast;
+		template<typename, typename>
+		friend class DynamicPoolFastPolicy;
 	private:
 		T m_value;
 		std::size_t m_index;
@@ -54,63 +60,74 @@ namespace com
 		const T& operator*() const { return m_value; }
 	};
 
-	template<typename T>
-	class DynamicPoolFast : public DynamicPool<DynamicPoolFastElement<T>>
+	// Policy of the DynamicPool underneath a DynamicPoolFast, wraps the objects created by 'Policy' into DynamicPoolFastElement<T>
+	// and forwards the other hooks to it. Those missing in 'Policy' are missing here too, so they cost nothing.
+	template<typename T, typename Policy>
+	class DynamicPoolFastPolicy
 	{
+	private:
+		Policy m_policy;
+
+	public:
+		DynamicPoolFastPolicy(Policy policy = { }) noexcept : m_policy(std::move(policy)) { }
+
+		// The index of an element is its DynamicPool slot, i.e. the position at which it is created (appended)
+		// NOTE: we can't do std::move(m_policy.create()) as move on temporary objects prevents copy elision
+		DynamicPoolFastElement<T> create(u32 slot) { return { m_policy.create(), slot }; }
+		void destroy(DynamicPoolFastElement<T>& el) requires DynamicPoolDestroyHook<Policy, T> { m_policy.destroy(el.getValue()); }
+		void onReturn(DynamicPoolFastElement<T>& el) requires DynamicPoolReturnHook<Policy, T> { m_policy.onReturn(el.getValue()); }
+		void onRecycle(DynamicPoolFastElement<T>& el) requires DynamicPoolRecycleHook<Policy, T> { m_policy.onRecycle(el.getValue()); }
+
+		Policy& getPolicy() noexcept { return m_policy; }
+	};
+
+	// DynamicPoolFast<T> is the std::function form, pass a policy of your own (see DynamicPool) as the second argument to have the hooks inlined
+	template<typename T, typename Policy>
+	class DynamicPoolFast : public DynamicPool<DynamicPoolFastElement<T>, DynamicPoolFastPolicy<T, Policy>>
+	{
+	private:
+		using BaseType = DynamicPool<DynamicPoolFastElement<T>, DynamicPoolFastPolicy<T, Policy>>;
+		static constexpr bool IsFunctionPolicy = std::same_as<Policy, DynamicPoolFunctionPolicy<T>>;
+
+	protected:
+		// The std::function policy has no create hook unless it is given one, so only a derived pool may leave it out
+		explicit DynamicPoolFast(Policy policy) noexcept requires IsFunctionPolicy : BaseType(DynamicPoolFastPolicy<T, Policy>(std::move(policy))) { }
+
 	public:
 		using OnCreate = std::function<T()>;
 		using OnDestroy = std::function<void(T&)>;
 		using OnReturn = std::function<void(T&)>;
 		using OnRecycle = std::function<void(T&)>;
-	private:
-		std::size_t m_counter;
-		OnCreate m_onCreate;
-		OnDestroy m_onDestroy;
-		OnReturn m_onReturn;
-		OnRecycle m_onRecycle;
 
-	public:
+		explicit DynamicPoolFast(Policy policy = { }) noexcept requires(!IsFunctionPolicy) : BaseType(DynamicPoolFastPolicy<T, Policy>(std::move(policy))) { }
 		DynamicPoolFast(OnCreate onCreate,
 						OnDestroy onDestroy = nullptr,
 						OnReturn onReturn = nullptr,
-						OnRecycle onRecycle = nullptr) : m_counter(0),
-														m_onCreate(onCreate),
-														m_onDestroy(onDestroy),
-														m_onReturn(onReturn),
-														m_onRecycle(onRecycle)
+						OnRecycle onRecycle = nullptr) noexcept requires IsFunctionPolicy : 
+														DynamicPoolFast(Policy(std::move(onCreate), std::move(onDestroy), std::move(onReturn), std::move(onRecycle)))
 		{
-			DynamicPool<DynamicPoolFastElement<T>>::setOnCreate([this]()
-			{
-				// NOTE: we can't do std::move(m_onCreate()) as move on temporary objects prevents copy elision
-				return com::DynamicPoolFastElement<T> { m_onCreate(), m_counter++ };
-			});
-			DynamicPool<DynamicPoolFastElement<T>>::setOnDestroy([this](DynamicPoolFastElement<T>& el)
-			{
-				if(m_onDestroy)
-					m_onDestroy(el.getValue());
-			});
-			DynamicPool<DynamicPoolFastElement<T>>::setOnReturn([this](DynamicPoolFastElement<T>& el)
-			{
-				if(m_onReturn)
-					m_onReturn(el.getValue());
-			});
-			DynamicPool<DynamicPoolFastElement<T>>::setOnRecycle([this](DynamicPoolFastElement<T>& el)
-			{
-				if(m_onRecycle)
-					m_onRecycle(el.getValue());
-			});
+
 		}
 
+		// DynamicPool's put(Handle)
+		using BaseType::put;
+
 		// Constant time complexity
 		void put(DynamicPoolFastElement<T> el)
 		{
-			DynamicPool<DynamicPoolFastElement<T>>::put_(std::move(el), [this](const DynamicPoolFastElement<T>& el)
+			if(!BaseType::isSlotActive(static_cast<u32>(el.getIndex())))
+			{
+				com_debug_log_error("No such value ever gotten from the pool, but you're still trying to return/put back into it");
+				return;
+			}
+			BaseType::put_(std::move(el), [this](const DynamicPoolFastElement<T>& el)
 				{
-					return std::next(DynamicPool<DynamicPoolFastElement<T>>::getStorage().begin(), el.getIndex());
+					return std::next(BaseType::getStorage().begin(), BaseType::getSlotPosition(static_cast<u32>(el.getIndex())));
 				},
 				[](DynamicPoolFastElement<T>& a, DynamicPoolFastElement<T>& b)
 				{
-					std::swap(a.m_value, b.m_value);
+					// Swap the whole elements, so that each one keeps its index (slot)
+					std::swap(a, b);
 				});
 		}
 	};
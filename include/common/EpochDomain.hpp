@@ -0,0 +1,99 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API, u32 and u64
+
+#include <atomic> // for std::atomic<>
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex
+#include <vector> // for std::vector
+
+namespace com
+{
+	// Epoch based reclamation of the objects read by lock-free readers while the writers replace them
+	// A reader enters the domain before loading a pointer to a shared object and exits it once it doesn't use the object anymore,
+	// and a writer, after replacing the object, retires the old one, which is deleted once every reader that might have loaded it has exited.
+	// Readers never wait: entering stores the current epoch in the thread's own record, and exiting clears it.
+	// Writers are serialized by a mutex, and scan the records of the reader threads to find the oldest epoch still in use.
+	// There is a single domain in the process (see global()), shared by all the lock-free structures.
+	class COMMON_API EpochDomain
+	{
+	public:
+		static constexpr std::size_t CacheLineSize = 64;
+		// Epoch of a reader which is not in the domain
+		static constexpr u64 QuiescentEpoch = 0;
+
+		// One per thread which has ever entered the domain, reused by the next thread once its thread exits
+		struct alignas(CacheLineSize) ReaderRecord
+		{
+			// Epoch at which the thread has entered the domain, QuiescentEpoch if it is not in the domain
+			std::atomic<u64> epoch { QuiescentEpoch };
+			// Number of nested enter() calls, only touched by the owning thread
+			u32 nesting = 0;
+			// Guarded by the domain's mutex
+			bool isUsed = false;
+		};
+
+		// Enters the domain on construction and exits it on destruction
+		class ReadScope
+		{
+		private:
+			EpochDomain& m_domain;
+		public:
+			ReadScope(EpochDomain& domain) noexcept : m_domain(domain) { m_domain.enter(); }
+			ReadScope(const ReadScope&) = delete;
+			ReadScope& operator=(const ReadScope&) = delete;
+			~ReadScope() noexcept { m_domain.exit(); }
+		};
+
+	private:
+		struct RetiredObject
+		{
+			// Epoch at which the object has been retired, the readers which have entered at this epoch or earlier might still use it
+			u64 epoch;
+			void* object;
+			void (*deleter)(void* object);
+		};
+
+		// Starts at 1, as 0 is QuiescentEpoch
+		std::atomic<u64> m_epoch;
+		std::mutex m_mutex;
+		std::vector<std::unique_ptr<ReaderRecord>> m_records;
+		std::vector<RetiredObject> m_retiredObjects;
+
+		EpochDomain();
+
+		ReaderRecord* getThreadRecord();
+		// Oldest epoch at which a reader in the domain has entered, the maximum u64 if there is none, m_mutex must be locked
+		u64 getOldestEpoch() const noexcept;
+		// Moves the objects nobody can use anymore out of m_retiredObjects into 'outObjects', m_mutex must be locked
+		void collect(std::vector<RetiredObject>& outObjects) noexcept;
+		static void destroy(std::vector<RetiredObject>& objects) noexcept;
+
+	public:
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+		// Deletes the retired objects
+		// NOTE: the threads which have entered the domain must have exited before the program exits
+		~EpochDomain() noexcept;
+
+		static EpochDomain& global();
+
+		// May be nested, only the outermost pair of enter() and exit() has an effect
+		void enter() noexcept;
+		void exit() noexcept;
+
+		// Deletes 'object' with 'deleter' once no reader can use it anymore (maybe right away)
+		// NOTE: the object must already be unreachable for the readers entering from now on (the pointer to it has been replaced)
+		void retire(void* object, void (*deleter)(void* object));
+		template<typename T>
+		void retire(T* object) { retire(object, [](void* ptr) { delete static_cast<T*>(ptr); }); }
+
+		// Deletes the retired objects nobody can use anymore, returns their number
+		std::size_t reclaim();
+		// Waits until every reader which has entered the domain before this call has exited, and then deletes the retired objects
+		// NOTE: must not be called between enter() and exit(), it would wait for itself
+		void synchronize();
+
+		std::size_t getRetiredCount() noexcept;
+	};
+}
@@ -3,10 +3,12 @@
 #include <common/id_generator.h> // for generating unique ids for each subscription
 #include <common/debug.h> // for debug_log_error
 #include <common/assert.h> // for _com_assert
-#include <common/defines.hpp> // for com::KeyIteratable
+#include <common/defines.hpp> // for com::no_publish_ptr_t
+#include <common/Delegate.hpp> // for com::Delegate
 
-#include <functional> // for std::function
 #include <unordered_map> // for std::unordered_map
+#include <vector> // for std::vector
+#include <limits> // for std::numeric_limits
 #include <type_traits> // for std::is_same_v
 
 namespace com
@@ -15,8 +17,8 @@ namespace com
 	struct EventHandlerProto
 	{
 		using type = typename std::conditional<std::is_same<PublisherType, no_publish_ptr_t>::value, 
-							std::function<void(Args...)>,
-							std::function<void(PublisherType*, Args...)>
+							Delegate<void(Args...)>,
+							Delegate<void(PublisherType*, Args...)>
 							>::type;
 	};
 
@@ -40,27 +42,108 @@ namespace com
 		typedef typename EventHandlerProto<PublisherType, Args...>::type EventHandler;
 		static constexpr id_generator_id_type_t InvalidSubscriptionID = ID_GENERATOR_ID_TYPE_MAX;
 	private:
+		// Subscribed while the event is being published, see m_subscribeRequests
+		struct SubscribeRequest
+		{
+			SubscriptionID id;
+			EventHandler handler;
+			bool isActive;
+		};
+
+		static constexpr std::size_t InvalidHandlerIndex = std::numeric_limits<std::size_t>::max();
+
 		id_generator_t m_id_generator;
 		PublisherTypePtr m_publisher;
-		std::unordered_map<SubscriptionID, std::pair<EventHandler, bool>> m_handlers;
+		// The handlers are packed in no particular order, so publish() is a linear sweep over them
+		// Removal moves the last handler into the place of the removed one
+		std::vector<EventHandler> m_handlers;
+		// Subscription id of the handler at each index of m_handlers
+		std::vector<SubscriptionID> m_handlerIDs;
+		// Whether the handler at each index of m_handlers is active
+		std::vector<bool> m_activeFlags;
+		// Index of each subscription's handler in m_handlers, not needed by publish()
+		std::unordered_map<SubscriptionID, std::size_t> m_handlerIndices;
+		// A subscription made while publishing is added once publish() returns,
+		// adding it right away might relocate the handler being invoked
+		std::vector<SubscribeRequest> m_subscribeRequests;
 		std::vector<SubscriptionID> m_unsubscribeRequests;
 		bool m_isPublishing;
 
-		typename std::unordered_map<SubscriptionID, std::pair<EventHandler, bool>>::iterator
-	 	getHandlerIt(SubscriptionID id)
+		std::size_t getHandlerIndex(SubscriptionID id) const noexcept
 		{
 			_com_assert(id != InvalidSubscriptionID);
-			auto it = m_handlers.find(id);
-			if(it == m_handlers.end())
-				com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
-			return it;
+			auto it = m_handlerIndices.find(id);
+			return (it == m_handlerIndices.end()) ? InvalidHandlerIndex : it->second;
+		}
+
+		void setActive(SubscriptionID id, bool isActive) noexcept
+		{
+			std::size_t index = getHandlerIndex(id);
+			if(index != InvalidHandlerIndex)
+			{
+				m_activeFlags[index] = isActive;
+				return;
+			}
+			for(auto& request : m_subscribeRequests)
+			{
+				if(request.id == id)
+				{
+					request.isActive = isActive;
+					return;
+				}
+			}
+			com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
+		}
+
+		void subscribeImmediately(SubscriptionID id, EventHandler handler, bool isActive)
+		{
+			m_handlerIndices.insert({ id, m_handlers.size() });
+			m_handlers.push_back(std::move(handler));
+			m_handlerIDs.push_back(id);
+			m_activeFlags.push_back(isActive);
 		}
 
 		void unsubscribeImmediately(SubscriptionID id)
 		{
-			_com_assert(id != InvalidSubscriptionID);
-			auto it = getHandlerIt(id);
-			m_handlers.erase(it);
+			std::size_t index = getHandlerIndex(id);
+			if(index == InvalidHandlerIndex)
+			{
+				com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
+				return;
+			}
+			std::size_t lastIndex = m_handlers.size() - 1;
+			if(index != lastIndex)
+			{
+				m_handlers[index] = std::move(m_handlers[lastIndex]);
+				m_handlerIDs[index] = m_handlerIDs[lastIndex];
+				m_activeFlags[index] = m_activeFlags[lastIndex];
+				m_handlerIndices[m_handlerIDs[index]] = index;
+			}
+			m_handlers.pop_back();
+			m_handlerIDs.pop_back();
+			m_activeFlags.pop_back();
+			m_handlerIndices.erase(id);
+		}
+
+		// Applies the requests made while publishing
+		void endPublish(bool wasPublishing)
+		{
+			m_isPublishing = wasPublishing;
+			// Still inside another publish() of this event (a handler has published it again)
+			if(wasPublishing)
+				return;
+			if(m_subscribeRequests.size() > 0)
+			{
+				for(auto& request : m_subscribeRequests)
+					subscribeImmediately(request.id, std::move(request.handler), request.isActive);
+				m_subscribeRequests.clear();
+			}
+			if(m_unsubscribeRequests.size() > 0)
+			{
+				for(auto id : m_unsubscribeRequests)
+					unsubscribeImmediately(id);
+				m_unsubscribeRequests.clear();
+			}
 		}
 
 	public:
@@ -78,6 +161,10 @@ namespace com
 		requires(std::is_same_v<T, no_publish_ptr_t>)
 		Event(Event&& event) noexcept : m_id_generator(event.m_id_generator),
 										m_handlers(std::move(event.m_handlers)),
+										m_handlerIDs(std::move(event.m_handlerIDs)),
+										m_activeFlags(std::move(event.m_activeFlags)),
+										m_handlerIndices(std::move(event.m_handlerIndices)),
+										m_subscribeRequests(std::move(event.m_subscribeRequests)),
 										m_unsubscribeRequests(std::move(event.m_unsubscribeRequests)),
 										m_isPublishing(event.m_isPublishing)
 		{
@@ -89,6 +176,10 @@ namespace com
 		Event(Event&& event) noexcept : m_id_generator(event.m_id_generator),
 										m_publisher(event.m_publisher), 
 										m_handlers(std::move(event.m_handlers)),
+										m_handlerIDs(std::move(event.m_handlerIDs)),
+										m_activeFlags(std::move(event.m_activeFlags)),
+										m_handlerIndices(std::move(event.m_handlerIndices)),
+										m_subscribeRequests(std::move(event.m_subscribeRequests)),
 										m_unsubscribeRequests(std::move(event.m_unsubscribeRequests)),
 										m_isPublishing(event.m_isPublishing)
 		{
@@ -104,7 +195,7 @@ namespace com
 		// Description: Returns the number of subscriptions to this event
 		// Params: None
 		// Returns: an integer (unsigned)
-		COM_NO_DISCARD auto size() const noexcept { return m_handlers.size(); }
+		COM_NO_DISCARD auto size() const noexcept { return m_handlers.size() + m_subscribeRequests.size(); }
 
 		template<typename T = PublisherType>
 		requires(!std::is_same_v<T, no_publish_ptr_t>)
@@ -118,12 +209,12 @@ namespace com
 		SubscriptionID subscribe(F&& f) noexcept
 		{
 			auto id = id_generator_get(&m_id_generator);
-
-			auto wrapper = [func = std::forward<F>(f)](auto&&... callArgs) mutable {
-				func(std::forward<decltype(callArgs)>(callArgs)...); // perfect-forward
-        	};
-
-			m_handlers.insert({ id, { std::move(wrapper), true } });
+			// The callable is stored as it is in the delegate, which forwards the arguments to it
+			EventHandler handler(std::forward<F>(f));
+			if(m_isPublishing)
+				m_subscribeRequests.push_back({ id, std::move(handler), true });
+			else
+				subscribeImmediately(id, std::move(handler), true);
 			return id;
 		}
 
@@ -131,14 +222,18 @@ namespace com
 		{
 			if(m_isPublishing)
 			{
-				com::KeyIteratable ids(m_handlers);
-				for(auto& id : ids)
+				for(auto id : m_handlerIDs)
 					unsubscribe(id);
+				for(auto& request : m_subscribeRequests)
+					unsubscribe(request.id);
 			}
 			else
 			{
 				id_generator_reset(&m_id_generator, 0);
 				m_handlers.clear();
+				m_handlerIDs.clear();
+				m_activeFlags.clear();
+				m_handlerIndices.clear();
 			}
 		}
 
@@ -154,14 +249,12 @@ namespace com
 
 		void deactivate(SubscriptionID id) noexcept
 		{
-			auto it = getHandlerIt(id);
-			it->second.second = false;
+			setActive(id, false);
 		}
 
 		void activate(SubscriptionID id) noexcept
 		{
-			auto it = getHandlerIt(id);
-			it->second.second = true;
+			setActive(id, true);
 		}
 
 		template<typename... CallArgs>
@@ -169,20 +262,16 @@ namespace com
 		{
 			static_assert(args_checker<Args...>::template check<CallArgs...>(),
                       "publish() arguments count or types do not match handler arguments");
+			bool wasPublishing = m_isPublishing;
 			m_isPublishing = true;
-			for(auto& pair : m_handlers)
+			// The handlers subscribed meanwhile are added after the loop, so m_handlers doesn't change
+			for(std::size_t i = 0, count = m_handlers.size(); i < count; ++i)
 			{
 				// only invoke this handler if it is active
-				if(pair.second.second)
-					pair.second.first(m_publisher, std::forward<CallArgs>(args)...);
-			}
-			m_isPublishing = false;
-			if(m_unsubscribeRequests.size() > 0)
-			{
-				for(auto id : m_unsubscribeRequests)
-					unsubscribeImmediately(id);
-				m_unsubscribeRequests.clear();
+				if(m_activeFlags[i])
+					m_handlers[i](m_publisher, std::forward<CallArgs>(args)...);
 			}
+			endPublish(wasPublishing);
 		}
 
 		template<typename... CallArgs>
@@ -190,21 +279,17 @@ namespace com
 		{
 			static_assert(args_checker<Args...>::template check<CallArgs...>(),
                       "publish() arguments count or types do not match handler arguments");
+			bool wasPublishing = m_isPublishing;
 			m_isPublishing = true;
-			for(auto& pair : m_handlers)
+			// The handlers subscribed meanwhile are added after the loop, so m_handlers doesn't change
+			for(std::size_t i = 0, count = m_handlers.size(); i < count; ++i)
 			{
 				// only invoke this handler if it is active
-				if(pair.second.second)
-					pair.second.first(std::forward<CallArgs>(args)...);
-			}
-			m_isPublishing = false;
-			if(m_unsubscribeRequests.size() > 0)
-			{
-				for(auto id : m_unsubscribeRequests)
-					unsubscribeImmediately(id);
-				m_unsubscribeRequests.clear();
+				if(m_activeFlags[i])
+					m_handlers[i](std::forward<CallArgs>(args)...);
 			}
+			endPublish(wasPublishing);
 		}
 	};
 
-}
\ No newline at end of file
+}
\ No newline at end of file
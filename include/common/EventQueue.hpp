@@ -0,0 +1,413 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API, u32, u64 and com::no_publish_ptr_t
+#include <common/assert.h> // for _com_assert
+#include <common/debug.h> // for com_debug_log_error
+#include <common/Event.hpp> // for com::Event
+#include <common/MPMCRingBuffer.hpp> // for com::MPMCRingBuffer
+#include <common/ThreadNaming.hpp> // for com::SetThreadName()
+
+#include <algorithm> // for std::min
+#include <atomic> // for std::atomic<>
+#include <concepts> // for std::equality_comparable
+#include <string> // for std::string
+#include <thread> // for std::thread
+#include <tuple> // for std::tuple and std::apply
+#include <type_traits> // for std::decay_t
+#include <utility> // for std::move, std::forward and std::in_place
+#include <vector> // for std::vector
+
+namespace com
+{
+	enum class EventQueueCoalescing
+	{
+		// Every enqueued event is published
+		None,
+		// Events with equal arguments are published once per frame (in the order of their first occurrence)
+		Duplicates,
+		// Only the last event of a frame is published, for the events carrying a state (a size, a position) rather than a change
+		Latest
+	};
+
+	struct EventQueueConfig
+	{
+		// Capacity of the lock-free buffer, rounded up to a power of 2
+		std::size_t capacity = 1024;
+		// Maximum number of events taken out of the buffer at once, when the events are not coalesced
+		std::size_t batchSize = 64;
+		EventQueueCoalescing coalescing = EventQueueCoalescing::None;
+	};
+
+	struct EventQueueStats
+	{
+		// Number of events accepted by enqueue() and tryEnqueue()
+		u64 enqueuedCount;
+		// Number of events rejected by tryEnqueue() because the buffer was full
+		u64 droppedCount;
+		// Number of events the handlers have been invoked for
+		u64 dispatchedCount;
+		// Number of events taken out of the buffer but not published as they have been coalesced with another one
+		u64 coalescedCount;
+		// Number of events waiting in the buffer (approximate while the other threads are enqueuing or dispatching)
+		std::size_t depth;
+		// Highest depth seen by enqueue() and tryEnqueue(), the events being taken out of the buffer are counted until the whole batch is taken,
+		// so it may exceed the capacity by a batch
+		std::size_t maxDepth;
+	};
+
+	// Deferred com::Event: publishers on any thread enqueue the arguments of an event into a lock-free buffer (com::MPMCRingBuffer),
+	// and the handlers are invoked later on the thread calling dispatch(), or on the dispatcher thread launched by start(),
+	// so a slow handler doesn't stall the publishers.
+	// dispatch() publishes a frame: the events enqueued before it has been called, those enqueued meanwhile (even by the handlers) are left for the next one.
+	// NOTE: the subscriptions are not thread safe, subscribe() and unsubscribe() must be called on the dispatching thread (the handlers may call them),
+	// or while there is no dispatcher thread
+	template<typename PublisherType, typename... Args>
+	class COMMON_API EventQueue
+	{
+	public:
+		typedef Event<PublisherType, Args...> EventType;
+		typedef typename EventType::SubscriptionID SubscriptionID;
+		typedef typename EventType::EventHandler EventHandler;
+		// The arguments are copied (or moved) into the buffer, so the references are stored as values
+		typedef std::tuple<std::decay_t<Args>...> ArgsTuple;
+		static constexpr std::size_t CacheLineSize = MPMCRingBuffer<ArgsTuple>::CacheLineSize;
+
+	private:
+		EventType m_event;
+		MPMCRingBuffer<ArgsTuple> m_buffer;
+		EventQueueConfig m_config;
+		// Events taken out of the buffer and not yet published, only touched by the dispatching thread
+		std::vector<ArgsTuple> m_batch;
+		// Written by the publishers
+		alignas(CacheLineSize) std::atomic<u64> m_enqueuedCount;
+		std::atomic<u64> m_droppedCount;
+		std::atomic<std::size_t> m_maxDepth;
+		// Written by the dispatching thread, dequeued = dispatched + coalesced
+		alignas(CacheLineSize) std::atomic<u64> m_dequeuedCount;
+		std::atomic<u64> m_dispatchedCount;
+		std::atomic<u64> m_coalescedCount;
+		// The dispatcher thread parks on m_signal when the buffer is empty, the publishers bump it only if m_isDispatcherParked is true,
+		// so enqueuing doesn't enter the kernel while the dispatcher is busy
+		alignas(CacheLineSize) std::atomic<u32> m_signal;
+		std::atomic<bool> m_isDispatcherParked;
+		std::atomic<bool> m_isRunning;
+		std::thread m_dispatcher;
+
+		void onEnqueued() noexcept;
+		void wakeDispatcher() noexcept;
+		void publish(ArgsTuple& args) noexcept;
+		// Takes up to 'count' events out of the buffer into m_batch, returns the number of events taken
+		std::size_t takeBatch(std::size_t count) noexcept;
+		// Drops the events of m_batch which are coalesced with another one
+		void coalesceBatch() noexcept;
+		std::size_t dispatchFrame() noexcept;
+		void runDispatcher(std::string name) noexcept;
+		// Shared by the public constructors, 'eventArgs' (nothing or the publisher) are passed to the constructor of m_event
+		template<typename... EventArgs>
+		EventQueue(std::in_place_t, const EventQueueConfig& config, EventArgs... eventArgs);
+
+	public:
+		template<typename T = PublisherType>
+		requires(std::is_same_v<T, no_publish_ptr_t>)
+		EventQueue(const EventQueueConfig& config = { });
+		template<typename T = PublisherType>
+		requires(!std::is_same_v<T, no_publish_ptr_t>)
+		EventQueue(T* publisher, const EventQueueConfig& config = { });
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+		// Stops the dispatcher thread, the events still in the buffer are not published
+		~EventQueue() noexcept;
+
+		// Same as of com::Event, see the NOTE above about the threads these can be called on
+		template<typename F>
+		SubscriptionID subscribe(F&& f) noexcept { return m_event.subscribe(std::forward<F>(f)); }
+		void unsubscribe(SubscriptionID id) noexcept { m_event.unsubscribe(id); }
+		void activate(SubscriptionID id) noexcept { m_event.activate(id); }
+		void deactivate(SubscriptionID id) noexcept { m_event.deactivate(id); }
+		EventType& getEvent() noexcept { return m_event; }
+		const EventQueueConfig& getConfig() const noexcept { return m_config; }
+
+		// Can be called on any thread, blocks while the buffer is full
+		template<typename... CallArgs>
+		void enqueue(CallArgs&&... args) noexcept;
+		// Can be called on any thread, returns false (and the event is dropped) if the buffer is full
+		template<typename... CallArgs>
+		bool tryEnqueue(CallArgs&&... args) noexcept;
+
+		// Publishes the events enqueued so far, returns the number of events the handlers have been invoked for
+		// NOTE: must not be called while the dispatcher thread is running
+		std::size_t dispatch() noexcept;
+
+		// Launches the dispatcher thread, which dispatches the frames one after another as long as there are events, and parks in between
+		void start(const std::string& threadName = "event-queue");
+		// Joins the dispatcher thread, the events enqueued after its last frame stay in the buffer (dispatch() may be called for them)
+		void stop() noexcept;
+		bool isRunning() const noexcept { return m_isRunning.load(std::memory_order_acquire); }
+
+		// Approximate while the other threads are enqueuing or dispatching
+		std::size_t depth() const noexcept;
+		EventQueueStats getStats() const noexcept;
+	};
+
+	template<typename PublisherType, typename... Args>
+	template<typename... EventArgs>
+	EventQueue<PublisherType, Args...>::EventQueue(std::in_place_t, const EventQueueConfig& config, EventArgs... eventArgs) : m_event(eventArgs...),
+																															m_buffer(config.capacity),
+																															m_config(config),
+																															m_enqueuedCount(0),
+																															m_droppedCount(0),
+																															m_maxDepth(0),
+																															m_dequeuedCount(0),
+																															m_dispatchedCount(0),
+																															m_coalescedCount(0),
+																															m_signal(0),
+																															m_isDispatcherParked(false),
+																															m_isRunning(false)
+	{
+		_com_assert(config.batchSize > 0);
+		if constexpr(!std::equality_comparable<ArgsTuple>)
+		{
+			if(config.coalescing == EventQueueCoalescing::Duplicates)
+			{
+				com_debug_log_error("The arguments are not equality comparable, the duplicates will not be coalesced");
+			}
+		}
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename T>
+	requires(std::is_same_v<T, no_publish_ptr_t>)
+	EventQueue<PublisherType, Args...>::EventQueue(const EventQueueConfig& config) : EventQueue(std::in_place, config)
+	{
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename T>
+	requires(!std::is_same_v<T, no_publish_ptr_t>)
+	EventQueue<PublisherType, Args...>::EventQueue(T* publisher, const EventQueueConfig& config) : EventQueue(std::in_place, config, publisher)
+	{
+	}
+
+	template<typename PublisherType, typename... Args>
+	EventQueue<PublisherType, Args...>::~EventQueue() noexcept
+	{
+		stop();
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::onEnqueued() noexcept
+	{
+		// seq_cst, so either this thread sees the dispatcher parked, or the dispatcher sees this event before parking
+		u64 enqueuedCount = m_enqueuedCount.fetch_add(1, std::memory_order_seq_cst) + 1;
+		u64 dequeuedCount = m_dequeuedCount.load(std::memory_order_relaxed);
+		std::size_t depth = (enqueuedCount > dequeuedCount) ? static_cast<std::size_t>(enqueuedCount - dequeuedCount) : 0;
+		std::size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+		while((depth > maxDepth) && !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed));
+		if(m_isDispatcherParked.load(std::memory_order_seq_cst))
+			wakeDispatcher();
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::wakeDispatcher() noexcept
+	{
+		m_signal.fetch_add(1, std::memory_order_release);
+		m_signal.notify_one();
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename... CallArgs>
+	void EventQueue<PublisherType, Args...>::enqueue(CallArgs&&... args) noexcept
+	{
+		static_assert(args_checker<Args...>::template check<CallArgs...>(),
+					"enqueue() arguments count or types do not match handler arguments");
+		m_buffer.push(ArgsTuple(std::forward<CallArgs>(args)...));
+		onEnqueued();
+	}
+
+	template<typename PublisherType, typename... Args>
+	template<typename... CallArgs>
+	bool EventQueue<PublisherType, Args...>::tryEnqueue(CallArgs&&... args) noexcept
+	{
+		static_assert(args_checker<Args...>::template check<CallArgs...>(),
+					"tryEnqueue() arguments count or types do not match handler arguments");
+		if(!m_buffer.tryPush(ArgsTuple(std::forward<CallArgs>(args)...)))
+		{
+			m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		onEnqueued();
+		return true;
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::publish(ArgsTuple& args) noexcept
+	{
+		std::apply([this](auto&... values) { m_event.publish(values...); }, args);
+	}
+
+	template<typename PublisherType, typename... Args>
+	std::size_t EventQueue<PublisherType, Args...>::takeBatch(std::size_t count) noexcept
+	{
+		std::size_t takenCount = 0;
+		// Moved straight from the buffer into m_batch, so the arguments don't need to be default constructible
+		for(; takenCount < count; ++takenCount)
+			if(!m_buffer.tryConsume([this](ArgsTuple&& args) { m_batch.push_back(std::move(args)); }))
+				break;
+		return takenCount;
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::coalesceBatch() noexcept
+	{
+		std::size_t count = m_batch.size();
+		if(count < 2)
+			return;
+		switch(m_config.coalescing)
+		{
+			case EventQueueCoalescing::Latest:
+			{
+				m_batch.erase(m_batch.begin(), m_batch.end() - 1);
+				break;
+			}
+			case EventQueueCoalescing::Duplicates:
+			{
+				if constexpr(std::equality_comparable<ArgsTuple>)
+				{
+					// Linear in the number of distinct events of the frame, the coalesced events are expected to be a handful of distinct ones
+					auto uniqueEnd = m_batch.begin() + 1;
+					for(auto it = uniqueEnd; it != m_batch.end(); ++it)
+					{
+						bool isDuplicate = false;
+						for(auto uniqueIt = m_batch.begin(); uniqueIt != uniqueEnd; ++uniqueIt)
+						{
+							if(*uniqueIt == *it)
+							{
+								isDuplicate = true;
+								break;
+							}
+						}
+						if(!isDuplicate)
+						{
+							if(uniqueEnd != it)
+								*uniqueEnd = std::move(*it);
+							++uniqueEnd;
+						}
+					}
+					m_batch.erase(uniqueEnd, m_batch.end());
+				}
+				break;
+			}
+			case EventQueueCoalescing::None:
+				break;
+		}
+		m_coalescedCount.fetch_add(count - m_batch.size(), std::memory_order_relaxed);
+	}
+
+	template<typename PublisherType, typename... Args>
+	std::size_t EventQueue<PublisherType, Args...>::dispatchFrame() noexcept
+	{
+		// The frame ends at the events enqueued so far, so a handler enqueuing an event can't keep the frame going forever
+		std::size_t frameCount = depth();
+		std::size_t dispatchedCount = 0;
+		if(m_config.coalescing == EventQueueCoalescing::None)
+		{
+			while(frameCount > 0)
+			{
+				std::size_t takenCount = takeBatch(std::min(frameCount, m_config.batchSize));
+				if(takenCount == 0)
+					break;
+				frameCount -= takenCount;
+				m_dequeuedCount.fetch_add(takenCount, std::memory_order_relaxed);
+				for(auto& args : m_batch)
+					publish(args);
+				m_batch.clear();
+				dispatchedCount += takenCount;
+			}
+		}
+		else
+		{
+			// The whole frame is taken out before publishing any of it, as the duplicates may be anywhere in it
+			std::size_t takenCount = takeBatch(frameCount);
+			if(takenCount == 0)
+				return 0;
+			m_dequeuedCount.fetch_add(takenCount, std::memory_order_relaxed);
+			coalesceBatch();
+			for(auto& args : m_batch)
+				publish(args);
+			dispatchedCount = m_batch.size();
+			m_batch.clear();
+		}
+		m_dispatchedCount.fetch_add(dispatchedCount, std::memory_order_relaxed);
+		return dispatchedCount;
+	}
+
+	template<typename PublisherType, typename... Args>
+	std::size_t EventQueue<PublisherType, Args...>::dispatch() noexcept
+	{
+		if(isRunning())
+		{
+			com_debug_log_error("dispatch() is called while the dispatcher thread is running, call stop() first");
+			return 0;
+		}
+		return dispatchFrame();
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::runDispatcher(std::string name) noexcept
+	{
+		SetThreadName(name);
+		while(m_isRunning.load(std::memory_order_acquire))
+		{
+			if(dispatchFrame() > 0)
+				continue;
+			u32 signal = m_signal.load(std::memory_order_acquire);
+			m_isDispatcherParked.store(true, std::memory_order_seq_cst);
+			// An event enqueued before the store above is seen here, and the publishers of the later ones bump the signal
+			if((m_enqueuedCount.load(std::memory_order_seq_cst) == m_dequeuedCount.load(std::memory_order_relaxed))
+				&& m_isRunning.load(std::memory_order_acquire))
+				m_signal.wait(signal, std::memory_order_acquire);
+			m_isDispatcherParked.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::start(const std::string& threadName)
+	{
+		_com_assert(!isRunning());
+		m_isRunning.store(true, std::memory_order_release);
+		m_dispatcher = std::thread(&EventQueue::runDispatcher, this, threadName);
+	}
+
+	template<typename PublisherType, typename... Args>
+	void EventQueue<PublisherType, Args...>::stop() noexcept
+	{
+		if(!m_dispatcher.joinable())
+			return;
+		m_isRunning.store(false, std::memory_order_seq_cst);
+		wakeDispatcher();
+		m_dispatcher.join();
+	}
+
+	template<typename PublisherType, typename... Args>
+	std::size_t EventQueue<PublisherType, Args...>::depth() const noexcept
+	{
+		// Loading the dequeued count first, so it can't be ahead of the enqueued count read after it
+		u64 dequeuedCount = m_dequeuedCount.load(std::memory_order_acquire);
+		u64 enqueuedCount = m_enqueuedCount.load(std::memory_order_acquire);
+		return (enqueuedCount > dequeuedCount) ? static_cast<std::size_t>(enqueuedCount - dequeuedCount) : 0;
+	}
+
+	template<typename PublisherType, typename... Args>
+	EventQueueStats EventQueue<PublisherType, Args...>::getStats() const noexcept
+	{
+		return
+		{
+			.enqueuedCount = m_enqueuedCount.load(std::memory_order_relaxed),
+			.droppedCount = m_droppedCount.load(std::memory_order_relaxed),
+			.dispatchedCount = m_dispatchedCount.load(std::memory_order_relaxed),
+			.coalescedCount = m_coalescedCount.load(std::memory_order_relaxed),
+			.depth = depth(),
+			.maxDepth = m_maxDepth.load(std::memory_order_relaxed)
+		};
+	}
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <common/defines.hpp>
+#include <common/hash_table.h> // for hash_table_t
+#include <common/hash_function.h> // for hash_t
+
+#include <functional> // for std::equal_to and std::hash
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <iterator> // for std::forward_iterator_tag
+#include <utility> // for std::pair
+#include <cstddef> // for std::ptrdiff_t
+#include <cstdint> // for std::uintptr_t
+
+namespace com
+{
+	// Default hash functor of com::HashTable and com::Dictionary
+	// For the integers, enums and pointers it computes the same as u64_mix() but it can be inlined, and for the rest it uses std::hash
+	template<typename K>
+	struct Hash
+	{
+		static constexpr hash_t mix(u64 value) noexcept
+		{
+			value ^= value >> 27;
+			value *= 0x3C79AC492BA7B653ULL;
+			value ^= value >> 33;
+			value *= 0x1C69B3F74AC4AE35ULL;
+			value ^= value >> 27;
+			return value;
+		}
+
+		hash_t operator()(const K& key) const noexcept
+		{
+			if constexpr (std::is_integral_v<K> || std::is_enum_v<K>)
+				return mix(static_cast<u64>(key));
+			else if constexpr (std::is_pointer_v<K>)
+				return mix(static_cast<u64>(reinterpret_cast<std::uintptr_t>(key)));
+			else
+				return static_cast<hash_t>(std::hash<K> { } (key));
+		}
+	};
+
+	// Typed wrapper over the flat hash_table_t (HASH_TABLE_STORAGE_FLAT)
+	// The lookups and the iteration are done inline with HashT and EqT, so they don't call hash_function_t and comparer_t through function pointers for each probe
+	// The additions and removals still go through the C API, which calls HashT and EqT through the function pointers (see getHashThunk and isEqualThunk)
+	// NOTE: the pointers to the values are invalidated when the hash table grows
+	template<typename K, typename V, typename HashT = Hash<K>, typename EqT = std::equal_to<K>>
+	class HashTable
+	{
+		static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "hash_table_t copies the keys and the values bytewise");
+		static_assert((alignof(K) <= 8) && (alignof(V) <= 8), "hash_table_t aligns the keys and the values to at most 8 bytes");
+		static_assert(std::is_empty_v<HashT> && std::is_empty_v<EqT>, "HashT and EqT must be stateless as the C API calls them through plain function pointers");
+	public:
+		typedef K KeyType;
+		typedef V ValueType;
+
+		template<bool IsConst>
+		class IteratorBase
+		{
+			friend class HashTable;
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef std::pair<const K&, std::conditional_t<IsConst, const V&, V&>> value_type;
+			typedef value_type reference;
+			typedef std::ptrdiff_t difference_type;
+		private:
+			const hash_table_t* m_table;
+			u32 m_index;
+
+			IteratorBase(const hash_table_t* table, u32 index) noexcept : m_table(table), m_index(index) { skipNonFull(); }
+			void skipNonFull() noexcept
+			{
+				while((m_index < m_table->flat.slot_count) && !HASH_TABLE_FLAT_CTRL_IS_FULL(m_table->flat.ctrl[m_index]))
+					++m_index;
+			}
+		public:
+			reference operator*() const noexcept
+			{
+				u8* slot = m_table->flat.slots + static_cast<u64>(m_index) * m_table->flat.stride;
+				return { *reinterpret_cast<const K*>(slot), *reinterpret_cast<V*>(slot + m_table->value_offset) };
+			}
+			IteratorBase& operator++() noexcept
+			{
+				++m_index;
+				skipNonFull();
+				return *this;
+			}
+			IteratorBase operator++(int) noexcept
+			{
+				IteratorBase it = *this;
+				++(*this);
+				return it;
+			}
+			bool operator==(const IteratorBase& it) const noexcept { return m_index == it.m_index; }
+			bool operator!=(const IteratorBase& it) const noexcept { return m_index != it.m_index; }
+		};
+		typedef IteratorBase<false> iterator;
+		typedef IteratorBase<true> const_iterator;
+
+	private:
+		hash_table_t m_table;
+
+		static hash_t getHashThunk(void* key) noexcept { return HashT { } (*reinterpret_cast<const K*>(key)); }
+		static bool isEqualThunk(void* lhs, void* rhs) noexcept { return EqT { } (*reinterpret_cast<const K*>(lhs), *reinterpret_cast<const K*>(rhs)); }
+
+		u8* getSlot(u32 index) const noexcept { return m_table.flat.slots + static_cast<u64>(index) * m_table.flat.stride; }
+		// Same as flat_find_index() in hash_table.c
+		u32 findIndex(const K& key) const noexcept;
+
+	public:
+		static constexpr u32 InvalidIndex = U32_MAX;
+
+		HashTable(u32 capacity = 0, com_allocation_callbacks_t* allocationCallbacks = NULL) noexcept : m_table(hash_table_create_flat(K, V, capacity, isEqualThunk, getHashThunk, allocationCallbacks)) { }
+		HashTable(HashTable&& table) noexcept;
+		HashTable(const HashTable&) = delete;
+		~HashTable() noexcept;
+
+		HashTable& operator=(HashTable&& table) noexcept;
+		HashTable& operator=(const HashTable&) = delete;
+
+		// Adds a key value pair
+		// Returns pointer to the value, or nullptr if the key already exists
+		V* add(const K& key, const V& value) noexcept { return reinterpret_cast<V*>(hash_table_add_get(&m_table, const_cast<K*>(&key), const_cast<V*>(&value))); }
+		// Returns true if the key has been removed, otherwise false (not found)
+		bool remove(const K& key) noexcept { return hash_table_remove(&m_table, const_cast<K*>(&key)); }
+		void clear() noexcept { hash_table_clear(&m_table); }
+		// Returns pointer to the value, or nullptr if the key doesn't exist
+		V* find(const K& key) noexcept
+		{
+			u32 index = findIndex(key);
+			return (index == InvalidIndex) ? nullptr : reinterpret_cast<V*>(getSlot(index) + m_table.value_offset);
+		}
+		const V* find(const K& key) const noexcept { return const_cast<HashTable*>(this)->find(key); }
+		bool contains(const K& key) const noexcept { return findIndex(key) != InvalidIndex; }
+
+		u32 size() const noexcept { return m_table.flat.count; }
+		bool empty() const noexcept { return m_table.flat.count == 0; }
+		// See hash_table_set_seed(), it can only be set while the hash table is empty
+		void setSeed(hash_t seed) noexcept { hash_table_set_seed(&m_table, seed); }
+		// For passing the underlying hash table to the C API
+		hash_table_t* getHandle() noexcept { return &m_table; }
+
+		iterator begin() noexcept { return { &m_table, 0 }; }
+		iterator end() noexcept { return { &m_table, m_table.flat.slot_count }; }
+		const_iterator begin() const noexcept { return { &m_table, 0 }; }
+		const_iterator end() const noexcept { return { &m_table, m_table.flat.slot_count }; }
+	};
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	HashTable<K, V, HashT, EqT>::HashTable(HashTable&& table) noexcept : m_table(table.m_table)
+	{
+		// the moved-from hash table can only be destroyed or assigned to
+		table.m_table.flat.slots = NULL;
+		table.m_table.flat.slot_count = 0;
+		table.m_table.flat.count = 0;
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	HashTable<K, V, HashT, EqT>::~HashTable() noexcept
+	{
+		if(m_table.flat.slots != NULL)
+			hash_table_free(&m_table);
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	HashTable<K, V, HashT, EqT>& HashTable<K, V, HashT, EqT>::operator=(HashTable&& table) noexcept
+	{
+		if(this == &table)
+			return *this;
+		if(m_table.flat.slots != NULL)
+			hash_table_free(&m_table);
+		m_table = table.m_table;
+		table.m_table.flat.slots = NULL;
+		table.m_table.flat.slot_count = 0;
+		table.m_table.flat.count = 0;
+		return *this;
+	}
+
+	template<typename K, typename V, typename HashT, typename EqT>
+	u32 HashTable<K, V, HashT, EqT>::findIndex(const K& key) const noexcept
+	{
+		hash_t hash;
+		// Same as get_key_hash() in hash_table.c
+		if(m_table.seed == 0)
+			hash = HashT { } (key);
+		else if(m_table.get_seeded_hash != NULL)
+			hash = m_table.get_seeded_hash(const_cast<K*>(&key), m_table.seed);
+		else
+			hash = hash_mix_seed(HashT { } (key), m_table.seed);
+		hash = hash_table_flat_mix_hash(hash);
+		const hash_table_flat_storage_t& flat = m_table.flat;
+		u32 mask = flat.slot_count - 1;
+		u8 h2 = HASH_TABLE_FLAT_H2(hash);
+		// there is always at least one empty slot, so this loop always terminates
+		for(u32 i = HASH_TABLE_FLAT_H1(hash) & mask;; i = (i + 1) & mask)
+		{
+			u8 ctrl = flat.ctrl[i];
+			if(ctrl == HASH_TABLE_FLAT_CTRL_EMPTY)
+				return InvalidIndex;
+			if((ctrl == h2) && EqT { } (*reinterpret_cast<const K*>(getSlot(i)), key))
+				return i;
+		}
+	}
+}
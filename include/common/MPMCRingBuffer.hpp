@@ -0,0 +1,306 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API etc.
+
+#include <atomic> // for std::atomic<>
+#include <memory> // for std::unique_ptr<>
+#include <new> // for placement new
+#include <thread> // for std::this_thread::yield()
+#include <utility> // for std::move and std::forward
+#include <cstddef> // for std::ptrdiff_t
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	include <immintrin.h> // for _mm_pause()
+#endif
+
+namespace com
+{
+	// Bounded lock-free multi-producer multi-consumer ring buffer (Dmitry Vyukov's bounded MPMC queue)
+	// It has the same push/pop surface as com::ProducerConsumerBuffer, but the producers and consumers only contend on
+	// two atomic positions (each on its own cache line) instead of a mutex, and each cell carries a sequence number telling
+	// whether it is ready to be written or read.
+	// The blocking push() and pop() spin for a while, then yield, and finally park on a 32 bit signal (std::atomic<>::wait(), a futex on Linux)
+	// the other side bumps the signal and wakes up one parked thread only if there is any, so the uncontended path never enters the kernel.
+	template<typename T>
+	class COMMON_API MPMCRingBuffer
+	{
+	public:
+		static constexpr std::size_t CacheLineSize = 64;
+		// Number of failed attempts spent spinning and then yielding before parking the calling thread
+		static constexpr u32 SpinCount = 64;
+		static constexpr u32 YieldCount = 16;
+
+	private:
+		struct alignas(CacheLineSize) Cell
+		{
+			// equal to the position: ready to be written, equal to the position + 1: ready to be read
+			std::atomic<std::size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T* getValue() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+		};
+
+		std::unique_ptr<Cell[]> m_cells;
+		std::size_t m_mask;
+		alignas(CacheLineSize) std::atomic<std::size_t> m_enqueuePos;
+		alignas(CacheLineSize) std::atomic<std::size_t> m_dequeuePos;
+		// Number of parked threads not yet woken up, and the signals they are parked on
+		alignas(CacheLineSize) std::atomic<u32> m_pushWaiters;
+		std::atomic<u32> m_pushSignal;
+		alignas(CacheLineSize) std::atomic<u32> m_popWaiters;
+		std::atomic<u32> m_popSignal;
+
+		static void cpuRelax() noexcept
+		{
+		#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+			_mm_pause();
+		#elif defined(__aarch64__)
+			asm volatile("yield");
+		#endif
+		}
+
+		static std::size_t getCapacity(std::size_t capacity) noexcept
+		{
+			std::size_t powerOfTwo = 2;
+			while(powerOfTwo < capacity)
+				powerOfTwo <<= 1;
+			return powerOfTwo;
+		}
+
+		bool tryClaimPush(Cell*& outCell, std::size_t& outPos) noexcept;
+		bool tryClaimPop(Cell*& outCell, std::size_t& outPos) noexcept;
+		void publishPush(Cell* cell, std::size_t pos) noexcept;
+		void publishPop(Cell* cell, std::size_t pos) noexcept;
+		// Spins, yields, and then parks on 'signal' until tryFn() returns true
+		template<typename TryFn>
+		static void waitUntil(std::atomic<u32>& signal, std::atomic<u32>& waiters, TryFn tryFn) noexcept;
+		static void wakeOne(std::atomic<u32>& signal, std::atomic<u32>& waiters) noexcept;
+
+	public:
+		// The capacity is rounded up to a power of 2
+		MPMCRingBuffer(std::size_t capacity = 1024);
+		MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+		MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+		// NOTE: no other thread may be using the buffer while it is being destroyed
+		~MPMCRingBuffer() noexcept;
+
+		std::size_t capacity() const noexcept { return m_mask + 1; }
+		// Approximate while the other threads are pushing or popping
+		bool isEmpty() const noexcept { return m_dequeuePos.load(std::memory_order_acquire) >= m_enqueuePos.load(std::memory_order_acquire); }
+
+		// Returns false if the buffer is full
+		template<typename U>
+		bool tryPush(U&& value) noexcept;
+		// Returns false if the buffer is empty
+		bool tryPop(T& outValue) noexcept;
+		// Returns false if the buffer is empty, otherwise passes the element (as an rvalue) to consume() right in the buffer,
+		// so unlike tryPop() it doesn't need a default constructed T to move the element into
+		template<typename ConsumeFn>
+		bool tryConsume(ConsumeFn&& consume) noexcept;
+
+		// Blocks while the buffer is full
+		void push(T&& value) noexcept { pushImpl(std::move(value)); }
+		void push(const T& value) noexcept { pushImpl(value); }
+		// Blocks while the buffer is empty
+		T pop() noexcept;
+
+	private:
+		template<typename U>
+		void pushImpl(U&& value) noexcept;
+	};
+
+	template<typename T>
+	MPMCRingBuffer<T>::MPMCRingBuffer(std::size_t capacity) : m_cells(new Cell[getCapacity(capacity)]),
+																m_mask(getCapacity(capacity) - 1),
+																m_enqueuePos(0),
+																m_dequeuePos(0),
+																m_pushWaiters(0),
+																m_pushSignal(0),
+																m_popWaiters(0),
+																m_popSignal(0)
+	{
+		for(std::size_t i = 0; i <= m_mask; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	MPMCRingBuffer<T>::~MPMCRingBuffer() noexcept
+	{
+		Cell* cell;
+		std::size_t pos;
+		while(tryClaimPop(cell, pos))
+			cell->getValue()->~T();
+	}
+
+	template<typename T>
+	bool MPMCRingBuffer<T>::tryClaimPush(Cell*& outCell, std::size_t& outPos) noexcept
+	{
+		std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			Cell* cell = &m_cells[pos & m_mask];
+			std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+			if(diff == 0)
+			{
+				if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					outCell = cell;
+					outPos = pos;
+					return true;
+				}
+			}
+			// the cell hasn't been read yet since the last lap, so the buffer is full
+			else if(diff < 0)
+				return false;
+			// another producer has claimed this position
+			else
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T>
+	bool MPMCRingBuffer<T>::tryClaimPop(Cell*& outCell, std::size_t& outPos) noexcept
+	{
+		std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			Cell* cell = &m_cells[pos & m_mask];
+			std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+			if(diff == 0)
+			{
+				if(m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					outCell = cell;
+					outPos = pos;
+					return true;
+				}
+			}
+			// the cell hasn't been written yet, so the buffer is empty
+			else if(diff < 0)
+				return false;
+			else
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T>
+	void MPMCRingBuffer<T>::publishPush(Cell* cell, std::size_t pos) noexcept
+	{
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		wakeOne(m_popSignal, m_popWaiters);
+	}
+
+	template<typename T>
+	void MPMCRingBuffer<T>::publishPop(Cell* cell, std::size_t pos) noexcept
+	{
+		// ready to be written in the next lap
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		wakeOne(m_pushSignal, m_pushWaiters);
+	}
+
+	template<typename T>
+	void MPMCRingBuffer<T>::wakeOne(std::atomic<u32>& signal, std::atomic<u32>& waiters) noexcept
+	{
+		// pairs with the fence in waitUntil(), either the parked thread sees the cell just published or this sees the parked thread
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		// each published cell can satisfy only one parked thread, so one of them is taken off the count and woken up,
+		// that way the cells published before it gets to run don't make a syscall each
+		u32 count = waiters.load(std::memory_order_relaxed);
+		while((count != 0) && !waiters.compare_exchange_weak(count, count - 1, std::memory_order_relaxed));
+		if(count == 0)
+			return;
+		signal.fetch_add(1, std::memory_order_relaxed);
+		signal.notify_one();
+	}
+
+	template<typename T>
+	template<typename TryFn>
+	void MPMCRingBuffer<T>::waitUntil(std::atomic<u32>& signal, std::atomic<u32>& waiters, TryFn tryFn) noexcept
+	{
+		for(u32 i = 0; i < SpinCount; ++i)
+		{
+			if(tryFn())
+				return;
+			cpuRelax();
+		}
+		for(u32 i = 0; i < YieldCount; ++i)
+		{
+			if(tryFn())
+				return;
+			std::this_thread::yield();
+		}
+		while(true)
+		{
+			// the signal is read before checking again, so a wake up after the check can't be missed
+			u32 observed = signal.load(std::memory_order_relaxed);
+			// only the waker takes it off the count, if this doesn't get to park then it just costs one unnecessary wake up later
+			waiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(tryFn())
+				return;
+			signal.wait(observed, std::memory_order_relaxed);
+			if(tryFn())
+				return;
+		}
+	}
+
+	template<typename T>
+	template<typename U>
+	bool MPMCRingBuffer<T>::tryPush(U&& value) noexcept
+	{
+		Cell* cell;
+		std::size_t pos;
+		if(!tryClaimPush(cell, pos))
+			return false;
+		new (cell->storage) T(std::forward<U>(value));
+		publishPush(cell, pos);
+		return true;
+	}
+
+	template<typename T>
+	bool MPMCRingBuffer<T>::tryPop(T& outValue) noexcept
+	{
+		return tryConsume([&outValue](T&& value) { outValue = std::move(value); });
+	}
+
+	template<typename T>
+	template<typename ConsumeFn>
+	bool MPMCRingBuffer<T>::tryConsume(ConsumeFn&& consume) noexcept
+	{
+		Cell* cell;
+		std::size_t pos;
+		if(!tryClaimPop(cell, pos))
+			return false;
+		T* value = cell->getValue();
+		consume(std::move(*value));
+		value->~T();
+		publishPop(cell, pos);
+		return true;
+	}
+
+	template<typename T>
+	template<typename U>
+	void MPMCRingBuffer<T>::pushImpl(U&& value) noexcept
+	{
+		Cell* cell;
+		std::size_t pos;
+		waitUntil(m_pushSignal, m_pushWaiters, [&]() { return tryClaimPush(cell, pos); });
+		new (cell->storage) T(std::forward<U>(value));
+		publishPush(cell, pos);
+	}
+
+	template<typename T>
+	T MPMCRingBuffer<T>::pop() noexcept
+	{
+		Cell* cell;
+		std::size_t pos;
+		waitUntil(m_popSignal, m_popWaiters, [&]() { return tryClaimPop(cell, pos); });
+		T* value = cell->getValue();
+		T result = std::move(*value);
+		value->~T();
+		publishPop(cell, pos);
+		return result;
+	}
+}
@@ -3,11 +3,14 @@
 #include <common/id_generator.h> // for generating unique ids for each subscription
 #include <common/debug.h> // for debug_log_error
 #include <common/assert.h> // for _com_assert
-#include <common/defines.hpp> // for com::KeyIteratable
+#include <common/defines.hpp> // for com::no_publish_ptr_t
+#include <common/Delegate.hpp> // for com::Delegate
 
-#include <functional> // for std::function
+#include <functional> // for std::less
 #include <unordered_map> // for std::unordered_map
-#include <map> // for std::multimap
+#include <vector> // for std::vector
+#include <algorithm> // for std::sort and std::erase_if
+#include <iostream> // for std::cout
 #include <type_traits> // for std::is_same_v
 
 namespace com
@@ -19,8 +22,8 @@ namespace com
 	struct OrderedEventHandlerProto
 	{
 		using type = typename std::conditional<std::is_same<PublisherType, no_publish_ptr_t>::value, 
-							std::function<bool(Args...)>,
-							std::function<bool(PublisherType*, Args...)>
+							Delegate<bool(Args...)>,
+							Delegate<bool(PublisherType*, Args...)>
 							>::type;
 	};
 
@@ -41,12 +44,16 @@ namespace com
 		typedef typename OrderedEventHandlerProto<PublisherType, Args...>::type EventHandler;
 		static constexpr id_generator_id_type_t InvalidSubscriptionID = ID_GENERATOR_ID_TYPE_MAX;
 	private:
-		struct EventHandlerData
+		struct EventHandlerRecord
 		{
+			KeyType key;
+			// InvalidSubscriptionID once unsubscribed, the record is removed when the records are sorted next time
+			SubscriptionID id;
+			// Orders the records with equal keys, by the time they have been subscribed or re-keyed
+			u64 sequence;
 			EventHandler handler;
 			bool isActive;
 			bool isTempInActive;
-			KeyType key;
 		};
 		struct KeyUpdateRequest
 		{
@@ -56,53 +63,136 @@ namespace com
 	private:
 		id_generator_t m_id_generator;
 		PublisherTypePtr m_publisher;
-		std::unordered_map<SubscriptionID, EventHandlerData> m_handlers;
-		std::multimap<KeyType, EventHandlerData*, Compare> m_orderedMap;
+		// Sorted by key (and then by sequence) unless m_isDirty is true, publish() walks it from the beginning to the end
+		std::vector<EventHandlerRecord> m_records;
+		// Index of each subscription's record in m_records
+		std::unordered_map<SubscriptionID, std::size_t> m_recordIndices;
+		// Subscribed while publishing, added to m_records once publish() returns,
+		// adding them right away might relocate the handler being invoked
+		std::vector<EventHandlerRecord> m_subscribeRequests;
 		std::vector<SubscriptionID> m_unsubscribeRequests;
 		std::vector<KeyUpdateRequest> m_keyUpdateRequests;
 		SubscriptionID m_exclusiveAccessID;
-		EventHandlerData* m_exclusiveHandlerData;
+		u64 m_nextSequence;
+		// True if m_records has to be sorted (a subscription has been made or re-keyed) or has unsubscribed records
+		bool m_isDirty;
 		bool m_isPublishing;
 
-		typename std::unordered_map<SubscriptionID, EventHandlerData>::iterator
-	 	getHandlerIt(SubscriptionID id)
+		EventHandlerRecord* findRecord(SubscriptionID id) noexcept
 		{
 			_com_assert(id != InvalidSubscriptionID);
-			auto it = m_handlers.find(id);
-			if(it == m_handlers.end())
-				com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
-			return it;
+			auto it = m_recordIndices.find(id);
+			if(it != m_recordIndices.end())
+				return &m_records[it->second];
+			for(auto& record : m_subscribeRequests)
+				if(record.id == id)
+					return &record;
+			com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
+			return com::null_pointer<EventHandlerRecord>();
 		}
 
-		auto getOrderedMapIt(const EventHandlerData& data) noexcept
+		// Sorts m_records and removes the unsubscribed records from it, if needed
+		void sortRecords() noexcept
 		{
-			auto range = m_orderedMap.equal_range(data.key);
-			auto foundIt = range.first;
-			if(foundIt != range.second)
+			if(!m_isDirty)
+				return;
+			std::erase_if(m_records, [](const EventHandlerRecord& record) { return record.id == InvalidSubscriptionID; });
+			Compare compare { };
+			std::sort(m_records.begin(), m_records.end(), [&compare](const EventHandlerRecord& record1, const EventHandlerRecord& record2)
 			{
-				for(auto it = range.first; it != range.second; ++it)
-					if(it->second == (&data))
-						foundIt = it;
-			}
-			return foundIt;
+				if(compare(record1.key, record2.key))
+					return true;
+				if(compare(record2.key, record1.key))
+					return false;
+				return record1.sequence < record2.sequence;
+			});
+			for(std::size_t i = 0; i < m_records.size(); ++i)
+				m_recordIndices[m_records[i].id] = i;
+			m_isDirty = false;
+		}
+
+		void subscribeImmediately(EventHandlerRecord&& record) noexcept
+		{
+			m_recordIndices.insert({ record.id, m_records.size() });
+			m_records.push_back(std::move(record));
+			m_isDirty = true;
 		}
 
 		void unsubscribeImmediately(SubscriptionID id)
 		{
 			_com_assert(id != InvalidSubscriptionID);
-			auto it = getHandlerIt(id);
-			auto it2 = getOrderedMapIt(it->second);
-			m_orderedMap.erase(it2);
-			m_handlers.erase(it);
+			auto it = m_recordIndices.find(id);
+			if(it == m_recordIndices.end())
+			{
+				com_debug_log_error("You're trying to access a subscription which you never subscribed to!");
+				return;
+			}
+			EventHandlerRecord& record = m_records[it->second];
+			record.id = InvalidSubscriptionID;
+			// Releases the captures of the handler now rather than when the records are sorted
+			record.handler = nullptr;
+			m_recordIndices.erase(it);
+			m_isDirty = true;
 		}
 
 		void updateKeyImmediately(SubscriptionID id, const KeyType& newKey) noexcept
 		{
-			EventHandlerData& data = com::find_value(m_handlers, id);
-			auto it = getOrderedMapIt(data);
-			m_orderedMap.erase(it);
-			data.key = newKey;
-			m_orderedMap.insert({ newKey, &data });
+			EventHandlerRecord* record = findRecord(id);
+			if(!record)
+				return;
+			record->key = newKey;
+			record->sequence = m_nextSequence++;
+			m_isDirty = true;
+		}
+
+		void invoke(EventHandlerRecord& record, Args&... args)
+		{
+			if constexpr (std::is_same_v<PublisherType, no_publish_ptr_t>)
+				record.handler(args...);
+			else
+				record.handler(m_publisher, args...);
+		}
+
+		bool invokeIfActive(EventHandlerRecord& record, Args&... args)
+		{
+			if(record.isTempInActive)
+			{
+				record.isTempInActive = false;
+				return false;
+			}
+			if(!record.isActive || (record.id == InvalidSubscriptionID))
+				return false;
+			if constexpr (std::is_same_v<PublisherType, no_publish_ptr_t>)
+				return record.handler(args...);
+			else
+				return record.handler(m_publisher, args...);
+		}
+
+		// Applies the requests made while publishing
+		void endPublish(bool wasPublishing)
+		{
+			m_isPublishing = wasPublishing;
+			// Still inside another publish() of this event (a handler has published it again)
+			if(wasPublishing)
+				return;
+			if(m_subscribeRequests.size() > 0)
+			{
+				for(auto& record : m_subscribeRequests)
+					subscribeImmediately(std::move(record));
+				m_subscribeRequests.clear();
+			}
+			if(m_unsubscribeRequests.size() > 0)
+			{
+				for(auto id : m_unsubscribeRequests)
+					unsubscribeImmediately(id);
+				m_unsubscribeRequests.clear();
+			}
+			if(m_keyUpdateRequests.size() > 0)
+			{
+				for(auto request : m_keyUpdateRequests)
+					updateKeyImmediately(request.id, request.newKey);
+				m_keyUpdateRequests.clear();
+			}
 		}
 
 	public:
@@ -110,22 +200,25 @@ namespace com
 
 		template<typename T = PublisherType>
 		requires(std::is_same_v<T, no_publish_ptr_t>)
-		OrderedEvent() noexcept : m_id_generator(id_generator_create(0, NULL)), m_exclusiveAccessID(InvalidSubscriptionID), m_exclusiveHandlerData(com::null_pointer<EventHandlerData>()), m_isPublishing(false) { }
+		OrderedEvent() noexcept : m_id_generator(id_generator_create(0, NULL)), m_exclusiveAccessID(InvalidSubscriptionID), m_nextSequence(0), m_isDirty(false), m_isPublishing(false) { }
 
 		// This constructor will be enabled only if the first template argument in com::OrderedEvent<> is not of type com::no_publisher_ptr_t
 		// The pointer passed in here will be passed as the first argument while invoking the handlers
 		template<typename T = PublisherType>
 		requires(!std::is_same_v<T, no_publish_ptr_t>)
-		OrderedEvent(T* publisher) noexcept : m_id_generator(id_generator_create(0, NULL)), m_publisher(publisher), m_exclusiveAccessID(InvalidSubscriptionID), m_exclusiveHandlerData(com::null_pointer<EventHandlerData>()), m_isPublishing(false) { }
+		OrderedEvent(T* publisher) noexcept : m_id_generator(id_generator_create(0, NULL)), m_publisher(publisher), m_exclusiveAccessID(InvalidSubscriptionID), m_nextSequence(0), m_isDirty(false), m_isPublishing(false) { }
 
 		template<typename T = PublisherType>
 		requires(std::is_same_v<T, no_publish_ptr_t>)
 		OrderedEvent(OrderedEvent&& event) noexcept : m_id_generator(event.m_id_generator),
-										m_handlers(std::move(event.m_handlers)),
-										m_orderedMap(std::move(event.m_orderedMap)),
+										m_records(std::move(event.m_records)),
+										m_recordIndices(std::move(event.m_recordIndices)),
+										m_subscribeRequests(std::move(event.m_subscribeRequests)),
 										m_unsubscribeRequests(std::move(event.m_unsubscribeRequests)),
+										m_keyUpdateRequests(std::move(event.m_keyUpdateRequests)),
 										m_exclusiveAccessID(InvalidSubscriptionID),
-										m_exclusiveHandlerData(com::null_pointer<EventHandlerData>()),
+										m_nextSequence(event.m_nextSequence),
+										m_isDirty(event.m_isDirty),
 										m_isPublishing(event.m_isPublishing)
 		{
 			event.m_isPublishing = false;
@@ -135,11 +228,14 @@ namespace com
 		requires(!std::is_same_v<T, no_publish_ptr_t>)
 		OrderedEvent(OrderedEvent&& event) noexcept : m_id_generator(event.m_id_generator),
 										m_publisher(event.m_publisher), 
-										m_handlers(std::move(event.m_handlers)),
-										m_orderedMap(std::move(event.m_orderedMap)),
+										m_records(std::move(event.m_records)),
+										m_recordIndices(std::move(event.m_recordIndices)),
+										m_subscribeRequests(std::move(event.m_subscribeRequests)),
 										m_unsubscribeRequests(std::move(event.m_unsubscribeRequests)),
+										m_keyUpdateRequests(std::move(event.m_keyUpdateRequests)),
 										m_exclusiveAccessID(InvalidSubscriptionID),
-										m_exclusiveHandlerData(com::null_pointer<EventHandlerData>()),
+										m_nextSequence(event.m_nextSequence),
+										m_isDirty(event.m_isDirty),
 										m_isPublishing(event.m_isPublishing)
 		{
 			event.m_publisher = NULL;
@@ -154,7 +250,7 @@ namespace com
 		// Description: Returns the number of subscriptions to this event
 		// Params: None
 		// Returns: an integer (unsigned)
-		COM_NO_DISCARD auto size() const noexcept { return m_handlers.size(); }
+		COM_NO_DISCARD auto size() const noexcept { return m_recordIndices.size() + m_subscribeRequests.size(); }
 
 		// It overwrites the pointer to be passed as the first argument while invoking the handlers
 		// NOTE: This method won't be available if com::OrderedEvent<> has been created with com::no_publish_ptr_t as the first template argument
@@ -178,9 +274,11 @@ namespace com
 		SubscriptionID subscribe(EventHandler handler, const KeyType& key) noexcept
 		{
 			auto id = id_generator_get(&m_id_generator);
-			m_handlers.insert({ id, { std::move(handler), true, false, key } });
-			EventHandlerData& data = com::find_value(m_handlers, id);
-			m_orderedMap.insert({ key, &data });
+			EventHandlerRecord record { key, id, m_nextSequence++, std::move(handler), true, false };
+			if(m_isPublishing)
+				m_subscribeRequests.push_back(std::move(record));
+			else
+				subscribeImmediately(std::move(record));
 			return id;
 		}
 
@@ -191,15 +289,17 @@ namespace com
 		{
 			if(m_isPublishing)
 			{
-				com::KeyIteratable ids(m_handlers);
-				for(auto& id : ids)
-					unsubscribe(id);
+				for(auto& pair : m_recordIndices)
+					unsubscribe(pair.first);
+				for(auto& record : m_subscribeRequests)
+					unsubscribe(record.id);
 			}
 			else
 			{
 				id_generator_reset(&m_id_generator, 0);
-				m_handlers.clear();
-				m_orderedMap.clear();
+				m_records.clear();
+				m_recordIndices.clear();
+				m_isDirty = false;
 			}
 		}
 
@@ -226,8 +326,8 @@ namespace com
 		// NOTE: If id is InvalidSubscription then assertion failure occurs, otherwise the behaviour is undefined
 		void deactivate(SubscriptionID id) noexcept
 		{
-			auto it = getHandlerIt(id);
-			it->second.isActive = false;
+			if(EventHandlerRecord* record = findRecord(id))
+				record->isActive = false;
 		}
 
 		// Description: temporarily marks a subscription/handler deactive which causes the handler invocation
@@ -239,8 +339,8 @@ namespace com
 		// NOTE: If id is InvalidSubscription then assertion failure occurs, otherwise the behaviour is undefined
 		void tempDeactivate(SubscriptionID id) noexcept
 		{
-			auto it = getHandlerIt(id);
-			it->second.isTempInActive = true;
+			if(EventHandlerRecord* record = findRecord(id))
+				record->isTempInActive = true;
 		}
 
 		// Description: activates a subscription/handler which was possibly deactivately by calling deactivate(),
@@ -251,8 +351,8 @@ namespace com
 		// NOTE: If id is InvalidSubscription then assertion failure occurs, otherwise the behaviour is undefined
 		void activate(SubscriptionID id) noexcept
 		{
-			auto it = getHandlerIt(id);
-			it->second.isActive = true;
+			if(EventHandlerRecord* record = findRecord(id))
+				record->isActive = true;
 		}
 
 		// Description: Grants exclusive access to only one subscription/handler, that means if publish() is called on the Event,
@@ -269,7 +369,6 @@ namespace com
 				return;
 			}
 			m_exclusiveAccessID = id;
-			m_exclusiveHandlerData = &getHandlerIt(id)->second;
 		}
 
 		// Description: Releases exclusive access granted on a subscription
@@ -285,7 +384,6 @@ namespace com
 				return;
 			}
 			m_exclusiveAccessID = InvalidSubscriptionID;
-			m_exclusiveHandlerData = com::null_pointer<EventHandlerData>();
 		}
 
 		// Description: Returns id of the subscription/handler which has exclusive access currently otherwise InvalidSubscriptionID
@@ -316,82 +414,43 @@ namespace com
 		// Returns: None
 		void publish(Args... args) noexcept
 		{
+			bool wasPublishing = m_isPublishing;
+			// m_records doesn't change while publishing, the requests made meanwhile are applied after that
+			if(!wasPublishing)
+				sortRecords();
 			m_isPublishing = true;
-			if(m_exclusiveHandlerData)
+			if(m_exclusiveAccessID != InvalidSubscriptionID)
 			{
-				if constexpr (std::is_same_v<PublisherType, no_publish_ptr_t>)
-					m_exclusiveHandlerData->handler(args...);
-				else
-					m_exclusiveHandlerData->handler(m_publisher, args...);
+				if(EventHandlerRecord* record = findRecord(m_exclusiveAccessID))
+					invoke(*record, args...);
 			}
 			else
 			{
-				for(auto it = m_orderedMap.begin(); it != m_orderedMap.end(); ++it)
+				for(std::size_t i = 0, count = m_records.size(); i < count; ++i)
 				{
-					auto& pair = *it;
 					// only invoke this handler if it is active
-					if(!pair.second->isTempInActive && pair.second->isActive)
+					if(invokeIfActive(m_records[i], args...))
 					{
-						bool isStop = false;
-						if constexpr (std::is_same_v<PublisherType, no_publish_ptr_t>)
-							isStop = pair.second->handler(args...);
-						else
-							isStop = pair.second->handler(m_publisher, args...);
-						if(isStop)
-						{
-							++it;
-							while((it != m_orderedMap.end()) && (it->first == pair.first))
-							{
-								if(!pair.second->isTempInActive && it->second->isActive)
-								{
-									if constexpr (std::is_same_v<PublisherType, no_publish_ptr_t>)
-										it->second->handler(args...);
-									else
-										it->second->handler(m_publisher, args...);
-								}
-								else if(pair.second->isTempInActive)
-									pair.second->isTempInActive = false;
-								++it;
-							}
-							break;
-						}
+						// The rest of the handlers with the same key are invoked anyway
+						const KeyType& key = m_records[i].key;
+						for(++i; (i < count) && (m_records[i].key == key); ++i)
+							invokeIfActive(m_records[i], args...);
+						break;
 					}
-					else if(pair.second->isTempInActive)
-						pair.second->isTempInActive = false;
 				}
 			}
-			m_isPublishing = false;
-			if(m_unsubscribeRequests.size() > 0)
-			{
-				for(auto id : m_unsubscribeRequests)
-					unsubscribeImmediately(id);
-				m_unsubscribeRequests.clear();
-			}
-			if(m_keyUpdateRequests.size() > 0)
-			{
-				for(auto request : m_keyUpdateRequests)
-					updateKeyImmediately(request.id, request.newKey);
-				m_keyUpdateRequests.clear();
-			}
+			endPublish(wasPublishing);
 		}
 
 		__attribute__((noinline))
 		void dump() const noexcept
 		{
-			std::cout << "Ordered Event (Dump): " << "\n";
-			for(auto& pair : m_handlers)
-				std::cout << pair.first << " -> " << pair.second.key << std::endl;
-			std::cout << "----\n";
-			for(auto& pair : m_orderedMap)
-			{
-				std::cout << pair.first << ": ";
-				for(auto& pair1 : m_handlers)
-					if(pair1.second.key == pair.first)
-						std::cout << pair1.first << " ";
-				std::cout << "\n";
-			}
+			std::cout << "Ordered Event (Dump): " << (m_isDirty ? "(not sorted yet)" : "") << "\n";
+			for(auto& record : m_records)
+				if(record.id != InvalidSubscriptionID)
+					std::cout << record.id << " -> " << record.key << std::endl;
 			std::cout << std::endl;
 		}
 	};
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API, u32, u64 and f64
+#include <common/assert.h> // for _com_assert
+#include <common/ProducerConsumerBuffer.hpp> // for com::ProducerConsumerBuffer
+#include <common/ConcurrentDynamicPool.hpp> // for com::ConcurrentDynamicPool
+#include <common/ThreadNaming.hpp> // for com::SetThreadName()
+
+#include <atomic> // for std::atomic<>
+#include <chrono> // for std::chrono::steady_clock
+#include <functional> // for std::function and std::invoke
+#include <map> // for std::map
+#include <memory> // for std::unique_ptr and std::shared_ptr
+#include <string> // for std::string
+#include <thread> // for std::thread
+#include <type_traits> // for std::is_invocable_v and std::decay_t
+#include <utility> // for std::move
+#include <vector> // for std::vector
+#include <iterator> // for std::back_inserter and std::make_move_iterator
+#include <limits> // for std::numeric_limits
+
+namespace com
+{
+	struct PipelineStageConfig
+	{
+		// Number of threads running the stage
+		u32 parallelism = 1;
+		// Capacity of the queue feeding the stage, the upstream stage blocks while it is full (backpressure)
+		std::size_t queueCapacity = 1024;
+		// Maximum number of items a thread takes out of the queue at once
+		std::size_t batchSize = 32;
+	};
+
+	struct PipelineStageStats
+	{
+		std::string name;
+		u64 itemCount;
+		// Average time spent in the stage's callable per item
+		f64 averageLatencyUs;
+		// Items per second since the pipeline has been started (until the stage has finished)
+		f64 throughput;
+	};
+
+	enum class PipelineOutputOrder
+	{
+		// The sink receives the items in the order they have been pushed into the pipeline
+		Ordered,
+		// The sink receives the items as soon as they come out of the last stage
+		Unordered
+	};
+
+	template<typename T>
+	class PipelineObjectPool;
+
+	template<typename T>
+	struct PipelinePoolDeleter
+	{
+		PipelineObjectPool<T>* pool;
+		void operator()(T* object) const noexcept { pool->put(object); }
+	};
+
+	// Object taken out of a stage's pool, it goes back into the pool as soon as the downstream stage (or the sink) drops it
+	template<typename T>
+	using PipelinePooled = std::unique_ptr<T, PipelinePoolDeleter<T>>;
+
+	// Pool of output objects shared by all the threads of a stage, the objects are mostly put back on other threads (downstream)
+	// so it is backed by com::ConcurrentDynamicPool, which moves them back to the stage's threads in whole magazines
+	template<typename T>
+	class COMMON_API PipelineObjectPool
+	{
+	private:
+		ConcurrentDynamicPool<T*> m_pool;
+
+	public:
+		PipelineObjectPool(std::function<T()> onCreate = nullptr) : m_pool([onCreate = std::move(onCreate)]() { return onCreate ? new T(onCreate()) : new T { }; },
+																			[](T*& object) { delete object; }) { }
+		PipelineObjectPool(const PipelineObjectPool&) = delete;
+		PipelineObjectPool& operator=(const PipelineObjectPool&) = delete;
+		// NOTE: all the objects must have been put back by now
+		~PipelineObjectPool() noexcept = default;
+
+		PipelinePooled<T> get() { return PipelinePooled<T>(m_pool.get(), PipelinePoolDeleter<T> { this }); }
+		void put(T* object) noexcept { m_pool.put(object); }
+
+		// Number of objects created and not yet destroyed
+		std::size_t size() const noexcept { return m_pool.size(); }
+	};
+
+	template<typename T>
+	struct PipelineEnvelope
+	{
+		// Position of the item in the pipeline's input, the sink restores the order with it
+		u64 sequence;
+		T value;
+	};
+
+	// Calls 'fn' with 'value', or with the object it refers to if 'value' is a pooled object and 'fn' doesn't take the handle itself
+	template<typename Fn, typename T, typename... Args>
+	decltype(auto) InvokePipelineStage(Fn& fn, T& value, Args&... args)
+	{
+		if constexpr(std::is_invocable_v<Fn&, T&, Args&...>)
+			return std::invoke(fn, value, args...);
+		else
+			return std::invoke(fn, *value, args...);
+	}
+
+	class PipelineStageBase
+	{
+	public:
+		virtual ~PipelineStageBase() noexcept = default;
+		virtual void start(std::chrono::steady_clock::time_point startTime) = 0;
+		virtual void join() noexcept = 0;
+		virtual PipelineStageStats getStats() const noexcept = 0;
+	};
+
+	template<typename In, typename Out>
+	class Pipeline;
+
+	template<typename In, typename Out, typename Fn>
+	class PipelineStage : public PipelineStageBase
+	{
+		template<typename, typename>
+		friend class Pipeline;
+
+	private:
+		using InputQueue = ProducerConsumerBuffer<PipelineEnvelope<In>>;
+		using OutputQueue = ProducerConsumerBuffer<PipelineEnvelope<Out>>;
+
+		std::string m_name;
+		PipelineStageConfig m_config;
+		Fn m_fn;
+		std::unique_ptr<InputQueue> m_input;
+		// Input queue of the next stage (or of the sink), it is set once the next stage is added or the pipeline is started
+		OutputQueue* m_output;
+		std::vector<std::thread> m_threads;
+		std::atomic<u32> m_runningThreadCount;
+		std::atomic<u64> m_itemCount;
+		// In nanoseconds
+		std::atomic<u64> m_busyTime;
+		std::chrono::steady_clock::time_point m_startTime;
+		std::chrono::steady_clock::time_point m_finishTime;
+		std::atomic<bool> m_isFinished;
+
+		void run(u32 threadIndex);
+
+	public:
+		PipelineStage(std::string name, Fn fn, const PipelineStageConfig& config);
+		~PipelineStage() noexcept { join(); }
+
+		virtual void start(std::chrono::steady_clock::time_point startTime) override;
+		virtual void join() noexcept override;
+		virtual PipelineStageStats getStats() const noexcept override;
+	};
+
+	template<typename In, typename Out, typename Fn>
+	PipelineStage<In, Out, Fn>::PipelineStage(std::string name, Fn fn, const PipelineStageConfig& config) : m_name(std::move(name)),
+																											m_config(config),
+																											m_fn(std::move(fn)),
+																											m_input(std::make_unique<InputQueue>(config.queueCapacity)),
+																											m_output(nullptr),
+																											m_runningThreadCount(0),
+																											m_itemCount(0),
+																											m_busyTime(0),
+																											m_isFinished(false)
+	{
+		_com_assert(m_config.parallelism > 0);
+		_com_assert(m_config.batchSize > 0);
+	}
+
+	template<typename In, typename Out, typename Fn>
+	void PipelineStage<In, Out, Fn>::start(std::chrono::steady_clock::time_point startTime)
+	{
+		_com_assert(m_output != nullptr);
+		m_startTime = startTime;
+		m_runningThreadCount = m_config.parallelism;
+		for(u32 i = 0; i < m_config.parallelism; ++i)
+			m_threads.emplace_back(&PipelineStage::run, this, i);
+	}
+
+	template<typename In, typename Out, typename Fn>
+	void PipelineStage<In, Out, Fn>::join() noexcept
+	{
+		for(auto& thread : m_threads)
+			if(thread.joinable())
+				thread.join();
+	}
+
+	template<typename In, typename Out, typename Fn>
+	void PipelineStage<In, Out, Fn>::run(u32 threadIndex)
+	{
+		SetThreadName(m_name + "-" + std::to_string(threadIndex));
+		std::vector<PipelineEnvelope<In>> inputs;
+		std::vector<PipelineEnvelope<Out>> outputs;
+		inputs.reserve(m_config.batchSize);
+		outputs.reserve(m_config.batchSize);
+		// The lock of each queue is taken once per batch rather than once per item
+		while(m_input->popBulk(std::back_inserter(inputs), m_config.batchSize) > 0)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for(auto& input : inputs)
+				outputs.push_back({ input.sequence, InvokePipelineStage(m_fn, input.value) });
+			auto end = std::chrono::steady_clock::now();
+			m_busyTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+			m_itemCount.fetch_add(inputs.size(), std::memory_order_relaxed);
+			// Pooled inputs go back to the upstream stage's pool here
+			inputs.clear();
+			m_output->pushBulk(std::make_move_iterator(outputs.begin()), std::make_move_iterator(outputs.end()));
+			outputs.clear();
+		}
+		// The last thread out tells the next stage that no more items are coming
+		if(m_runningThreadCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_finishTime = std::chrono::steady_clock::now();
+			m_isFinished.store(true, std::memory_order_release);
+			m_output->close();
+		}
+	}
+
+	template<typename In, typename Out, typename Fn>
+	PipelineStageStats PipelineStage<In, Out, Fn>::getStats() const noexcept
+	{
+		auto end = m_isFinished.load(std::memory_order_acquire) ? m_finishTime : std::chrono::steady_clock::now();
+		f64 elapsedTime = std::chrono::duration<f64>(end - m_startTime).count();
+		u64 itemCount = m_itemCount.load(std::memory_order_relaxed);
+		u64 busyTime = m_busyTime.load(std::memory_order_relaxed);
+		return
+		{
+			m_name,
+			itemCount,
+			(itemCount > 0) ? (static_cast<f64>(busyTime) / 1000.0 / static_cast<f64>(itemCount)) : 0.0,
+			(elapsedTime > 0) ? (static_cast<f64>(itemCount) / elapsedTime) : 0.0
+		};
+	}
+
+	// Multi-stage pipeline
+	// The stages are callables, each run by its own threads (PipelineStageConfig::parallelism), and connected with bounded queues,
+	// so a slow stage holds back the upstream stages instead of letting the queues grow without limit.
+	// A pooled stage writes into an object taken out of its own pool, which gets recycled once the downstream stage is done with it.
+	// Usage:
+	//	auto pipeline = com::Pipeline<Packet>()
+	//						.addStage("decode", [](Packet& packet) { return decode(packet); }, { .parallelism = 2 })
+	//						.addPooledStage<Frame>("transform", [](const Image& image, Frame& frame) { transform(image, frame); })
+	//						.addStage("encode", [](const Frame& frame) { return encode(frame); });
+	//	pipeline.start([](Bytes bytes) { write(bytes); }, com::PipelineOutputOrder::Ordered);
+	//	for(auto& packet : packets)
+	//		pipeline.push(std::move(packet));
+	//	pipeline.close();
+	//	pipeline.wait();
+	// NOTE: the callable of a stage with parallelism > 1 is called concurrently from all of its threads
+	template<typename In, typename Out = In>
+	class COMMON_API Pipeline
+	{
+		template<typename, typename>
+		friend class Pipeline;
+
+	public:
+		// Maximum number of items the sink takes out of its queue at once
+		static constexpr std::size_t SinkBatchSize = 32;
+
+	private:
+		using OutputQueue = ProducerConsumerBuffer<PipelineEnvelope<Out>>;
+
+		// Destroyed after the stages, so the pooled objects left in the queues can still go back to their pools
+		std::vector<std::shared_ptr<void>> m_pools;
+		std::vector<std::unique_ptr<PipelineStageBase>> m_stages;
+		ProducerConsumerBuffer<PipelineEnvelope<In>>* m_input;
+		// Output queue pointer of the last stage, nullptr as long as there is no stage
+		OutputQueue** m_lastOutput;
+		std::unique_ptr<OutputQueue> m_sinkInput;
+		std::thread m_sinkThread;
+		std::atomic<u64> m_nextSequence;
+		// push() blocks while the sequence of its item is at or beyond this limit, which the sink raises as the items reach it
+		// It bounds the items the sink holds back for reordering, and it is the maximum u64 once the pipeline is closed (or not ordered)
+		std::atomic<u64> m_sequenceLimit;
+		bool m_isStarted;
+
+		void raiseSequenceLimit(u64 limit) noexcept;
+
+		template<typename NewOut, typename Fn>
+		Pipeline<In, NewOut> addStageImpl(std::string name, Fn fn, const PipelineStageConfig& config);
+		template<typename SinkFn>
+		void runSink(SinkFn& sink, PipelineOutputOrder order, std::size_t reorderWindow);
+
+	public:
+		Pipeline() noexcept : m_input(nullptr), m_lastOutput(nullptr), m_nextSequence(0), m_sequenceLimit(0), m_isStarted(false) { }
+		// NOTE: a pipeline can only be moved before it is started
+		Pipeline(Pipeline&& pipeline) noexcept;
+		Pipeline(const Pipeline&) = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+		// Closes the pipeline and waits for all the pushed items to reach the sink
+		~Pipeline() noexcept;
+
+		// 'fn' takes the output of the previous stage (or the pooled object it refers to) and returns the output of this stage
+		template<typename Fn>
+		auto addStage(std::string name, Fn fn, const PipelineStageConfig& config = { }) &&;
+		// 'fn' takes the output of the previous stage (or the pooled object it refers to) and writes into a T taken out of this stage's pool
+		// 'onCreate' creates a new T whenever the pool is empty, T is value-initialized if it is null
+		template<typename T, typename Fn>
+		Pipeline<In, PipelinePooled<T>> addPooledStage(std::string name, Fn fn, std::function<T()> onCreate = nullptr, const PipelineStageConfig& config = { }) &&;
+
+		// Starts all the stages, the sink is called from a thread of its own with the outputs of the last stage
+		// In the Ordered mode, at most 'sinkQueueCapacity' items may be in the pipeline from the oldest one not yet given to the sink,
+		// push() blocks beyond, so the items waiting in the sink for an earlier one are bounded by it too
+		template<typename SinkFn>
+		void start(SinkFn sink, PipelineOutputOrder order = PipelineOutputOrder::Ordered, std::size_t sinkQueueCapacity = 1024);
+		// Blocks while the first stage's queue is full, or the Ordered pipeline is a whole sinkQueueCapacity ahead of the sink
+		// Returns false if the pipeline has been closed (the value is dropped)
+		bool push(In value);
+		// No more items can be pushed, the ones already pushed still flow through all the stages
+		void close();
+		// Waits for all the pushed items to reach the sink, the pipeline must have been closed
+		void wait() noexcept;
+
+		std::vector<PipelineStageStats> getStats() const;
+	};
+
+	template<typename In, typename Out>
+	Pipeline<In, Out>::Pipeline(Pipeline&& pipeline) noexcept : m_pools(std::move(pipeline.m_pools)),
+																m_stages(std::move(pipeline.m_stages)),
+																m_input(pipeline.m_input),
+																m_lastOutput(pipeline.m_lastOutput),
+																m_nextSequence(0),
+																m_sequenceLimit(0),
+																m_isStarted(false)
+	{
+		_com_assert(!pipeline.m_isStarted);
+		pipeline.m_input = nullptr;
+		pipeline.m_lastOutput = nullptr;
+	}
+
+	template<typename In, typename Out>
+	Pipeline<In, Out>::~Pipeline() noexcept
+	{
+		if(!m_isStarted)
+			return;
+		close();
+		wait();
+	}
+
+	template<typename In, typename Out>
+	template<typename NewOut, typename Fn>
+	Pipeline<In, NewOut> Pipeline<In, Out>::addStageImpl(std::string name, Fn fn, const PipelineStageConfig& config)
+	{
+		_com_assert(!m_isStarted);
+		auto stage = std::make_unique<PipelineStage<Out, NewOut, Fn>>(std::move(name), std::move(fn), config);
+		if(m_lastOutput != nullptr)
+			*m_lastOutput = stage->m_input.get();
+		// This is the first stage
+		else if constexpr(std::is_same_v<In, Out>)
+			m_input = stage->m_input.get();
+		Pipeline<In, NewOut> pipeline;
+		pipeline.m_pools = std::move(m_pools);
+		pipeline.m_input = m_input;
+		pipeline.m_lastOutput = &stage->m_output;
+		pipeline.m_stages = std::move(m_stages);
+		pipeline.m_stages.push_back(std::move(stage));
+		m_input = nullptr;
+		m_lastOutput = nullptr;
+		return pipeline;
+	}
+
+	template<typename In, typename Out>
+	template<typename Fn>
+	auto Pipeline<In, Out>::addStage(std::string name, Fn fn, const PipelineStageConfig& config) &&
+	{
+		using NewOut = std::decay_t<decltype(InvokePipelineStage(fn, std::declval<Out&>()))>;
+		return addStageImpl<NewOut>(std::move(name), std::move(fn), config);
+	}
+
+	template<typename In, typename Out>
+	template<typename T, typename Fn>
+	Pipeline<In, PipelinePooled<T>> Pipeline<In, Out>::addPooledStage(std::string name, Fn fn, std::function<T()> onCreate, const PipelineStageConfig& config) &&
+	{
+		auto pool = std::make_shared<PipelineObjectPool<T>>(std::move(onCreate));
+		m_pools.push_back(pool);
+		return addStageImpl<PipelinePooled<T>>(std::move(name), [pool = pool.get(), fn = std::move(fn)](Out& input) mutable
+		{
+			auto output = pool->get();
+			InvokePipelineStage(fn, input, *output);
+			return output;
+		}, config);
+	}
+
+	template<typename In, typename Out>
+	template<typename SinkFn>
+	void Pipeline<In, Out>::start(SinkFn sink, PipelineOutputOrder order, std::size_t sinkQueueCapacity)
+	{
+		_com_assert(!m_isStarted);
+		m_isStarted = true;
+		m_sinkInput = std::make_unique<OutputQueue>(sinkQueueCapacity);
+		m_sequenceLimit.store((order == PipelineOutputOrder::Ordered) ? sinkQueueCapacity : std::numeric_limits<u64>::max(), std::memory_order_release);
+		if(m_lastOutput != nullptr)
+			*m_lastOutput = m_sinkInput.get();
+		// There is no stage, the items go straight to the sink
+		else if constexpr(std::is_same_v<In, Out>)
+			m_input = m_sinkInput.get();
+		auto startTime = std::chrono::steady_clock::now();
+		for(auto& stage : m_stages)
+			stage->start(startTime);
+		m_sinkThread = std::thread([this, sink = std::move(sink), order, sinkQueueCapacity]() mutable { runSink(sink, order, sinkQueueCapacity); });
+	}
+
+	template<typename In, typename Out>
+	void Pipeline<In, Out>::raiseSequenceLimit(u64 limit) noexcept
+	{
+		// Never lowered, close() raises it to the maximum u64 for good
+		u64 currentLimit = m_sequenceLimit.load(std::memory_order_relaxed);
+		while(currentLimit < limit)
+		{
+			if(m_sequenceLimit.compare_exchange_weak(currentLimit, limit, std::memory_order_release, std::memory_order_relaxed))
+			{
+				m_sequenceLimit.notify_all();
+				return;
+			}
+		}
+	}
+
+	template<typename In, typename Out>
+	template<typename SinkFn>
+	void Pipeline<In, Out>::runSink(SinkFn& sink, PipelineOutputOrder order, std::size_t reorderWindow)
+	{
+		SetThreadName("pipeline-sink");
+		std::vector<PipelineEnvelope<Out>> outputs;
+		outputs.reserve(SinkBatchSize);
+		// The items which came out ahead of an earlier one, fewer than 'reorderWindow' as push() waits for the earlier one to get here
+		std::map<u64, Out> pendingOutputs;
+		u64 nextSequence = 0;
+		while(m_sinkInput->popBulk(std::back_inserter(outputs), SinkBatchSize) > 0)
+		{
+			for(auto& output : outputs)
+			{
+				if(order == PipelineOutputOrder::Unordered)
+					sink(std::move(output.value));
+				else if(output.sequence != nextSequence)
+					pendingOutputs.emplace(output.sequence, std::move(output.value));
+				else
+				{
+					sink(std::move(output.value));
+					++nextSequence;
+					auto it = pendingOutputs.begin();
+					while((it != pendingOutputs.end()) && (it->first == nextSequence))
+					{
+						sink(std::move(it->second));
+						it = pendingOutputs.erase(it);
+						++nextSequence;
+					}
+				}
+			}
+			outputs.clear();
+			if(order == PipelineOutputOrder::Ordered)
+				raiseSequenceLimit(nextSequence + reorderWindow);
+		}
+		// A push() which lost the race with close() leaves a hole in the sequence, the rest still go out in order
+		for(auto& pair : pendingOutputs)
+			sink(std::move(pair.second));
+	}
+
+	template<typename In, typename Out>
+	bool Pipeline<In, Out>::push(In value)
+	{
+		_com_assert(m_isStarted);
+		u64 sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed);
+		u64 limit = m_sequenceLimit.load(std::memory_order_acquire);
+		while(sequence >= limit)
+		{
+			m_sequenceLimit.wait(limit, std::memory_order_acquire);
+			limit = m_sequenceLimit.load(std::memory_order_acquire);
+		}
+		return m_input->push(PipelineEnvelope<In> { sequence, std::move(value) });
+	}
+
+	template<typename In, typename Out>
+	void Pipeline<In, Out>::close()
+	{
+		_com_assert(m_isStarted);
+		m_input->close();
+		// The push() calls waiting for the sink now find the pipeline closed
+		raiseSequenceLimit(std::numeric_limits<u64>::max());
+	}
+
+	template<typename In, typename Out>
+	void Pipeline<In, Out>::wait() noexcept
+	{
+		for(auto& stage : m_stages)
+			stage->join();
+		if(m_sinkThread.joinable())
+			m_sinkThread.join();
+	}
+
+	template<typename In, typename Out>
+	std::vector<PipelineStageStats> Pipeline<In, Out>::getStats() const
+	{
+		std::vector<PipelineStageStats> stats;
+		stats.reserve(m_stages.size());
+		for(auto& stage : m_stages)
+			stats.push_back(stage->getStats());
+		return stats;
+	}
+}
@@ -6,10 +6,18 @@
 #include <mutex> // for std::mutex
 #include <condition_variable> // for std::condition_variable
 #include <deque> // for std::deque
+#include <span> // for std::span
+#include <optional> // for std::optional
+#include <chrono> // for std::chrono::duration
+#include <algorithm> // for std::min and std::move
+#include <iterator> // for std::next and std::distance
+#include <stdexcept> // for std::runtime_error
 
 namespace com
 {
 	// Thread-safe producer consumer buffer
+	// The bulk functions move as many elements as possible for each acquisition of the lock,
+	// and close() lets the producers tell the consumers that no more elements are coming
 	template<typename T>
 	class COMMON_API ProducerConsumerBuffer
 	{
@@ -19,12 +27,13 @@ namespace com
 		std::condition_variable m_pushCV;
 		std::condition_variable m_popCV;
 		std::size_t m_maxCount;
+		bool m_isClosed;
 
 		// Transfer-of-lock-ownership
 		std::unique_lock<std::mutex> acquirePushLock()
 		{
 			std::unique_lock<std::mutex> ulock(m_mutex);
-			m_pushCV.wait(ulock, [this]() { return m_storage.size() < m_maxCount; });
+			m_pushCV.wait(ulock, [this]() { return m_isClosed || (m_storage.size() < m_maxCount); });
 			return ulock;
 		}
 
@@ -34,9 +43,21 @@ namespace com
 			m_popCV.notify_all();
 		}
 
+		bool isPopReady() const noexcept { return m_isClosed || (m_storage.size() > 0); }
+
+		// Pops the front element, the lock must be held and the buffer must not be empty
+		T popLocked(std::unique_lock<std::mutex> lock)
+		{
+			auto p = std::move(m_storage.front());
+			m_storage.pop_front();
+			lock.unlock();
+			m_pushCV.notify_all();
+			return p;
+		}
+
 	public:
 		// The internal buffer will expand unboundedly by default
-		ProducerConsumerBuffer(std::size_t maxCount = std::numeric_limits<std::size_t>::max()) : m_maxCount(maxCount) { }
+		ProducerConsumerBuffer(std::size_t maxCount = std::numeric_limits<std::size_t>::max()) : m_maxCount(maxCount), m_isClosed(false) { }
 
 		bool isEmpty()
 		{
@@ -44,28 +65,124 @@ namespace com
 			return m_storage.size() == 0;
 		}
 
-		void push(T&& value)
+		bool isClosed()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_isClosed;
+		}
+
+		// Rejects any further pushes and wakes up all the waiting producers and consumers
+		// The elements already pushed can still be popped
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_isClosed = true;
+			}
+			m_pushCV.notify_all();
+			m_popCV.notify_all();
+		}
+
+		// Returns false if the buffer has been closed (the value is dropped)
+		bool push(T&& value)
 		{
 			auto lock = acquirePushLock();
+			if(m_isClosed)
+				return false;
 			m_storage.push_back(std::move(value));
 			releasePushLock(std::move(lock));
+			return true;
 		}
 
-		void push(const T& value)
+		bool push(const T& value)
 		{
 			auto lock = acquirePushLock();
+			if(m_isClosed)
+				return false;
 			m_storage.push_back(value);
 			releasePushLock(std::move(lock));
+			return true;
+		}
+
+		// Pushes all the values in [first, last), waiting for the space if the buffer is bounded
+		// The iterators must be multi-pass (forward iterators, or std::move_iterator<>s over them to move the values instead of copying them)
+		// Returns the number of values pushed, which is less than the number of values only if the buffer has been closed
+		template<typename ForwardIt>
+		std::size_t pushBulk(ForwardIt first, ForwardIt last)
+		{
+			std::size_t count = 0;
+			while(first != last)
+			{
+				auto lock = acquirePushLock();
+				if(m_isClosed)
+					break;
+				std::size_t n = std::min(static_cast<std::size_t>(std::distance(first, last)), m_maxCount - m_storage.size());
+				auto next = std::next(first, n);
+				m_storage.insert(m_storage.end(), first, next);
+				first = next;
+				count += n;
+				releasePushLock(std::move(lock));
+			}
+			return count;
 		}
 
+		std::size_t pushBulk(std::span<const T> values) { return pushBulk(values.begin(), values.end()); }
+
+		// Blocks until an element is available (or the buffer is closed)
+		// Throws std::runtime_error if the buffer has been closed and drained, use popUnlessClosed() to drain a buffer which can be closed
 		T pop()
 		{
 			std::unique_lock<std::mutex> ulock(m_mutex);
-			m_popCV.wait(ulock, [this]() { return m_storage.size() > 0; });
-			auto p = std::move(m_storage.front());
-			m_storage.pop_front();
-			m_pushCV.notify_all();
-			return p;
+			m_popCV.wait(ulock, [this]() { return isPopReady(); });
+			if(m_storage.empty())
+				throw std::runtime_error("pop() on a closed and drained ProducerConsumerBuffer");
+			return popLocked(std::move(ulock));
+		}
+
+		// Blocks until an element is available, returns std::nullopt once the buffer has been closed and drained
+		std::optional<T> popUnlessClosed()
+		{
+			std::unique_lock<std::mutex> ulock(m_mutex);
+			m_popCV.wait(ulock, [this]() { return isPopReady(); });
+			if(m_storage.empty())
+				return { };
+			return popLocked(std::move(ulock));
+		}
+
+		// Blocks until at least one element is available (or the buffer is closed) and then moves up to 'maxCount' elements into 'out'
+		// Returns the number of elements popped, zero only if the buffer has been closed and drained
+		template<typename OutputIt>
+		std::size_t popBulk(OutputIt out, std::size_t maxCount)
+		{
+			std::unique_lock<std::mutex> ulock(m_mutex);
+			m_popCV.wait(ulock, [this]() { return isPopReady(); });
+			std::size_t count = std::min(maxCount, m_storage.size());
+			auto end = std::next(m_storage.begin(), count);
+			std::move(m_storage.begin(), end, out);
+			m_storage.erase(m_storage.begin(), end);
+			ulock.unlock();
+			if(count > 0)
+				m_pushCV.notify_all();
+			return count;
+		}
+
+		// Returns std::nullopt if the buffer is empty
+		std::optional<T> tryPop()
+		{
+			std::unique_lock<std::mutex> ulock(m_mutex);
+			if(m_storage.empty())
+				return { };
+			return popLocked(std::move(ulock));
+		}
+
+		// Returns std::nullopt if no element became available within 'timeout', or the buffer has been closed and drained
+		template<typename Rep, typename Period>
+		std::optional<T> popFor(const std::chrono::duration<Rep, Period>& timeout)
+		{
+			std::unique_lock<std::mutex> ulock(m_mutex);
+			if(!m_popCV.wait_for(ulock, timeout, [this]() { return isPopReady(); }) || m_storage.empty())
+				return { };
+			return popLocked(std::move(ulock));
 		}
 	};
 }
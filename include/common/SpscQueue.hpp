@@ -0,0 +1,161 @@
+#pragma once
+
+#include <common/defines.hpp> // for COMMON_API etc.
+
+#include <atomic> // for std::atomic<>
+#include <new> // for placement new and std::launder
+#include <thread> // for std::this_thread::yield()
+#include <utility> // for std::move and std::forward
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	include <immintrin.h> // for _mm_pause()
+#endif
+
+namespace com
+{
+	// Bounded wait-free single-producer single-consumer queue
+	// It has the same push/pop surface as com::ProducerConsumerBuffer, but exactly one thread may push and exactly one thread may pop.
+	// Each side owns one index (on its own cache line) and keeps a cached copy of the other side's index, which it refreshes
+	// only when the queue looks full (or empty), so the fast path is a plain store-release and never an atomic read-modify-write.
+	// The blocking push() and pop() spin for a while and then keep yielding, they never park the calling thread,
+	// so they suit threads dedicated to a pipeline stage.
+	template<typename T, std::size_t Capacity = 1024>
+	class COMMON_API SpscQueue
+	{
+		static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of 2");
+
+	public:
+		static constexpr std::size_t CacheLineSize = 64;
+		// Number of failed attempts spent spinning before yielding the calling thread
+		static constexpr u32 SpinCount = 64;
+
+	private:
+		static constexpr std::size_t Mask = Capacity - 1;
+
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		// Written by the producer only, the indices run freely and are wrapped with Mask
+		alignas(CacheLineSize) std::atomic<std::size_t> m_tail;
+		std::size_t m_cachedHead;
+		// Written by the consumer only
+		alignas(CacheLineSize) std::atomic<std::size_t> m_head;
+		std::size_t m_cachedTail;
+		alignas(CacheLineSize) Slot m_slots[Capacity];
+
+		T* getValue(std::size_t index) noexcept { return std::launder(reinterpret_cast<T*>(m_slots[index & Mask].storage)); }
+
+		static void cpuRelax() noexcept
+		{
+		#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+			_mm_pause();
+		#elif defined(__aarch64__)
+			asm volatile("yield");
+		#endif
+		}
+
+		// Spins and then yields until tryFn() returns true
+		template<typename TryFn>
+		static void waitUntil(TryFn tryFn) noexcept;
+
+	public:
+		SpscQueue() noexcept : m_tail(0), m_cachedHead(0), m_head(0), m_cachedTail(0) { }
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+		// NOTE: neither the producer nor the consumer may be using the queue while it is being destroyed
+		~SpscQueue() noexcept;
+
+		static constexpr std::size_t capacity() noexcept { return Capacity; }
+		// Approximate while the other side is pushing or popping
+		bool isEmpty() const noexcept { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+		// Producer side, returns false if the queue is full
+		template<typename U>
+		bool tryPush(U&& value) noexcept;
+		// Consumer side, returns false if the queue is empty
+		bool tryPop(T& outValue) noexcept;
+
+		// Blocks while the queue is full
+		void push(T&& value) noexcept { waitUntil([&]() { return tryPush(std::move(value)); }); }
+		void push(const T& value) noexcept { waitUntil([&]() { return tryPush(value); }); }
+		// Blocks while the queue is empty
+		T pop() noexcept;
+	};
+
+	template<typename T, std::size_t Capacity>
+	SpscQueue<T, Capacity>::~SpscQueue() noexcept
+	{
+		std::size_t tail = m_tail.load(std::memory_order_acquire);
+		for(std::size_t head = m_head.load(std::memory_order_relaxed); head != tail; ++head)
+			getValue(head)->~T();
+	}
+
+	template<typename T, std::size_t Capacity>
+	template<typename TryFn>
+	void SpscQueue<T, Capacity>::waitUntil(TryFn tryFn) noexcept
+	{
+		for(u32 i = 0; i < SpinCount; ++i)
+		{
+			if(tryFn())
+				return;
+			cpuRelax();
+		}
+		while(!tryFn())
+			std::this_thread::yield();
+	}
+
+	template<typename T, std::size_t Capacity>
+	template<typename U>
+	bool SpscQueue<T, Capacity>::tryPush(U&& value) noexcept
+	{
+		std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if((tail - m_cachedHead) == Capacity)
+		{
+			// the queue looked full the last time, see how far the consumer has got since then
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			if((tail - m_cachedHead) == Capacity)
+				return false;
+		}
+		new (m_slots[tail & Mask].storage) T(std::forward<U>(value));
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, std::size_t Capacity>
+	bool SpscQueue<T, Capacity>::tryPop(T& outValue) noexcept
+	{
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+		if(head == m_cachedTail)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if(head == m_cachedTail)
+				return false;
+		}
+		T* value = getValue(head);
+		outValue = std::move(*value);
+		value->~T();
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, std::size_t Capacity>
+	T SpscQueue<T, Capacity>::pop() noexcept
+	{
+		waitUntil([this]()
+		{
+			std::size_t head = m_head.load(std::memory_order_relaxed);
+			if(head != m_cachedTail)
+				return true;
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			return head != m_cachedTail;
+		});
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+		T* value = getValue(head);
+		T result = std::move(*value);
+		value->~T();
+		m_head.store(head + 1, std::memory_order_release);
+		return result;
+	}
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <common/DynamicPool.hpp> // for com::DynamicPoolHandle, com::DynamicPoolFunctionPolicy and the policy hook concepts
+
+#include <memory> // for std::unique_ptr, std::construct_at and std::destroy_at
+#include <new> // for std::launder
+#include <vector> // for std::vector
+#include <utility> // for std::move, std::swap and std::in_place
+#include <functional> // for std::less
+#include <cstddef> // for std::byte
+
+namespace com
+{
+	// Object pool with the same bookkeeping (slots, handles and policies) as com::DynamicPool, but the objects are stored
+	// in chunks of ChunkSize objects which are never reallocated, so an object never moves for as long as it exists.
+	// get() returns a reference to the object instead of a copy, and neither put() nor the growth of the pool moves any object;
+	// the active and inactive objects are told apart by a permutation of the slots only.
+	// NOTE: the objects are destroyed (destroy hook and then the destructor) by clear() and by the destructor of the pool only
+	template<typename T, typename Policy = DynamicPoolFunctionPolicy<T>, std::size_t ChunkSize = 64>
+	class COMMON_API StableDynamicPool
+	{
+		static_assert(DynamicPoolCreateHook<Policy, T> || DynamicPoolSlotCreateHook<Policy, T>, "The policy must have T create() or T create(u32 slot)");
+		static_assert(ChunkSize > 0, "ChunkSize must be greater than 0");
+
+	public:
+		typedef std::function<T()> OnCreate;
+		typedef std::function<void(T&)> OnDestroy;
+		typedef std::function<void(T&)> OnReturn;
+		typedef std::function<void(T&)> OnRecycle;
+		using ElementType = T;
+		using PolicyType = Policy;
+		using Handle = DynamicPoolHandle;
+
+	private:
+		static constexpr bool IsFunctionPolicy = std::same_as<Policy, DynamicPoolFunctionPolicy<T>>;
+
+		struct Chunk
+		{
+			alignas(T) std::byte storage[sizeof(T) * ChunkSize];
+
+			// Address of the object at 'index', whether it has been constructed or not
+			T* getAddress(std::size_t index) noexcept { return reinterpret_cast<T*>(storage) + index; }
+			T* get(std::size_t index) noexcept { return std::launder(getAddress(index)); }
+		};
+
+		struct Slot
+		{
+			u32 position;
+			u32 generation;
+		};
+
+		std::vector<std::unique_ptr<Chunk>> m_chunks;
+		// Number of objects constructed in the chunks, the object of slot 's' is at index 's % ChunkSize' of chunk 's / ChunkSize'
+		std::size_t m_size;
+		std::size_t m_activeCount;
+		// Slot at each position, the slots at positions [0, m_activeCount) are active
+		std::vector<u32> m_positionSlots;
+		// Position and generation of each slot, the generations are kept across clear() so that the old handles stay invalid
+		std::vector<Slot> m_slots;
+		[[no_unique_address]] Policy m_policy;
+
+		T& getObject(u32 slot) noexcept { return *m_chunks[slot / ChunkSize]->get(slot % ChunkSize); }
+		bool isSlotActive(u32 slot) const noexcept { return (slot < m_size) && (m_slots[slot].position < m_activeCount); }
+		// Constructs a new object in the next free slot
+		T& create() noexcept;
+		void onReturn(T& value) noexcept;
+		// Creates or recycles an object and returns its slot
+		u32 activate() noexcept;
+		void deactivate(u32 slot) noexcept;
+		// Returns m_slots.size() if the object isn't in this pool
+		u32 findSlot(const T& value) const noexcept;
+		// Constructs the pool for the constructors below
+		StableDynamicPool(std::in_place_t, Policy policy, bool isReturn, std::size_t initialCount) noexcept;
+
+	protected:
+		// The std::function policy has no create hook until setOnCreate() is called, so only a derived pool may leave it out
+		explicit StableDynamicPool(Policy policy, bool isReturn = false, std::size_t initialCount = 0) noexcept requires IsFunctionPolicy : StableDynamicPool(std::in_place, std::move(policy), isReturn, initialCount) { }
+
+	public:
+		explicit StableDynamicPool(Policy policy = { }, bool isReturn = false, std::size_t initialCount = 0) noexcept requires(!IsFunctionPolicy) : StableDynamicPool(std::in_place, std::move(policy), isReturn, initialCount) { }
+		StableDynamicPool(OnCreate onCreate,
+						OnDestroy onDestroy = nullptr,
+						OnReturn onReturn = nullptr,
+						OnRecycle onRecycle = nullptr,
+						bool isReturn = false,
+						std::size_t initialCount = 0) noexcept requires IsFunctionPolicy : StableDynamicPool(std::in_place, Policy(std::move(onCreate), std::move(onDestroy), std::move(onReturn), std::move(onRecycle)), isReturn, initialCount) { }
+		StableDynamicPool(const StableDynamicPool&) = delete;
+		StableDynamicPool& operator=(const StableDynamicPool&) = delete;
+		// The objects stay where they are, so the references to them remain valid
+		StableDynamicPool(StableDynamicPool&& pool) noexcept;
+		StableDynamicPool& operator=(StableDynamicPool&& pool) noexcept;
+		~StableDynamicPool() noexcept;
+
+		Policy& getPolicy() noexcept { return m_policy; }
+
+		// The reference stays valid until the pool is cleared or destroyed
+		T& get() noexcept { return getObject(activate()); }
+		// Linear time in the number of chunks, it has to look for the chunk the object belongs to
+		void put(T& value) noexcept;
+		// Same as get(), but returns a handle to the object
+		Handle getHandle() noexcept;
+		// Constant time, a stale handle (of an object already put back) is reported and ignored
+		void put(Handle handle) noexcept;
+		bool isValid(Handle handle) const noexcept { return (handle.slot < m_slots.size()) && (m_slots[handle.slot].generation == handle.generation) && isSlotActive(handle.slot); }
+		T& getValue(Handle handle) noexcept
+		{
+			_com_assert(isValid(handle));
+			return getObject(handle.slot);
+		}
+		// Puts all the active objects back into the pool
+		// NOTE: this operation doesn't destroy the objects, it just calls the onReturn hook on every object
+		void reclaim() noexcept;
+		// Destroys all the objects and frees the chunks
+		void clear() noexcept;
+		void reserve(std::size_t count, bool isReturn = true) noexcept;
+
+		std::size_t activeCount() const noexcept { return m_activeCount; }
+		std::size_t size() const noexcept { return m_size; }
+
+		// Calls 'visitor' on every active object
+		template<typename Visitor>
+		void forEachActive(Visitor visitor) noexcept
+		{
+			for(std::size_t i = 0; i < m_activeCount; ++i)
+				visitor(getObject(m_positionSlots[i]));
+		}
+	};
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	StableDynamicPool<T, Policy, ChunkSize>::StableDynamicPool(std::in_place_t, Policy policy, bool isReturn, std::size_t initialCount) noexcept : m_size(0),
+																																m_activeCount(0),
+																																m_policy(std::move(policy))
+	{
+		reserve(initialCount, isReturn);
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	StableDynamicPool<T, Policy, ChunkSize>::StableDynamicPool(StableDynamicPool&& pool) noexcept : m_chunks(std::move(pool.m_chunks)),
+																									m_size(pool.m_size),
+																									m_activeCount(pool.m_activeCount),
+																									m_positionSlots(std::move(pool.m_positionSlots)),
+																									m_slots(std::move(pool.m_slots)),
+																									m_policy(std::move(pool.m_policy))
+	{
+		pool.m_chunks.clear();
+		pool.m_positionSlots.clear();
+		pool.m_slots.clear();
+		pool.m_size = 0;
+		pool.m_activeCount = 0;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	StableDynamicPool<T, Policy, ChunkSize>& StableDynamicPool<T, Policy, ChunkSize>::operator=(StableDynamicPool&& pool) noexcept
+	{
+		clear();
+		m_chunks = std::move(pool.m_chunks);
+		m_size = pool.m_size;
+		m_activeCount = pool.m_activeCount;
+		m_positionSlots = std::move(pool.m_positionSlots);
+		m_slots = std::move(pool.m_slots);
+		m_policy = std::move(pool.m_policy);
+		pool.m_chunks.clear();
+		pool.m_positionSlots.clear();
+		pool.m_slots.clear();
+		pool.m_size = 0;
+		pool.m_activeCount = 0;
+		return *this;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	StableDynamicPool<T, Policy, ChunkSize>::~StableDynamicPool() noexcept
+	{
+		clear();
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	T& StableDynamicPool<T, Policy, ChunkSize>::create() noexcept
+	{
+		u32 slot = static_cast<u32>(m_size);
+		if((slot / ChunkSize) == m_chunks.size())
+			// Not std::make_unique<Chunk>(), it would zero the whole chunk
+			m_chunks.push_back(std::unique_ptr<Chunk>(new Chunk));
+		T* object = m_chunks[slot / ChunkSize]->getAddress(slot % ChunkSize);
+		if constexpr(DynamicPoolSlotCreateHook<Policy, T>)
+			std::construct_at(object, m_policy.create(slot));
+		else
+			std::construct_at(object, m_policy.create());
+		++m_size;
+		m_positionSlots.push_back(slot);
+		if(slot < m_slots.size())
+			m_slots[slot].position = slot;
+		else
+			m_slots.push_back({ slot, 0 });
+		return *object;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::onReturn(T& value) noexcept
+	{
+		if constexpr(DynamicPoolReturnHook<Policy, T>)
+			m_policy.onReturn(value);
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	u32 StableDynamicPool<T, Policy, ChunkSize>::activate() noexcept
+	{
+		_com_assert(m_activeCount <= m_size);
+
+		// If no more inactive objects left, then create new
+		if(m_activeCount == m_size)
+			create();
+		// Otherwise recycle the existing one
+		else if constexpr(DynamicPoolRecycleHook<Policy, T>)
+			m_policy.onRecycle(getObject(m_positionSlots[m_activeCount]));
+		return m_positionSlots[m_activeCount++];
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::deactivate(u32 slot) noexcept
+	{
+		// Only the slots are swapped, the objects stay where they are
+		std::size_t position = m_slots[slot].position;
+		std::size_t lastActivePosition = m_activeCount - 1;
+		u32 lastActiveSlot = m_positionSlots[lastActivePosition];
+		std::swap(m_positionSlots[position], m_positionSlots[lastActivePosition]);
+		m_slots[lastActiveSlot].position = static_cast<u32>(position);
+		m_slots[slot].position = static_cast<u32>(lastActivePosition);
+		// Invalidates the handles to this object
+		++m_slots[slot].generation;
+		onReturn(getObject(slot));
+		--m_activeCount;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	u32 StableDynamicPool<T, Policy, ChunkSize>::findSlot(const T& value) const noexcept
+	{
+		const T* address = &value;
+		std::less<const T*> less;
+		for(std::size_t i = 0; i < m_chunks.size(); ++i)
+		{
+			const T* first = m_chunks[i]->getAddress(0);
+			if(!less(address, first) && less(address, first + ChunkSize))
+				return static_cast<u32>(i * ChunkSize + static_cast<std::size_t>(address - first));
+		}
+		return static_cast<u32>(m_slots.size());
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::put(T& value) noexcept
+	{
+		u32 slot = findSlot(value);
+		if(!isSlotActive(slot))
+		{
+			com_debug_log_error("No such value ever gotten from the pool, but you're still trying to return/put back into it");
+			return;
+		}
+		deactivate(slot);
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	typename StableDynamicPool<T, Policy, ChunkSize>::Handle StableDynamicPool<T, Policy, ChunkSize>::getHandle() noexcept
+	{
+		u32 slot = activate();
+		return { slot, m_slots[slot].generation };
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::put(Handle handle) noexcept
+	{
+		if(!isValid(handle))
+		{
+			com_debug_log_error("Stale handle, the object has already been put back into the pool");
+			return;
+		}
+		deactivate(handle.slot);
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::reclaim() noexcept
+	{
+		for(std::size_t i = 0; i < m_activeCount; ++i)
+		{
+			u32 slot = m_positionSlots[i];
+			++m_slots[slot].generation;
+			onReturn(getObject(slot));
+		}
+		m_activeCount = 0;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::clear() noexcept
+	{
+		for(std::size_t i = 0; i < m_activeCount; ++i)
+			++m_slots[m_positionSlots[i]].generation;
+		for(std::size_t i = 0; i < m_size; ++i)
+		{
+			T& object = getObject(static_cast<u32>(i));
+			if constexpr(DynamicPoolDestroyHook<Policy, T>)
+				m_policy.destroy(object);
+			std::destroy_at(&object);
+		}
+		m_chunks.clear();
+		m_positionSlots.clear();
+		m_size = 0;
+		m_activeCount = 0;
+	}
+
+	template<typename T, typename Policy, std::size_t ChunkSize>
+	void StableDynamicPool<T, Policy, ChunkSize>::reserve(std::size_t count, bool isReturn) noexcept
+	{
+		_com_assert(count >= m_size);
+		m_positionSlots.reserve(count);
+		while(m_size < count)
+		{
+			T& object = create();
+			if(isReturn)
+				onReturn(object);
+		}
+	}
+}
@@ -115,6 +115,13 @@ typedef struct com_immutable_data_t
 #   define UNREACHABLE() COM_UNREACHABLE()
 #endif // PREFIX_MACROS_AND_QUALIFY_SYMBOLS_WITH_COM
 
+/* hints the CPU to bring the cache line containing 'address' into all levels of the cache for reading, it never faults */
+#if defined(COMPILER_CLANG) || defined(COMPILER_MINGW) || defined(COMPILER_GCC)
+#   define COM_PREFETCH_READ(address) __builtin_prefetch((address), 0, 3)
+#else
+#   define COM_PREFETCH_READ(address) ((void)(address))
+#endif
+
 #define DEPRECATED DEPRECATED_FUNCTION
 #define INLINE INLINE_FUNCTION
 #define FORCE_INLINE FORCE_INLINE_FUNCTION
@@ -2,8 +2,16 @@
 
 #include <bufferlib/buffer.h>
 #include <common/defines.h>
+#include <common/hash_function.h> // hash_function_t
 
 #define DICTIONARY_INVALID_INDEX BUF_INVALID_INDEX
+#define DICTIONARY_INDEX_SLOT_EMPTY U32_MAX
+
+typedef struct dictionary_index_slot_t
+{
+	u32 hash;											// lower 32 bits of the hash of the key, compared before calling the key_comparer
+	u32 index;											// index of the key-value pair in the buffer, DICTIONARY_INDEX_SLOT_EMPTY if the slot is empty
+} dictionary_index_slot_t;
 
 typedef struct dictionary_t
 { 
@@ -11,6 +19,10 @@ typedef struct dictionary_t
 	bool (*key_comparer)(void* compare_key, void* key);	// compare_key = the key to be compared, key = the key already present in the dictionary
 	u32 key_size;										// holds the size of the key
 	u32 value_size;										// holds the size of the value
+	hash_function_t key_hash_function;					// NULL if the dictionary is not hash indexed, otherwise the keys are looked up through the index below
+	dictionary_index_slot_t* index_slots;				// open addressed (linear probing) table mapping the keys to the indices of the key-value pairs in the buffer
+	u32 index_slot_count;								// number of slots in the index, always a power of 2 and at least twice the number of key-value pairs
+	bool (*key_less_than)(void* lhs, void* rhs);		// NULL if the dictionary is not sorted, otherwise the key-value pairs are kept sorted by their keys
 } dictionary_t;
 
 BEGIN_CPP_COMPATIBLE
@@ -18,6 +30,19 @@ BEGIN_CPP_COMPATIBLE
 // constructors and destructors
 #define dictionary_create(Tkey, Tvalue, capacity, key_comparer) __dictionary_create(sizeof(Tkey), sizeof(Tvalue), capacity, key_comparer)
 COMMON_API dictionary_t __dictionary_create(u32 key_size, u32 value_size, buf_ucount_t capacity, bool (*key_comparer)(void* compare_key, void* key));
+// hash indexed dictionary: the key-value pairs are still stored contiguously in insertion order (so the index based functions work as usual)
+// but the key based lookups go through an open addressed index instead of scanning all the keys, the index takes 8 bytes per slot
+// NOTE: dictionary_remove() and dictionary_set_at() are still O(n) as the key-value pairs after the removed one are shifted
+#define dictionary_create_hashed(Tkey, Tvalue, capacity, key_comparer, key_hash_function) __dictionary_create_hashed(sizeof(Tkey), sizeof(Tvalue), capacity, key_comparer, key_hash_function)
+COMMON_API dictionary_t __dictionary_create_hashed(u32 key_size, u32 value_size, buf_ucount_t capacity, bool (*key_comparer)(void* compare_key, void* key), hash_function_t key_hash_function);
+// sorted dictionary: the key-value pairs are kept sorted by their keys (see comparer.h, u32_less_than, string_less_than etc.)
+// and the key based lookups are binary searches, so the index based functions iterate the pairs in the sorted order
+// the keys equal by key_comparer must be equivalent by key_less_than, but not the other way around: a lookup compares all the keys equivalent to
+// the one looked up, e.g. string_less_than orders the strings by their length, so the lookups compare all the strings of the same length
+// it is meant for the dictionaries which are built once (preferably with dictionary_bulk_load()) and then only read,
+// dictionary_push() and dictionary_remove() are O(n) as they shift the key-value pairs
+#define dictionary_create_sorted(Tkey, Tvalue, capacity, key_comparer, key_less_than) __dictionary_create_sorted(sizeof(Tkey), sizeof(Tvalue), capacity, key_comparer, key_less_than)
+COMMON_API dictionary_t __dictionary_create_sorted(u32 key_size, u32 value_size, buf_ucount_t capacity, bool (*key_comparer)(void* compare_key, void* key), bool (*key_less_than)(void* lhs, void* rhs));
 COMMON_API void dictionary_free(dictionary_t* dictionary);
 
 // getters
@@ -32,6 +57,8 @@ COMMON_API void* dictionary_get_value_ptr_at(dictionary_t* dictionary, buf_ucoun
 COMMON_API void* dictionary_get_value_ptr(dictionary_t* dictionary, void* key);
 COMMON_API buf_ucount_t dictionary_get_count(dictionary_t* dictionary);
 COMMON_API buf_ucount_t dictionary_get_capacity(dictionary_t* dictionary);
+COMMON_API bool dictionary_is_hashed(dictionary_t* dictionary);
+COMMON_API bool dictionary_is_sorted(dictionary_t* dictionary);
 
 
 // setters
@@ -42,11 +69,21 @@ COMMON_API void dictionary_set_value_at(dictionary_t* dictionary, buf_ucount_t i
 // logic functions
 #define dictionary_add(...) dictionary_push(__VA_ARGS__)
 COMMON_API void dictionary_push(dictionary_t* dictionary, void* in_key, void* in_value);
+// adds a key-value pair with the key 'in_key' and returns pointer to its value, which must be written by the caller
+// the pointer is valid until the dictionary is modified again
+COMMON_API void* dictionary_emplace(dictionary_t* dictionary, void* in_key);
+// appends 'count' key-value pairs laid out the same way as in the dictionary (value immediately follows the key)
+COMMON_API void dictionary_push_n(dictionary_t* dictionary, void* in_pairs, buf_ucount_t count);
 COMMON_API void dictionary_pop(dictionary_t* dictionary, void* out_key, void* out_value);
 COMMON_API void dictionary_remove(dictionary_t* dictionary, void* key);
 COMMON_API bool dictionary_contains(dictionary_t* dictionary, void* key);
 COMMON_API void dictionary_clear(dictionary_t* dictionary);
 COMMON_API buf_ucount_t dictionary_find_index_of(dictionary_t* dictionary, void* key);
+// appends 'count' keys and 'count' values (both are contiguous arrays) at once, a sorted dictionary is sorted only once
+// and a hash indexed dictionary grows its index only once
+COMMON_API void dictionary_bulk_load(dictionary_t* dictionary, void* keys, void* values, buf_ucount_t count);
+// sorts the key-value pairs (stable) and turns the dictionary into a sorted one, the hash index (if any) is released
+COMMON_API void dictionary_freeze(dictionary_t* dictionary, bool (*key_less_than)(void* lhs, void* rhs));
 
 #define dictionary_key_comparer_char dictionary_key_comparer_s8
 #define dictionary_key_comparer_int dictionary_key_comparer_s32
@@ -4,12 +4,44 @@
 
 typedef u64 hash_t;
 typedef hash_t (*hash_function_t)(void* key);
+/* same as hash_function_t but the seed is mixed in while hashing (not into the hash), so the keys colliding with one seed don't collide with another */
+typedef hash_t (*seeded_hash_function_t)(void* key, hash_t seed);
+
+/* implementations of the long input path of bytes_hash(), the widest one compiled in is used */
+typedef enum hash_function_long_path_t
+{
+	HASH_FUNCTION_LONG_PATH_SCALAR,
+	HASH_FUNCTION_LONG_PATH_SSE2,
+	HASH_FUNCTION_LONG_PATH_AVX2
+} hash_function_long_path_t;
+
+/* seed used by the hash functions matching hash_function_t */
+#define HASH_FUNCTION_DEFAULT_SEED 0ULL
 
 BEGIN_CPP_COMPATIBLE
 
-/* WARNING: this only works for string's having length upto 2^16 - 1 characters. Use large_string_hash instead. */
+/* hashes 'size' number of bytes pointed by 'bytes' (wyhash, and for the long inputs, xxh3 style accumulation into SIMD lanes)
+ * the hash values depend on 'seed', so seeding with a secret value makes them unpredictable to an attacker */
+COMMON_API hash_t bytes_hash(const void* bytes, u64 size, hash_t seed);
+/* mixes all the 64 bits of 'value' into all the 64 bits of the result, it is a bijection, so no two integers collide */
+COMMON_API hash_t u64_mix(u64 value);
+/* mixes a secret 'seed' into an already calculated 'hash', used by the seeded hash tables (see hash_table_set_seed) if their hash function has no seeded counterpart
+ * NOTE: the keys having the same hash still collide whatever the seed is, see seeded_hash_function_t */
+COMMON_API hash_t hash_mix_seed(hash_t hash, hash_t seed);
+/* returns the seeded counterpart of 'hash_function' (e.g. string_hash_seeded for string_hash), NULL if it has none
+ * the integer hash functions have none, as they never collide (u64_mix is a bijection) */
+COMMON_API seeded_hash_function_t hash_function_get_seeded(hash_function_t hash_function);
+/* returns true if 'path' is compiled in, the SIMD ones depend on the instruction sets enabled for the build */
+COMMON_API bool bytes_hash_long_path_is_available(hash_function_long_path_t path);
+/* same as bytes_hash() with the long input path 'path' whatever 'size' is (it must be at least 64), all of them give the same hash values */
+COMMON_API hash_t bytes_hash_long_with_path(const void* bytes, u64 size, hash_t seed, hash_function_long_path_t path);
+
+/* the following ones can be used as hash_function_t */
 COMMON_API hash_t string_hash(void* v);
+/* same as string_hash, kept for compatibility (string_hash used to be limited to 2^16 - 1 characters) */
 COMMON_API hash_t large_string_hash(void* v);
+/* can be used as seeded_hash_function_t, same as string_hash with HASH_FUNCTION_DEFAULT_SEED */
+COMMON_API hash_t string_hash_seeded(void* v, hash_t seed);
 COMMON_API hash_t ptr_hash(void* v);
 COMMON_API hash_t s8_hash(void* v);
 #define char_hash(void_ptr) s8_hash(void_ptr)
@@ -8,36 +8,141 @@
 
 typedef buffer_t /* sub_buffer_handle_t */ bucket_handle_list_t;
 
+/* default maximum load factor (average number of key value pairs per bucket) of the chained hash tables */
+#ifndef HASH_TABLE_DEFAULT_MAX_LOAD_FACTOR
+#	define HASH_TABLE_DEFAULT_MAX_LOAD_FACTOR 1.0f
+#endif
+/* maximum load factor of the flat hash tables, at least one slot must always be empty */
+#define HASH_TABLE_FLAT_MAX_LOAD_FACTOR 0.875f
+/* number of (non-empty) buckets migrated from the old bucket list by each hash_table_add_get() or hash_table_remove() while rehashing */
+#ifndef HASH_TABLE_REHASH_STEP
+#	define HASH_TABLE_REHASH_STEP 4
+#endif
+
+typedef enum hash_table_storage_t
+{
+	/* buckets are sub buffers in a multi_buffer_t, each entry is a pointer to a separately allocated key value pair */
+	HASH_TABLE_STORAGE_CHAINED = 0,
+	/* open addressing (linear probing), the key value pairs are stored inline into one contiguous slab
+	 * and each slot has a control byte (empty, deleted, or 7 bits of the hash) which is checked before comparing the keys */
+	HASH_TABLE_STORAGE_FLAT
+} hash_table_storage_t;
+
+/* control bytes of the flat storage, a full slot stores the lower 7 bits of the (mixed) hash in its control byte, so the most significant bit of it is always zero
+ * the probe sequence of a hash starts at the slot H1(hash) & (slot_count - 1)
+ * NOTE: these are in the header only because com::HashTable (see HashTable.hpp) does the lookups inline */
+#define HASH_TABLE_FLAT_CTRL_EMPTY CAST_TO(u8, 0x80)
+#define HASH_TABLE_FLAT_CTRL_DELETED CAST_TO(u8, 0xFE)
+#define HASH_TABLE_FLAT_CTRL_IS_FULL(ctrl) (((ctrl) & 0x80) == 0)
+#define HASH_TABLE_FLAT_H1(hash) CAST_TO(u32, (hash) >> 7)
+#define HASH_TABLE_FLAT_H2(hash) CAST_TO(u8, (hash) & 0x7F)
+
+typedef struct hash_table_flat_storage_t
+{
+	/* contiguous memory block: 'slot_count' number of slots of 'stride' bytes each, followed by 'slot_count' control bytes */
+	u8* slots;
+	/* pointer to the control bytes, it points inside the memory block pointed by 'slots' */
+	u8* ctrl;
+	/* size of one slot (key + padding + value + padding) in bytes */
+	u32 stride;
+	/* number of slots, it is always a power of 2 */
+	u32 slot_count;
+	/* number of slots being occupied by key value pairs */
+	u32 count;
+	/* number of slots marked as deleted (tombstones), they are reclaimed upon the next rehash */
+	u32 tombstone_count;
+} hash_table_flat_storage_t;
+
 typedef struct hash_table_t
 {
 	/* allocation callbacks */
 	com_allocation_callbacks_t allocation_callbacks;
+	/* callbacks passed to __hash_table_create() (NULL for the std ones), the bucket lists keep a pointer to them */
+	com_allocation_callbacks_t* bucket_allocation_callbacks;
 	/* size of the key in bytes */
 	u32 key_size;
 	/* size of the value in bytes */
 	u32 value_size;
 	/* bucket count in the hash table
 	 * initially the hash table would have this number of buckets
-	 * and all the buckets would have a shared pool of pre-allocated memory for 'capacity' number of elements. */
+	 * and all the buckets would have a shared pool of pre-allocated memory for 'capacity' number of elements.
+	 * it is doubled (and rounded up to a power of 2) whenever the maximum load factor is exceeded. */
 	u32 bucket_count;
 	/* hash function to calculate hash of a key */
 	hash_function_t get_hash;
+	/* passed to 'get_seeded_hash', or mixed into each hash returned by 'get_hash' if it is NULL (see hash_function.h, hash_mix_seed), zero means no seed */
+	hash_t seed;
+	/* seeded counterpart of 'get_hash', used instead of it while 'seed' is not zero */
+	seeded_hash_function_t get_seeded_hash;
 	/* key comparer to compare a pair of keys for equality */
 	comparer_t is_equal;
 	/* (it's special data structure to store the buckets into one continguous memory block) */
 	multi_buffer_t buffer;
-	/* list of sub */
+	/* list of sub buffer handles, SUB_BUFFER_HANDLE_INVALID for the buckets which haven't been created yet */
 	bucket_handle_list_t bucket_handles;
+	/* number of key value pairs in the hash table */
+	u32 count;
+	/* the bucket count is doubled once count / bucket_count exceeds this, zero disables the automatic growth */
+	f32 max_load_factor;
+	/* while rehashing, the buckets before 'rehash_index' in the old bucket list have been migrated into the new one
+	 * and the rest are still being looked up in the old bucket list */
+	multi_buffer_t old_buffer;
+	bucket_handle_list_t old_bucket_handles;
+	/* zero if the hash table is not being rehashed */
+	u32 old_bucket_count;
+	u32 rehash_index;
+	/* storage layout of the key value pairs */
+	hash_table_storage_t storage;
+	/* offset of the value from the start of a key value pair, in bytes */
+	u32 value_offset;
+	/* only valid if storage is HASH_TABLE_STORAGE_FLAT */
+	hash_table_flat_storage_t flat;
 } hash_table_t;
 
 typedef hash_table_t* hash_table_ptr_t;
 
+/* snapshot of the bucket occupancy of a hash table, see hash_table_get_stats() */
+typedef struct hash_table_stats_t
+{
+	/* number of key value pairs */
+	u32 count;
+	/* number of buckets (including the old buckets not yet migrated while rehashing), or slots for the flat tables */
+	u32 bucket_count;
+	/* number of buckets (or slots) having no key value pairs */
+	u32 empty_bucket_count;
+	/* length of the longest bucket, or for the flat tables, length of the longest run of occupied (or deleted) slots */
+	u32 max_chain_length;
+	/* number of slots marked as deleted, always zero for the chained tables */
+	u32 tombstone_count;
+	/* count / bucket_count */
+	f32 load_factor;
+	/* count / (bucket_count - empty_bucket_count), average number of key value pairs in a non-empty bucket (or run of slots) */
+	f32 average_chain_length;
+} hash_table_stats_t;
+
 BEGIN_CPP_COMPATIBLE
 
+/* the user provided hash functions might be identity functions, so the flat tables mix the bits of each hash with this
+ * otherwise the control bytes of sequential keys would be all equal */
+static INLINE_IF_RELEASE_MODE CAN_BE_UNUSED_FUNCTION u64 hash_table_flat_mix_hash(hash_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
 /* constructor and destructors */
 // NOTE: bucket_count can never be zero, it must always be equal to or greater than 1
+// NOTE: *allocation_callbacks_ptr (if not NULL) must outlive the hash table, the bucket lists keep a pointer to it
 #define hash_table_create(Tkey, Tvalue, capacity, bucket_count, key_comparer, key_hash_function, allocation_callbacks_ptr) __hash_table_create(sizeof(Tkey), sizeof(Tvalue), capacity, bucket_count, key_comparer, key_hash_function, allocation_callbacks_ptr)
 COMMON_API hash_table_t __hash_table_create(u32 key_size, u32 value_size, u32 capacity, u32 bucket_count, comparer_t key_comparer, hash_function_t key_hash_function, com_allocation_callbacks_t* allocation_callbacks_ptr);
+/* creates a hash table with HASH_TABLE_STORAGE_FLAT storage, it has the same API as that of the chained one (hash_table_create)
+ * capacity: number of key value pairs which can be added without growing the slab, it can be zero.
+ * NOTE: pointers returned by hash_table_add_get() and hash_table_get_value() are invalidated when the slab grows,
+ * 		 and also, for the flat tables, hash_table_get_bucket_count() returns the number of slots. */
+#define hash_table_create_flat(Tkey, Tvalue, capacity, key_comparer, key_hash_function, allocation_callbacks_ptr) __hash_table_create_flat(sizeof(Tkey), sizeof(Tvalue), capacity, key_comparer, key_hash_function, allocation_callbacks_ptr)
+COMMON_API hash_table_t __hash_table_create_flat(u32 key_size, u32 value_size, u32 capacity, comparer_t key_comparer, hash_function_t key_hash_function, com_allocation_callbacks_t* allocation_callbacks_ptr);
 COMMON_API void hash_table_free(hash_table_t* table);
 
 /* clears the hash table and ready to be used again */
@@ -52,10 +157,31 @@ COMMON_API bool hash_table_remove(hash_table_t* table, void* key);
 COMMON_API bool hash_table_contains(hash_table_t* table, void* key);
 /* returns the number of key value pairs in the hash table */
 COMMON_API u32 hash_table_get_count(hash_table_t* table);
+/* fills 'out_stats' with the bucket occupancy of the hash table, it visits every bucket (or slot) so its O(bucket_count) */
+COMMON_API void hash_table_get_stats(hash_table_t* table, hash_table_stats_t* out_stats);
 /* returns then number of buckets in the hash table */
 static INLINE_IF_RELEASE_MODE CAN_BE_UNUSED_FUNCTION u32 hash_table_get_bucket_count(hash_table_t* table) { return table->bucket_count; }
+/* sets the maximum load factor, the hash table grows automatically (incrementally for the chained tables) once it is exceeded
+ * for the chained tables, zero disables the automatic growth, and for the flat tables, it is clamped to HASH_TABLE_FLAT_MAX_LOAD_FACTOR */
+COMMON_API void hash_table_set_max_load_factor(hash_table_t* table, f32 max_load_factor);
+/* returns the maximum load factor */
+static INLINE_IF_RELEASE_MODE CAN_BE_UNUSED_FUNCTION f32 hash_table_get_max_load_factor(hash_table_t* table) { return table->max_load_factor; }
+/* sets the seed mixed into every hash of the keys, a secret (random) seed makes the bucket indices unpredictable to an attacker flooding the table with colliding keys
+ * the keys are hashed with the seeded counterpart of the hash function (see hash_function_get_seeded) if there is one
+ * it can only be set while the hash table is empty, zero disables the seeding */
+COMMON_API void hash_table_set_seed(hash_table_t* table, hash_t seed);
+/* same as hash_table_set_seed() but the keys are hashed with 'seeded_hash_function', for the hash functions not known to hash_function_get_seeded() */
+COMMON_API void hash_table_set_seed_with(hash_table_t* table, hash_t seed, seeded_hash_function_t seeded_hash_function);
+/* returns the seed, zero if the hash table is not seeded */
+static INLINE_IF_RELEASE_MODE CAN_BE_UNUSED_FUNCTION hash_t hash_table_get_seed(hash_table_t* table) { return table->seed; }
+/* returns true if the buckets are still being migrated into a larger bucket list */
+static INLINE_IF_RELEASE_MODE CAN_BE_UNUSED_FUNCTION bool hash_table_is_rehashing(hash_table_t* table) { return table->old_bucket_count > 0; }
 /* returns pointer to the value by it's key, NULL if the key doesn't exists */
 COMMON_API void* hash_table_get_value(hash_table_t* table, void* key);
+/* looks up 'count' number of keys stored contiguously (key_size bytes each) in 'keys', and writes pointer to the value of i-th key into out_values[i] (NULL if it doesn't exist)
+ * it hashes a batch of keys first and issues software prefetches for their buckets before resolving them, so the cache misses overlap
+ * returns the number of keys found */
+COMMON_API u32 hash_table_get_values_batch(hash_table_t* table, void* keys, u32 count, void** out_values);
 /* visits each key value pairs in the hash table */
 COMMON_API void hash_table_foreach(hash_table_t* table, void (*visitor)(void* key, void* value, void* user_data), void* user_data);
 /* visits each key value pairs in the hash table until visitor returns false */
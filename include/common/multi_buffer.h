@@ -21,15 +21,73 @@ typedef struct sub_buffer_t
 
 typedef buffer_t /* sub_buffer_t */ sub_buffer_list_t;
 
+/* region of the master buffer which doesn't belong to any sub buffer, left behind by a sub buffer which moved to grow */
+typedef struct multi_buffer_hole_t
+{
+	/* offset at which the region starts in the master buffer */
+	buf_ucount_t ptr;
+	/* number of elements which the region can hold */
+	buf_ucount_t capacity;
+	/* index of the next hole in the same size class (or of the next unused hole record), MULTI_BUFFER_HOLE_INVALID if none */
+	u32 next;
+} multi_buffer_hole_t;
+
+typedef buffer_t /* multi_buffer_hole_t */ multi_buffer_hole_list_t;
+
+#define MULTI_BUFFER_HOLE_INVALID U32_MAX
+/* the holes are grouped by the size classes [2^i, 2^(i + 1)), the last one holds all the bigger holes too */
+#define MULTI_BUFFER_HOLE_CLASS_COUNT 32
+
+typedef id_generator_id_type_t sub_buffer_handle_t;
+#define SUB_BUFFER_HANDLE_INVALID ID_GENERATOR_ID_TYPE_MAX
+
+/* location of a sub buffer in the master buffer, sorted by 'ptr' while compacting */
+typedef struct sub_buffer_region_t
+{
+	buf_ucount_t ptr;
+	sub_buffer_handle_t handle;
+	/* index of the hole in between this sub buffer and the previous one, MULTI_BUFFER_HOLE_INVALID if none */
+	u32 hole;
+} sub_buffer_region_t;
+
+typedef buffer_t /* sub_buffer_region_t */ sub_buffer_region_list_t;
+
 typedef struct multi_buffer_t
 {
 	BUFFER buffer;			// contains contiguous memory for all the sub-buffers
 	id_generator_t id_gen;
 	sub_buffer_list_t sub_buffers;
+	/* a sub buffer which outgrows its capacity is extended in place if it is the last one in the master buffer,
+	 * otherwise it moves into a big enough hole or to the end of the master buffer, so no other sub buffer ever moves */
+	multi_buffer_hole_list_t holes;
+	/* index of the first hole of each size class */
+	u32 hole_heads[MULTI_BUFFER_HOLE_CLASS_COUNT];
+	/* index of the first unused hole record */
+	u32 free_hole_head;
+	/* combined capacity of all the holes */
+	buf_ucount_t hole_capacity;
+	/* progress of multi_buffer_compact_incremental() kept across the calls, it is dropped once a sub buffer is created, destroyed or grown */
+	bool is_compacting;
+	/* regions of the sub buffers sorted by their locations, the ones before 'compaction_index' have been compacted */
+	sub_buffer_region_list_t compaction_regions;
+	buf_ucount_t compaction_index;
+	/* end of the compacted part of the master buffer */
+	buf_ucount_t compaction_cursor;
 } multi_buffer_t;
 
-typedef id_generator_id_type_t sub_buffer_handle_t;
-#define SUB_BUFFER_HANDLE_INVALID ID_GENERATOR_ID_TYPE_MAX
+/* how much of the unused capacity of the sub buffers is released by multi_buffer_compact() */
+typedef enum multi_buffer_trim_policy_t
+{
+	/* capacities are kept as they are */
+	MULTI_BUFFER_TRIM_NONE = 0,
+	/* capacities are trimmed to the next power of 2 of the count, leaves room for the pushes which follow */
+	MULTI_BUFFER_TRIM_POWER_OF_TWO,
+	/* capacities are trimmed to the count */
+	MULTI_BUFFER_TRIM_EXACT
+} multi_buffer_trim_policy_t;
+
+/* NOTE: the consistency check of the whole multi buffer after each sub buffer creation, destruction, push and clear is O(number of sub buffers),
+ * so it is done only in the debug builds (COMMON_DEBUG), define COMMON_MULTI_BUFFER_VALIDATE to have it in the release builds too */
 
 BEGIN_CPP_COMPATIBLE
 
@@ -38,6 +96,7 @@ COMMON_API void multi_buffer_create(u32 element_size, u32 capacity, multi_buffer
 COMMON_API void multi_buffer_free(multi_buffer_t* buffer);
 
 // getters
+/* returns the number of elements in the master buffer, it includes the unused capacity of the sub buffers and the holes */
 COMMON_API buf_ucount_t multi_buffer_get_count(multi_buffer_t* buffer);
 COMMON_API buf_ucount_t multi_buffer_get_capacity(multi_buffer_t* buffer);
 COMMON_API buf_ucount_t multi_buffer_get_combined_sub_buffers_count(multi_buffer_t* multi_buffer);
@@ -46,7 +105,19 @@ COMMON_API buf_ucount_t multi_buffer_get_sub_buffer_count(multi_buffer_t* buffer
 
 // logic functions
 COMMON_API void multi_buffer_clear(multi_buffer_t* buffer);
+/* copies the elements of all the sub buffers into 'dst_ptr', in the order of their handles (not their locations in the master buffer) */
 COMMON_API void multi_buffer_flatcopy_to(multi_buffer_t* buffer, void* dst_ptr);
+/* moves the sub buffers towards the start of the master buffer (keeping their relative order) so that no holes are left in between,
+ * trims their capacities as per 'policy', releases the regions kept by the destroyed sub buffers, and shrinks the master buffer.
+ * the handles remain valid, but the pointers returned by multi_buffer_sub_buffer_get_ptr_at() are invalidated.
+ * returns the number of bytes by which the master buffer shrank */
+COMMON_API buf_ucount_t multi_buffer_compact(multi_buffer_t* buffer, multi_buffer_trim_policy_t policy);
+/* same as multi_buffer_compact(), but stops moving the sub buffers once 'time_budget_us' microseconds have elapsed (at least one is moved),
+ * the free space which is left is kept as holes, so calling it repeatedly (between the frames for example) eventually compacts fully.
+ * the sub buffers are sorted by their locations once, and each call resumes where the previous one has stopped, so it only costs the sub buffers it visits.
+ * the multi buffer can be modified in between, but creating, destroying or growing a sub buffer makes the next call start over.
+ * out_is_complete: (optional) set to true if the master buffer is fully compacted */
+COMMON_API buf_ucount_t multi_buffer_compact_incremental(multi_buffer_t* buffer, multi_buffer_trim_policy_t policy, u64 time_budget_us, bool* out_is_complete);
 
 // sub buffer
 
@@ -87,4 +158,11 @@ COMMON_API void* multi_buffer_sub_buffer_get_ptr_at(multi_buffer_t* buffer, sub_
 #define sub_buffer_get_ptr_at multi_buffer_sub_buffer_get_ptr_at
 #define sub_buffer_get_ptr(buffer, handle) sub_buffer_get_ptr_at(buffer, handle, 0)
 
+/* issues a software prefetch for the bookkeeping data of the sub buffer, to hide the cache miss of a following access to it */
+COMMON_API void multi_buffer_sub_buffer_prefetch(multi_buffer_t* buffer, sub_buffer_handle_t handle);
+/* issues a software prefetch for the first element of the sub buffer, does nothing if it is empty */
+COMMON_API void multi_buffer_sub_buffer_prefetch_elements(multi_buffer_t* buffer, sub_buffer_handle_t handle);
+#define sub_buffer_prefetch multi_buffer_sub_buffer_prefetch
+#define sub_buffer_prefetch_elements multi_buffer_sub_buffer_prefetch_elements
+
 END_CPP_COMPATIBLE
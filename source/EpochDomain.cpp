@@ -0,0 +1,165 @@
+#include <common/EpochDomain.hpp>
+#include <common/assert.h> // for _com_assert
+
+#include <limits> // for std::numeric_limits
+#include <thread> // for std::this_thread::yield()
+
+namespace com
+{
+	// Gives the thread's record back to the domain when the thread exits
+	struct ThreadReaderRecord
+	{
+		EpochDomain::ReaderRecord* record = nullptr;
+		std::mutex* domainMutex = nullptr;
+
+		~ThreadReaderRecord() noexcept
+		{
+			if(record == nullptr)
+				return;
+			std::lock_guard<std::mutex> lock(*domainMutex);
+			record->epoch.store(EpochDomain::QuiescentEpoch, std::memory_order_release);
+			record->nesting = 0;
+			record->isUsed = false;
+		}
+	};
+
+	static thread_local ThreadReaderRecord gThreadReaderRecord;
+
+	EpochDomain::EpochDomain() : m_epoch(1) { }
+
+	EpochDomain::~EpochDomain() noexcept
+	{
+		destroy(m_retiredObjects);
+	}
+
+	EpochDomain& EpochDomain::global()
+	{
+		static EpochDomain domain;
+		return domain;
+	}
+
+	EpochDomain::ReaderRecord* EpochDomain::getThreadRecord()
+	{
+		if(gThreadReaderRecord.record != nullptr)
+			return gThreadReaderRecord.record;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ReaderRecord* record = nullptr;
+		for(auto& unusedRecord : m_records)
+		{
+			if(!unusedRecord->isUsed)
+			{
+				record = unusedRecord.get();
+				break;
+			}
+		}
+		if(record == nullptr)
+		{
+			m_records.push_back(std::make_unique<ReaderRecord>());
+			record = m_records.back().get();
+		}
+		record->isUsed = true;
+		gThreadReaderRecord.record = record;
+		gThreadReaderRecord.domainMutex = &m_mutex;
+		return record;
+	}
+
+	void EpochDomain::enter() noexcept
+	{
+		ReaderRecord* record = getThreadRecord();
+		if(record->nesting++ > 0)
+			return;
+		// seq_cst, so a writer scanning the records after replacing an object either sees this epoch,
+		// or this reader loads the pointer to the new object (and never the replaced one)
+		record->epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+	}
+
+	void EpochDomain::exit() noexcept
+	{
+		ReaderRecord* record = gThreadReaderRecord.record;
+		_com_assert((record != nullptr) && (record->nesting > 0));
+		if(--record->nesting == 0)
+			record->epoch.store(QuiescentEpoch, std::memory_order_release);
+	}
+
+	u64 EpochDomain::getOldestEpoch() const noexcept
+	{
+		u64 oldestEpoch = std::numeric_limits<u64>::max();
+		for(auto& record : m_records)
+		{
+			u64 epoch = record->epoch.load(std::memory_order_seq_cst);
+			if((epoch != QuiescentEpoch) && (epoch < oldestEpoch))
+				oldestEpoch = epoch;
+		}
+		return oldestEpoch;
+	}
+
+	void EpochDomain::collect(std::vector<RetiredObject>& outObjects) noexcept
+	{
+		u64 oldestEpoch = getOldestEpoch();
+		std::size_t keptCount = 0;
+		for(auto& object : m_retiredObjects)
+		{
+			if(object.epoch < oldestEpoch)
+				outObjects.push_back(object);
+			else
+				m_retiredObjects[keptCount++] = object;
+		}
+		m_retiredObjects.resize(keptCount);
+	}
+
+	void EpochDomain::destroy(std::vector<RetiredObject>& objects) noexcept
+	{
+		for(auto& object : objects)
+			object.deleter(object.object);
+		objects.clear();
+	}
+
+	void EpochDomain::retire(void* object, void (*deleter)(void* object))
+	{
+		std::vector<RetiredObject> objects;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			// The readers which load the pointer from now on see the new object, and they will enter at the next epoch (or later)
+			u64 epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+			m_retiredObjects.push_back({ epoch, object, deleter });
+			collect(objects);
+		}
+		// Outside of the lock, as a destructor may retire another object
+		destroy(objects);
+	}
+
+	std::size_t EpochDomain::reclaim()
+	{
+		std::vector<RetiredObject> objects;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			collect(objects);
+		}
+		std::size_t count = objects.size();
+		destroy(objects);
+		return count;
+	}
+
+	void EpochDomain::synchronize()
+	{
+		_com_assert((gThreadReaderRecord.record == nullptr) || (gThreadReaderRecord.record->nesting == 0));
+		u64 epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+		while(true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				u64 oldestEpoch = getOldestEpoch();
+				if(oldestEpoch > epoch)
+					break;
+			}
+			std::this_thread::yield();
+		}
+		reclaim();
+	}
+
+	std::size_t EpochDomain::getRetiredCount() noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_retiredObjects.size();
+	}
+}
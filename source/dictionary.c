@@ -10,6 +10,233 @@
 	static void check_pre_condition(dictionary_t* dictionary);
 #endif /*GLOBAL_DEBUG*/
 
+// hash index
+#define INDEX_MIN_SLOT_COUNT 16
+
+static INLINE u32 get_key_hash(dictionary_t* dictionary, void* key)
+{
+	return CAST_TO(u32, dictionary->key_hash_function(key));
+}
+
+// returns the slot index at which 'key' is found, otherwise DICTIONARY_INDEX_SLOT_EMPTY (also see com::Dictionary::findIndex)
+static u32 index_find_slot(dictionary_t* dictionary, void* key)
+{
+	u32 hash = get_key_hash(dictionary, key);
+	u32 mask = dictionary->index_slot_count - 1;
+	// the index is at most half full, so the probing always ends at an empty slot
+	for(u32 i = hash & mask; ; i = (i + 1) & mask)
+	{
+		dictionary_index_slot_t* slot = &dictionary->index_slots[i];
+		if(slot->index == DICTIONARY_INDEX_SLOT_EMPTY)
+			return DICTIONARY_INDEX_SLOT_EMPTY;
+		if((slot->hash == hash) && dictionary->key_comparer(key, buf_get_ptr_at(&dictionary->buffer, slot->index)))
+			return i;
+	}
+}
+
+// returns the slot index which points to the key-value pair at 'index'
+static u32 index_find_slot_of(dictionary_t* dictionary, u32 index)
+{
+	u32 hash = get_key_hash(dictionary, buf_get_ptr_at(&dictionary->buffer, index));
+	u32 mask = dictionary->index_slot_count - 1;
+	for(u32 i = hash & mask; ; i = (i + 1) & mask)
+	{
+		_com_assert(dictionary->index_slots[i].index != DICTIONARY_INDEX_SLOT_EMPTY);
+		if(dictionary->index_slots[i].index == index)
+			return i;
+	}
+}
+
+static void index_insert(dictionary_t* dictionary, u32 hash, u32 index)
+{
+	u32 mask = dictionary->index_slot_count - 1;
+	u32 i = hash & mask;
+	while(dictionary->index_slots[i].index != DICTIONARY_INDEX_SLOT_EMPTY)
+		i = (i + 1) & mask;
+	dictionary->index_slots[i].hash = hash;
+	dictionary->index_slots[i].index = index;
+}
+
+// backward shift deletion, no tombstones are left behind
+static void index_erase_slot(dictionary_t* dictionary, u32 i)
+{
+	dictionary_index_slot_t* slots = dictionary->index_slots;
+	u32 mask = dictionary->index_slot_count - 1;
+	for(u32 j = (i + 1) & mask; slots[j].index != DICTIONARY_INDEX_SLOT_EMPTY; j = (j + 1) & mask)
+	{
+		// the slot 'j' can be moved into the slot 'i' only if its home slot doesn't lie cyclically in (i, j]
+		u32 home = slots[j].hash & mask;
+		if(((j - home) & mask) >= ((j - i) & mask))
+		{
+			slots[i] = slots[j];
+			i = j;
+		}
+	}
+	slots[i].index = DICTIONARY_INDEX_SLOT_EMPTY;
+}
+
+// the key-value pairs after 'index' have been shifted down by one
+static void index_on_pair_removed(dictionary_t* dictionary, u32 index)
+{
+	for(u32 i = 0; i < dictionary->index_slot_count; i++)
+		if((dictionary->index_slots[i].index != DICTIONARY_INDEX_SLOT_EMPTY) && (dictionary->index_slots[i].index > index))
+			dictionary->index_slots[i].index--;
+}
+
+static void index_rebuild(dictionary_t* dictionary, u32 slot_count)
+{
+	if(dictionary->index_slots != NULL)
+		heap_free(dictionary->index_slots);
+	dictionary->index_slots = heap_newv(dictionary_index_slot_t, slot_count);
+	dictionary->index_slot_count = slot_count;
+	memset(dictionary->index_slots, 0xFF, sizeof(dictionary_index_slot_t) * slot_count);
+	u32 count = CAST_TO(u32, buf_get_element_count(&dictionary->buffer));
+	for(u32 i = 0; i < count; i++)
+		index_insert(dictionary, get_key_hash(dictionary, buf_get_ptr_at(&dictionary->buffer, i)), i);
+}
+
+// makes sure the index stays at most half full with 'count' number of key-value pairs
+static void index_reserve(dictionary_t* dictionary, buf_ucount_t count)
+{
+	_com_assert(count < (U32_MAX >> 1));
+	if((count * 2) <= dictionary->index_slot_count)
+		return;
+	u32 slot_count = (dictionary->index_slot_count == 0) ? INDEX_MIN_SLOT_COUNT : dictionary->index_slot_count;
+	while(slot_count < (count * 2))
+		slot_count <<= 1;
+	index_rebuild(dictionary, slot_count);
+}
+
+// sorted storage
+static INLINE u32 get_pair_size(dictionary_t* dictionary)
+{
+	return dictionary->key_size + dictionary->value_size;
+}
+
+// returns the index of the first key-value pair whose key is not less than 'key'
+static buf_ucount_t sorted_lower_bound(dictionary_t* dictionary, void* key)
+{
+	buf_ucount_t count = buf_get_element_count(&dictionary->buffer);
+	if(count == 0)
+		return 0;
+	u8* pairs = buf_get_ptr(&dictionary->buffer);
+	u32 pair_size = get_pair_size(dictionary);
+	buf_ucount_t base = 0;
+	// always log2(count) iterations, the result of the comparison only selects the next base (conditional move)
+	// so there are no mispredicted branches, and both of the next candidates are prefetched meanwhile
+	while(count > 1)
+	{
+		buf_ucount_t half = count >> 1;
+		count -= half;
+		COM_PREFETCH_READ(pairs + (base + (count >> 1)) * pair_size);
+		COM_PREFETCH_READ(pairs + (base + half + (count >> 1)) * pair_size);
+		base = dictionary->key_less_than(pairs + (base + half) * pair_size, key) ? (base + half) : base;
+	}
+	return base + (dictionary->key_less_than(pairs + base * pair_size, key) ? 1 : 0);
+}
+
+// returns the index of the first key-value pair whose key is greater than 'key', so the equal keys keep their insertion order
+static buf_ucount_t sorted_upper_bound(dictionary_t* dictionary, void* key)
+{
+	buf_ucount_t count = buf_get_element_count(&dictionary->buffer);
+	buf_ucount_t index = sorted_lower_bound(dictionary, key);
+	while((index < count) && !dictionary->key_less_than(key, buf_get_ptr_at(&dictionary->buffer, index)))
+		index++;
+	return index;
+}
+
+static CAN_BE_UNUSED_FUNCTION bool sorted_is_in_order(dictionary_t* dictionary, buf_ucount_t index, void* key)
+{
+	BUFFER* buffer = &dictionary->buffer;
+	if((index > 0) && dictionary->key_less_than(key, buf_get_ptr_at(buffer, index - 1)))
+		return false;
+	if(((index + 1) < buf_get_element_count(buffer)) && dictionary->key_less_than(buf_get_ptr_at(buffer, index + 1), key))
+		return false;
+	return true;
+}
+
+// merges the sorted runs 'a' and 'b' into 'out', takes from 'b' only if its key is strictly less (stable)
+static void merge_pairs(dictionary_t* dictionary, u8* a, buf_ucount_t a_count, u8* b, buf_ucount_t b_count, u8* out)
+{
+	u32 pair_size = get_pair_size(dictionary);
+	while((a_count > 0) && (b_count > 0))
+	{
+		if(dictionary->key_less_than(b, a))
+		{
+			memcpy(out, b, pair_size);
+			b += pair_size;
+			b_count--;
+		}
+		else
+		{
+			memcpy(out, a, pair_size);
+			a += pair_size;
+			a_count--;
+		}
+		out += pair_size;
+	}
+	memcpy(out, a, a_count * pair_size);
+	memcpy(out + a_count * pair_size, b, b_count * pair_size);
+}
+
+// 'temp' must be large enough to hold 'count' number of key-value pairs
+static void merge_sort_pairs(dictionary_t* dictionary, u8* pairs, u8* temp, buf_ucount_t count)
+{
+	if(count < 2)
+		return;
+	u32 pair_size = get_pair_size(dictionary);
+	buf_ucount_t half = count >> 1;
+	merge_sort_pairs(dictionary, pairs, temp, half);
+	merge_sort_pairs(dictionary, pairs + half * pair_size, temp, count - half);
+	// already sorted input (quite common for the bulk loaded data) costs just one comparison per merge
+	if(!dictionary->key_less_than(pairs + half * pair_size, pairs + (half - 1) * pair_size))
+		return;
+	merge_pairs(dictionary, pairs, half, pairs + half * pair_size, count - half, temp);
+	memcpy(pairs, temp, count * pair_size);
+}
+
+// sorts the key-value pairs, the first 'sorted_count' of them are already sorted
+static void sort_pairs(dictionary_t* dictionary, buf_ucount_t sorted_count)
+{
+	buf_ucount_t count = buf_get_element_count(&dictionary->buffer);
+	if(count == sorted_count)
+		return;
+	u32 pair_size = get_pair_size(dictionary);
+	u8* pairs = buf_get_ptr(&dictionary->buffer);
+	u8* temp = heap_newv(u8, count * pair_size);
+	// sort the unsorted tail and then merge it with the sorted head
+	merge_sort_pairs(dictionary, pairs + sorted_count * pair_size, temp, count - sorted_count);
+	if((sorted_count > 0) && dictionary->key_less_than(pairs + sorted_count * pair_size, pairs + (sorted_count - 1) * pair_size))
+	{
+		merge_pairs(dictionary, pairs, sorted_count, pairs + sorted_count * pair_size, count - sorted_count, temp);
+		memcpy(pairs, temp, count * pair_size);
+	}
+	heap_free(temp);
+}
+
+static buf_ucount_t find_index_of(dictionary_t* dictionary, void* key)
+{
+	if(dictionary->key_less_than != NULL)
+	{
+		// the keys neither less nor greater than 'key' are not necessarily equal to it (string_less_than only compares the lengths)
+		// so the whole range of them is compared, it is a single key for the orders where equivalent means equal
+		buf_ucount_t count = buf_get_element_count(&dictionary->buffer);
+		for(buf_ucount_t index = sorted_lower_bound(dictionary, key); index < count; index++)
+		{
+			void* pair_key = buf_get_ptr_at(&dictionary->buffer, index);
+			if(dictionary->key_comparer(key, pair_key))
+				return index;
+			if(dictionary->key_less_than(key, pair_key))
+				break;
+		}
+		return BUF_INVALID_INDEX;
+	}
+	if(dictionary->key_hash_function == NULL)
+		return buf_find_index_of(&dictionary->buffer, key, dictionary->key_comparer);
+	u32 slot = index_find_slot(dictionary, key);
+	return (slot == DICTIONARY_INDEX_SLOT_EMPTY) ? BUF_INVALID_INDEX : dictionary->index_slots[slot].index;
+}
+
 // constructors and destructors
 COMMON_API dictionary_t __dictionary_create(u32 key_size, u32 value_size, u64 capacity, bool (*key_comparer)(void* compare_key, void* key))
 {
@@ -20,6 +247,27 @@ COMMON_API dictionary_t __dictionary_create(u32 key_size, u32 value_size, u64 ca
 	dictionary.key_comparer = key_comparer;
 	dictionary.key_size = key_size;
 	dictionary.value_size = value_size;
+	dictionary.key_hash_function = NULL;
+	dictionary.index_slots = NULL;
+	dictionary.index_slot_count = 0;
+	dictionary.key_less_than = NULL;
+	return dictionary;
+}
+
+COMMON_API dictionary_t __dictionary_create_hashed(u32 key_size, u32 value_size, u64 capacity, bool (*key_comparer)(void* compare_key, void* key), hash_function_t key_hash_function)
+{
+	_com_assert(key_hash_function != NULL);
+	dictionary_t dictionary = __dictionary_create(key_size, value_size, capacity, key_comparer);
+	dictionary.key_hash_function = key_hash_function;
+	index_reserve(&dictionary, (capacity == 0) ? 1 : capacity);
+	return dictionary;
+}
+
+COMMON_API dictionary_t __dictionary_create_sorted(u32 key_size, u32 value_size, u64 capacity, bool (*key_comparer)(void* compare_key, void* key), bool (*key_less_than)(void* lhs, void* rhs))
+{
+	_com_assert(key_less_than != NULL);
+	dictionary_t dictionary = __dictionary_create(key_size, value_size, capacity, key_comparer);
+	dictionary.key_less_than = key_less_than;
 	return dictionary;
 }
 
@@ -27,6 +275,8 @@ COMMON_API void dictionary_free(dictionary_t* dictionary)
 {
 	check_pre_condition(dictionary);
 	buf_free(&dictionary->buffer);
+	if(dictionary->index_slots != NULL)
+		heap_free(dictionary->index_slots);
 	memset(dictionary, 0, sizeof(dictionary_t));
 }
 
@@ -43,7 +293,7 @@ COMMON_API void dictionary_get_value(dictionary_t* dictionary, void* key, void*
 {
 	check_pre_condition(dictionary);
 	BUFFER* buffer = &dictionary->buffer;
-	void* ptr = buf_get_ptr_at(buffer, buf_find_index_of(buffer, key, dictionary->key_comparer));
+	void* ptr = buf_get_ptr_at(buffer, find_index_of(dictionary, key));
 	memcopyv(out_value, ptr + dictionary->key_size, u8, dictionary->value_size);
 }
 
@@ -51,7 +301,7 @@ COMMON_API bool dictionary_try_get_value_ptr(dictionary_t* dictionary, void* key
 {
 	check_pre_condition(dictionary);
 	BUFFER* buffer = &dictionary->buffer;
-	buf_ucount_t index = buf_find_index_of(buffer, key, dictionary->key_comparer);
+	buf_ucount_t index = find_index_of(dictionary, key);
 	if(index == BUF_INVALID_INDEX)
 		return false;
 	void* ptr = buf_get_ptr_at(buffer, index);
@@ -97,7 +347,7 @@ COMMON_API void* dictionary_get_value_ptr(dictionary_t* dictionary, void* key)
 {
 	check_pre_condition(dictionary);
 	BUFFER* buffer = &dictionary->buffer;
-	return buf_get_ptr_at(buffer, buf_find_index_of(buffer, key, dictionary->key_comparer)) + dictionary->key_size;
+	return buf_get_ptr_at(buffer, find_index_of(dictionary, key)) + dictionary->key_size;
 }
 
 COMMON_API u64 dictionary_get_count(dictionary_t* dictionary)
@@ -112,21 +362,39 @@ COMMON_API u64 dictionary_get_capacity(dictionary_t* dictionary)
 	return buf_get_capacity(&dictionary->buffer);
 }
 
+COMMON_API bool dictionary_is_hashed(dictionary_t* dictionary)
+{
+	check_pre_condition(dictionary);
+	return dictionary->key_hash_function != NULL;
+}
+
+COMMON_API bool dictionary_is_sorted(dictionary_t* dictionary)
+{
+	check_pre_condition(dictionary);
+	return dictionary->key_less_than != NULL;
+}
+
 
 // setters
 COMMON_API void dictionary_set_at(dictionary_t* dictionary, u64 index, void* in_key, void* in_value)
 {
 	check_pre_condition(dictionary);
 	void* ptr = buf_get_ptr_at(&dictionary->buffer, index);
+	// the key-value pairs of a sorted dictionary must stay sorted
+	_com_assert((dictionary->key_less_than == NULL) || sorted_is_in_order(dictionary, index, in_key));
+	if(dictionary->key_hash_function != NULL)
+		index_erase_slot(dictionary, index_find_slot_of(dictionary, CAST_TO(u32, index)));
 	memcopyv(ptr, in_key, u8, dictionary->key_size);
 	memcopyv(ptr + dictionary->key_size, in_value, u8, dictionary->value_size);
+	if(dictionary->key_hash_function != NULL)
+		index_insert(dictionary, get_key_hash(dictionary, in_key), CAST_TO(u32, index));
 }
 
 COMMON_API void dictionary_set_value(dictionary_t* dictionary, void* key, void* in_value)
 {
 	check_pre_condition(dictionary);
 	BUFFER* buffer = &dictionary->buffer;
-	void* ptr = buf_get_ptr_at(buffer, buf_find_index_of(buffer, key, dictionary->key_comparer));
+	void* ptr = buf_get_ptr_at(buffer, find_index_of(dictionary, key));
 	memcopyv(ptr + dictionary->key_size, in_value, u8, dictionary->value_size);
 }
 
@@ -138,16 +406,74 @@ COMMON_API void dictionary_set_value_at(dictionary_t* dictionary, u64 index, voi
 }
 
 // logic functions
+// appends 'count' number of key-value pairs and returns pointer to the first one, they must be written before calling end_append()
+// NOTE: buf_push_pseudo() zeros out the memory (there is no uninitialized version of it), but that is still cheaper
+//		 than copying each key-value pair into a temporary and then copying it again with buf_push()
+static void* begin_append(dictionary_t* dictionary, buf_ucount_t count)
+{
+	BUFFER* buffer = &dictionary->buffer;
+	buf_ucount_t old_count = buf_get_element_count(buffer);
+	// grow the index before the new pairs are visible to index_rebuild()
+	if(dictionary->key_hash_function != NULL)
+		index_reserve(dictionary, old_count + count);
+	buf_push_pseudo(buffer, count);
+	return buf_get_ptr_at(buffer, old_count);
+}
+
+// indexes the last 'count' number of key-value pairs, or restores the sorted order
+static void end_append(dictionary_t* dictionary, buf_ucount_t count)
+{
+	BUFFER* buffer = &dictionary->buffer;
+	buf_ucount_t new_count = buf_get_element_count(buffer);
+	if(dictionary->key_hash_function != NULL)
+		for(buf_ucount_t i = new_count - count; i < new_count; i++)
+			index_insert(dictionary, get_key_hash(dictionary, buf_get_ptr_at(buffer, i)), CAST_TO(u32, i));
+	if(dictionary->key_less_than != NULL)
+		sort_pairs(dictionary, new_count - count);
+}
+
+// returns pointer to the newly added key-value pair, the key is copied into it
+static void* add_key(dictionary_t* dictionary, void* in_key)
+{
+	void* ptr;
+	if(dictionary->key_less_than != NULL)
+	{
+		// insert at the right place instead of sorting
+		buf_ucount_t index = sorted_upper_bound(dictionary, in_key);
+		buf_insert_pseudo(&dictionary->buffer, index, 1);
+		ptr = buf_get_ptr_at(&dictionary->buffer, index);
+		memcopyv(ptr, in_key, u8, dictionary->key_size);
+	}
+	else
+	{
+		ptr = begin_append(dictionary, 1);
+		memcopyv(ptr, in_key, u8, dictionary->key_size);
+		end_append(dictionary, 1);
+	}
+	return ptr;
+}
+
 COMMON_API void dictionary_push(dictionary_t* dictionary, void* in_key, void* in_value)
 {
 	check_pre_condition(dictionary);
-	// NOTE: buf_push internally uses memcopyv, so here we are calling memcopyv two times more
-	//		 We could have used buf_push_pseudo(buffer, 1) but it internally uses memset(bytes, 0, size) which zeros out the memory
-	// TODO: So, create an another version of buf_push_pseudo leaving the memory uninitialized
-	u8 bytes[dictionary->key_size + dictionary->value_size];
-	memcopyv(bytes, in_key, u8, dictionary->key_size);
-	memcopyv(bytes + dictionary->key_size, in_value, u8, dictionary->value_size);
-	buf_push(&dictionary->buffer, bytes);
+	void* ptr = add_key(dictionary, in_key);
+	memcopyv(ptr + dictionary->key_size, in_value, u8, dictionary->value_size);
+}
+
+COMMON_API void* dictionary_emplace(dictionary_t* dictionary, void* in_key)
+{
+	check_pre_condition(dictionary);
+	return add_key(dictionary, in_key) + dictionary->key_size;
+}
+
+COMMON_API void dictionary_push_n(dictionary_t* dictionary, void* in_pairs, u64 count)
+{
+	check_pre_condition(dictionary);
+	if(count == 0)
+		return;
+	void* ptr = begin_append(dictionary, count);
+	memcpy(ptr, in_pairs, count * get_pair_size(dictionary));
+	end_append(dictionary, count);
 }
 
 COMMON_API void dictionary_pop(dictionary_t* dictionary, void* out_key, void* out_value)
@@ -156,32 +482,84 @@ COMMON_API void dictionary_pop(dictionary_t* dictionary, void* out_key, void* ou
 	void* ptr = buf_peek_ptr(&dictionary->buffer);
 	memcopyv(out_key, ptr, u8, dictionary->key_size);
 	memcopyv(out_value, ptr + dictionary->key_size, u8, dictionary->value_size);
+	if(dictionary->key_hash_function != NULL)
+		index_erase_slot(dictionary, index_find_slot_of(dictionary, CAST_TO(u32, buf_get_element_count(&dictionary->buffer) - 1)));
 	buf_pop(&dictionary->buffer, NULL);
 }
 
 COMMON_API void dictionary_remove(dictionary_t* dictionary, void* key)
 {
 	check_pre_condition(dictionary);
-	CAN_BE_UNUSED_VARIABLE bool result = buf_remove(&dictionary->buffer, key, dictionary->key_comparer);
-	_com_assert(result == true);
+	if(dictionary->key_less_than != NULL)
+	{
+		buf_ucount_t index = find_index_of(dictionary, key);
+		_com_assert(index != BUF_INVALID_INDEX);
+		buf_remove_at(&dictionary->buffer, index, NULL);
+		return;
+	}
+	if(dictionary->key_hash_function == NULL)
+	{
+		CAN_BE_UNUSED_VARIABLE bool result = buf_remove(&dictionary->buffer, key, dictionary->key_comparer);
+		_com_assert(result == true);
+		return;
+	}
+	u32 slot = index_find_slot(dictionary, key);
+	_com_assert(slot != DICTIONARY_INDEX_SLOT_EMPTY);
+	u32 index = dictionary->index_slots[slot].index;
+	index_erase_slot(dictionary, slot);
+	buf_remove_at(&dictionary->buffer, index, NULL);
+	if(index < buf_get_element_count(&dictionary->buffer))
+		index_on_pair_removed(dictionary, index);
 }
 
 COMMON_API bool dictionary_contains(dictionary_t* dictionary, void* key)
 {
 	check_pre_condition(dictionary);
-	return buf_find_index_of(&dictionary->buffer, key, dictionary->key_comparer) != BUF_INVALID_INDEX;
+	return find_index_of(dictionary, key) != BUF_INVALID_INDEX;
 }
 
 COMMON_API void dictionary_clear(dictionary_t* dictionary)
 {
 	check_pre_condition(dictionary);
 	buf_clear(&dictionary->buffer, NULL);
+	if(dictionary->index_slots != NULL)
+		memset(dictionary->index_slots, 0xFF, sizeof(dictionary_index_slot_t) * dictionary->index_slot_count);
 }
 
 COMMON_API u64 dictionary_find_index_of(dictionary_t* dictionary, void* key)
 {
 	check_pre_condition(dictionary);
-	return buf_find_index_of(&dictionary->buffer, key, dictionary->key_comparer);
+	return find_index_of(dictionary, key);
+}
+
+COMMON_API void dictionary_bulk_load(dictionary_t* dictionary, void* keys, void* values, u64 count)
+{
+	check_pre_condition(dictionary);
+	if(count == 0)
+		return;
+	u8* ptr = begin_append(dictionary, count);
+	u32 pair_size = get_pair_size(dictionary);
+	for(buf_ucount_t i = 0; i < count; i++, ptr += pair_size)
+	{
+		memcopyv(ptr, keys + i * dictionary->key_size, u8, dictionary->key_size);
+		memcopyv(ptr + dictionary->key_size, values + i * dictionary->value_size, u8, dictionary->value_size);
+	}
+	end_append(dictionary, count);
+}
+
+COMMON_API void dictionary_freeze(dictionary_t* dictionary, bool (*key_less_than)(void* lhs, void* rhs))
+{
+	check_pre_condition(dictionary);
+	_com_assert(key_less_than != NULL);
+	if(dictionary->index_slots != NULL)
+		heap_free(dictionary->index_slots);
+	dictionary->index_slots = NULL;
+	dictionary->index_slot_count = 0;
+	dictionary->key_hash_function = NULL;
+	// already sorted with the same order
+	buf_ucount_t sorted_count = (dictionary->key_less_than == key_less_than) ? buf_get_element_count(&dictionary->buffer) : 0;
+	dictionary->key_less_than = key_less_than;
+	sort_pairs(dictionary, sorted_count);
 }
 
 COMMON_API bool dictionary_key_comparer_u16(void* v1, void* v2)
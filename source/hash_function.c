@@ -2,91 +2,431 @@
 #include <common/assert.h>
 #include <string.h>
 
-COMMON_API hash_t string_hash(void* v)
+/* the widest of the compiled in implementations of the long input path is used, the rest are only reachable through bytes_hash_long_with_path() */
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define HASH_FUNCTION_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define HASH_FUNCTION_HAS_SSE2
+#	ifndef HASH_FUNCTION_USE_AVX2
+#		define HASH_FUNCTION_USE_SSE2
+#	endif
+#endif
+
+/* inputs longer than this (in bytes) are hashed with the multi-lane path, it has a fixed setup cost
+ * and on the SSE2 only builds the 3 lanes of wyhash are about as fast as the 128 bit SIMD lanes, so it kicks in much later */
+#ifndef HASH_FUNCTION_LONG_INPUT_THRESHOLD
+#	ifdef HASH_FUNCTION_USE_AVX2
+#		define HASH_FUNCTION_LONG_INPUT_THRESHOLD 2048
+#	else
+#		define HASH_FUNCTION_LONG_INPUT_THRESHOLD 65536
+#	endif
+#endif
+
+/* wyhash constants */
+static const u64 wy_secret[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+/* random odd constants for the long input path, each stripe 's' of a block uses the keys [s, s + 8) */
+#define LONG_LANE_COUNT 8
+#define LONG_STRIPE_SIZE (LONG_LANE_COUNT * sizeof(u64))
+#define LONG_BLOCK_STRIPE_COUNT 16
+#define LONG_KEY_COUNT (LONG_BLOCK_STRIPE_COUNT + LONG_LANE_COUNT)
+/* keys used to scramble the accumulators after each block, to mix the last stripe, and to merge the accumulators */
+#define LONG_SCRAMBLE_KEY_OFFSET (LONG_KEY_COUNT - LONG_LANE_COUNT)
+#define LONG_LAST_STRIPE_KEY_OFFSET (LONG_SCRAMBLE_KEY_OFFSET - 7)
+#define LONG_MERGE_KEY_OFFSET 3
+#define LONG_PRIME32 0x9E3779B1U
+static const u64 long_secret[LONG_KEY_COUNT] =
 {
-	const char* str = DEREF_TO(const char*, v);
-	u32 _dbg_hash = strlen(str);
-	_com_assert(_dbg_hash < U16_MAX);
-	u16 hash1 = CAST_TO(u16, _dbg_hash);
-	u16 hash2 = 0;
-	u32 hash3 = 0;
-	for(u16 i = 0; i < hash1; i++)
+	0xdaeb8ebd244a330dULL, 0x685bd8519d0023dbULL, 0x959ef8713231c2cbULL, 0xd1ea2fa4dd9af44dULL,
+	0xa402cba46b82bdddULL, 0x4f7580cd7b17a39fULL, 0xc8b045b99d6fb287ULL, 0xceca0ca0c351e0a7ULL,
+	0x38987f53584df3c9ULL, 0xbb74476ee0b6e30fULL, 0xa309f5fba2117b35ULL, 0xf901131499f29aadULL,
+	0x6568525f65be34afULL, 0xe61c980e7426b629ULL, 0xf330a10b9efe9905ULL, 0x39381640553d574dULL,
+	0x0e6c783bd0d3aac1ULL, 0xe2b445a3cb88bb31ULL, 0x42381838bf9d61afULL, 0x475b2af9c112b40fULL,
+	0x9d73761a2479742fULL, 0xa5869770cc27fdbbULL, 0x0ce9fcba3e066d3bULL, 0x40254dfc5f952ddbULL
+};
+
+static INLINE_IF_RELEASE_MODE u64 read_u64(const u8* ptr) { u64 value; memcpy(&value, ptr, sizeof(u64)); return value; }
+static INLINE_IF_RELEASE_MODE u64 read_u32(const u8* ptr) { u32 value; memcpy(&value, ptr, sizeof(u32)); return value; }
+/* reads 1, 2 or 3 bytes */
+static INLINE_IF_RELEASE_MODE u64 read_u24(const u8* ptr, u64 size) { return (CAST_TO(u64, ptr[0]) << 16) | (CAST_TO(u64, ptr[size >> 1]) << 8) | ptr[size - 1]; }
+
+/* 64 x 64 = 128 bit multiplication, 'a' receives the lower 64 bits and 'b' receives the upper 64 bits */
+static INLINE_IF_RELEASE_MODE void multiply_128(u64* a, u64* b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t result = CAST_TO(__uint128_t, *a) * (*b);
+	*a = CAST_TO(u64, result);
+	*b = CAST_TO(u64, result >> 64);
+#else
+	u64 ha = *a >> 32, hb = *b >> 32, la = CAST_TO(u32, *a), lb = CAST_TO(u32, *b);
+	u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	u64 t = rl + (rm0 << 32);
+	u64 c = t < rl;
+	u64 lo = t + (rm1 << 32);
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/* folds the 128 bit product of 'a' and 'b' into 64 bits */
+static INLINE_IF_RELEASE_MODE u64 wy_mix(u64 a, u64 b)
+{
+	multiply_128(&a, &b);
+	return a ^ b;
+}
+
+/* wyhash (final version 4), it is fast for the short inputs as it consumes them in one or two 128 bit multiplications */
+static hash_t bytes_hash_short(const u8* ptr, u64 size, hash_t seed)
+{
+	seed ^= wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+	u64 a, b;
+	if(size <= 16)
+	{
+		if(size >= 4)
+		{
+			/* two (possibly overlapping) 4 byte reads from either ends */
+			u64 offset = (size >> 3) << 2;
+			a = (read_u32(ptr) << 32) | read_u32(ptr + offset);
+			b = (read_u32(ptr + size - 4) << 32) | read_u32(ptr + size - 4 - offset);
+		}
+		else if(size > 0)
+		{
+			a = read_u24(ptr, size);
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
 	{
-		hash2 ^= CAST_TO(u16, str[i]);
-		hash3 += str[i];
+		u64 i = size;
+		if(i > 48)
+		{
+			/* three independent lanes */
+			u64 seed1 = seed, seed2 = seed;
+			do
+			{
+				seed = wy_mix(read_u64(ptr) ^ wy_secret[1], read_u64(ptr + 8) ^ seed);
+				seed1 = wy_mix(read_u64(ptr + 16) ^ wy_secret[2], read_u64(ptr + 24) ^ seed1);
+				seed2 = wy_mix(read_u64(ptr + 32) ^ wy_secret[3], read_u64(ptr + 40) ^ seed2);
+				ptr += 48;
+				i -= 48;
+			} while(i > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while(i > 16)
+		{
+			seed = wy_mix(read_u64(ptr) ^ wy_secret[1], read_u64(ptr + 8) ^ seed);
+			i -= 16;
+			ptr += 16;
+		}
+		a = read_u64(ptr + i - 16);
+		b = read_u64(ptr + i - 8);
 	}
-	return CAST_TO(hash_t, BIT64_PACK32(BIT32_PACK16(hash1, hash2), hash3));
+	a ^= wy_secret[1];
+	b ^= seed;
+	multiply_128(&a, &b);
+	return wy_mix(a ^ wy_secret[0] ^ size, b ^ wy_secret[1]);
 }
 
-COMMON_API hash_t large_string_hash(void* v)
+/* accumulates 'stripe_count' number of consecutive stripes, the stripe 's' is mixed with the keys [s, s + 8)
+ * each lane does acc[i] += lo32(data ^ key) * hi32(data ^ key) and acc[i ^ 1] += data, so all the lanes are independent
+ * NOTE: all the three implementations produce the same hash values */
+typedef void (*long_accumulate_t)(u64* acc, const u8* ptr, u64 stripe_count, const u64* keys);
+typedef void (*long_scramble_t)(u64* acc, const u64* keys);
+
+#if defined(HASH_FUNCTION_USE_AVX2)
+/* one register worth (4 lanes) of the accumulation, the shuffles operate within each 128 bit half */
+#define LONG_ACCUMULATE_AVX2(xacc, xdata, xkeys)\
+{\
+	__m256i data = _mm256_loadu_si256(xdata);\
+	__m256i data_key = _mm256_xor_si256(data, _mm256_loadu_si256(xkeys));\
+	__m256i product = _mm256_mul_epu32(data_key, _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));\
+	xacc = _mm256_add_epi64(product, _mm256_add_epi64(xacc, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));\
+}
+
+static void long_accumulate_avx2(u64* acc, const u8* ptr, u64 stripe_count, const u64* keys)
 {
-	const char* str = DEREF_TO(const char*, v);
-	u32 _dbg_hash = strlen(str);
-	u16 hash1 = CAST_TO(u16, _dbg_hash % U16_MAX);
-	u16 hash2 = CAST_TO(u16, _dbg_hash >> 2);
-	u32 hash3 = 0;
-	for(u16 i = 0; i < hash1; i++)
+	__m256i xacc0 = _mm256_loadu_si256(CAST_TO(const __m256i*, acc) + 0);
+	__m256i xacc1 = _mm256_loadu_si256(CAST_TO(const __m256i*, acc) + 1);
+	for(u64 s = 0; s < stripe_count; s++)
+	{
+		const __m256i* xdata = CAST_TO(const __m256i*, ptr + s * LONG_STRIPE_SIZE);
+		const __m256i* xkeys = CAST_TO(const __m256i*, keys + s);
+		LONG_ACCUMULATE_AVX2(xacc0, xdata + 0, xkeys + 0);
+		LONG_ACCUMULATE_AVX2(xacc1, xdata + 1, xkeys + 1);
+	}
+	_mm256_storeu_si256(CAST_TO(__m256i*, acc) + 0, xacc0);
+	_mm256_storeu_si256(CAST_TO(__m256i*, acc) + 1, xacc1);
+}
+
+static void long_scramble_avx2(u64* acc, const u64* keys)
+{
+	const __m256i prime = _mm256_set1_epi32(CAST_TO(s32, LONG_PRIME32));
+	for(u32 i = 0; i < (LONG_LANE_COUNT / 4); i++)
+	{
+		__m256i a = _mm256_loadu_si256(CAST_TO(const __m256i*, acc) + i);
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, _mm256_loadu_si256(CAST_TO(const __m256i*, keys) + i));
+		/* 64 x 32 bit multiplication as (lo32 * prime) + ((hi32 * prime) << 32) */
+		__m256i product_lo = _mm256_mul_epu32(a, prime);
+		__m256i product_hi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		_mm256_storeu_si256(CAST_TO(__m256i*, acc) + i, _mm256_add_epi64(product_lo, _mm256_slli_epi64(product_hi, 32)));
+	}
+}
+#endif /* HASH_FUNCTION_USE_AVX2 */
+
+#if defined(HASH_FUNCTION_HAS_SSE2)
+/* one register worth (2 lanes) of the accumulation, unrolled by hand as the compilers keep the accumulators in the memory otherwise */
+#define LONG_ACCUMULATE_SSE2(xacc, xdata, xkeys)\
+{\
+	__m128i data = _mm_loadu_si128(xdata);\
+	__m128i data_key = _mm_xor_si128(data, _mm_loadu_si128(xkeys));\
+	/* lo32 * hi32 of each 64 bit lane */\
+	__m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));\
+	/* swap the 64 bit lanes, so that the data of the lane i is added into the lane i ^ 1 */\
+	xacc = _mm_add_epi64(product, _mm_add_epi64(xacc, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));\
+}
+
+static void long_accumulate_sse2(u64* acc, const u8* ptr, u64 stripe_count, const u64* keys)
+{
+	__m128i xacc0 = _mm_loadu_si128(CAST_TO(const __m128i*, acc) + 0);
+	__m128i xacc1 = _mm_loadu_si128(CAST_TO(const __m128i*, acc) + 1);
+	__m128i xacc2 = _mm_loadu_si128(CAST_TO(const __m128i*, acc) + 2);
+	__m128i xacc3 = _mm_loadu_si128(CAST_TO(const __m128i*, acc) + 3);
+	for(u64 s = 0; s < stripe_count; s++)
+	{
+		const __m128i* xdata = CAST_TO(const __m128i*, ptr + s * LONG_STRIPE_SIZE);
+		const __m128i* xkeys = CAST_TO(const __m128i*, keys + s);
+		LONG_ACCUMULATE_SSE2(xacc0, xdata + 0, xkeys + 0);
+		LONG_ACCUMULATE_SSE2(xacc1, xdata + 1, xkeys + 1);
+		LONG_ACCUMULATE_SSE2(xacc2, xdata + 2, xkeys + 2);
+		LONG_ACCUMULATE_SSE2(xacc3, xdata + 3, xkeys + 3);
+	}
+	_mm_storeu_si128(CAST_TO(__m128i*, acc) + 0, xacc0);
+	_mm_storeu_si128(CAST_TO(__m128i*, acc) + 1, xacc1);
+	_mm_storeu_si128(CAST_TO(__m128i*, acc) + 2, xacc2);
+	_mm_storeu_si128(CAST_TO(__m128i*, acc) + 3, xacc3);
+}
+
+static void long_scramble_sse2(u64* acc, const u64* keys)
+{
+	const __m128i prime = _mm_set1_epi32(CAST_TO(s32, LONG_PRIME32));
+	for(u32 i = 0; i < (LONG_LANE_COUNT / 2); i++)
+	{
+		__m128i a = _mm_loadu_si128(CAST_TO(const __m128i*, acc) + i);
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a, _mm_loadu_si128(CAST_TO(const __m128i*, keys) + i));
+		/* 64 x 32 bit multiplication as (lo32 * prime) + ((hi32 * prime) << 32) */
+		__m128i product_lo = _mm_mul_epu32(a, prime);
+		__m128i product_hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		_mm_storeu_si128(CAST_TO(__m128i*, acc) + i, _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32)));
+	}
+}
+#endif /* HASH_FUNCTION_HAS_SSE2 */
+
+static void long_accumulate_scalar(u64* acc, const u8* ptr, u64 stripe_count, const u64* keys)
+{
+	for(u64 s = 0; s < stripe_count; s++)
+	{
+		const u8* stripe = ptr + s * LONG_STRIPE_SIZE;
+		for(u32 i = 0; i < LONG_LANE_COUNT; i++)
+		{
+			u64 data = read_u64(stripe + i * sizeof(u64));
+			u64 data_key = data ^ keys[s + i];
+			acc[i ^ 1] += data;
+			acc[i] += (data_key & 0xFFFFFFFFULL) * (data_key >> 32);
+		}
+	}
+}
+
+static void long_scramble_scalar(u64* acc, const u64* keys)
+{
+	for(u32 i = 0; i < LONG_LANE_COUNT; i++)
 	{
-		hash2 ^= CAST_TO(u16, str[i]);
-		hash3 += str[i];
+		u64 a = acc[i];
+		a ^= a >> 47;
+		a ^= keys[i];
+		acc[i] = a * LONG_PRIME32;
 	}
-	return CAST_TO(hash_t, BIT64_PACK32(BIT32_PACK16(hash1, hash2), hash3));
+}
+
+/* xxh3 style accumulation into 8 lanes of 64 bit each, the lanes map onto the SIMD registers (2 with AVX2 or 4 with SSE2)
+ * 'long_accumulate' and 'long_scramble' are constants at each call site, so they are inlined in the release builds */
+static INLINE_IF_RELEASE_MODE hash_t bytes_hash_long_with(const u8* ptr, u64 size, hash_t seed, long_accumulate_t long_accumulate, long_scramble_t long_scramble)
+{
+	/* derive the keys from the seed, the stripes would commute if they were mixed with the same keys */
+	u64 keys[LONG_KEY_COUNT];
+	for(u32 i = 0; i < LONG_KEY_COUNT; i++)
+		keys[i] = (i & 1) ? (long_secret[i] - seed) : (long_secret[i] + seed);
+
+	u64 acc[LONG_LANE_COUNT] = { LONG_PRIME32, wy_secret[0], wy_secret[1], wy_secret[2], wy_secret[3], long_secret[0], long_secret[1], LONG_PRIME32 };
+
+	/* the last stripe is always processed separately (it overlaps with the previous stripe if the size is not a multiple of the stripe size) */
+	u64 stripe_count = (size - 1) / LONG_STRIPE_SIZE;
+	u64 block_count = stripe_count / LONG_BLOCK_STRIPE_COUNT;
+	for(u64 i = 0; i < block_count; i++)
+	{
+		long_accumulate(acc, ptr + i * LONG_BLOCK_STRIPE_COUNT * LONG_STRIPE_SIZE, LONG_BLOCK_STRIPE_COUNT, keys);
+		long_scramble(acc, keys + LONG_SCRAMBLE_KEY_OFFSET);
+	}
+	long_accumulate(acc, ptr + block_count * LONG_BLOCK_STRIPE_COUNT * LONG_STRIPE_SIZE, stripe_count % LONG_BLOCK_STRIPE_COUNT, keys);
+	long_accumulate(acc, ptr + size - LONG_STRIPE_SIZE, 1, keys + LONG_LAST_STRIPE_KEY_OFFSET);
+
+	/* merge the lanes pairwise */
+	u64 hash = size * wy_secret[0] ^ seed;
+	for(u32 i = 0; i < LONG_LANE_COUNT; i += 2)
+		hash += wy_mix(acc[i] ^ keys[LONG_MERGE_KEY_OFFSET + i], acc[i + 1] ^ keys[LONG_MERGE_KEY_OFFSET + i + 1]);
+	return u64_mix(hash);
+}
+
+static hash_t bytes_hash_long(const u8* ptr, u64 size, hash_t seed)
+{
+#if defined(HASH_FUNCTION_USE_AVX2)
+	return bytes_hash_long_with(ptr, size, seed, long_accumulate_avx2, long_scramble_avx2);
+#elif defined(HASH_FUNCTION_USE_SSE2)
+	return bytes_hash_long_with(ptr, size, seed, long_accumulate_sse2, long_scramble_sse2);
+#else
+	return bytes_hash_long_with(ptr, size, seed, long_accumulate_scalar, long_scramble_scalar);
+#endif
+}
+
+COMMON_API bool bytes_hash_long_path_is_available(hash_function_long_path_t path)
+{
+	switch(path)
+	{
+		case HASH_FUNCTION_LONG_PATH_SCALAR: return true;
+#if defined(HASH_FUNCTION_HAS_SSE2)
+		case HASH_FUNCTION_LONG_PATH_SSE2: return true;
+#endif
+#if defined(HASH_FUNCTION_USE_AVX2)
+		case HASH_FUNCTION_LONG_PATH_AVX2: return true;
+#endif
+		default: return false;
+	}
+}
+
+COMMON_API hash_t bytes_hash_long_with_path(const void* bytes, u64 size, hash_t seed, hash_function_long_path_t path)
+{
+	com_assert(COM_DESCRIPTION(size >= LONG_STRIPE_SIZE), "The long input path needs at least one stripe (64 bytes)");
+	com_assert(COM_DESCRIPTION(bytes_hash_long_path_is_available(path)), "The long input path is not compiled in");
+	const u8* ptr = CAST_TO(const u8*, bytes);
+	switch(path)
+	{
+#if defined(HASH_FUNCTION_USE_AVX2)
+		case HASH_FUNCTION_LONG_PATH_AVX2: return bytes_hash_long_with(ptr, size, seed, long_accumulate_avx2, long_scramble_avx2);
+#endif
+#if defined(HASH_FUNCTION_HAS_SSE2)
+		case HASH_FUNCTION_LONG_PATH_SSE2: return bytes_hash_long_with(ptr, size, seed, long_accumulate_sse2, long_scramble_sse2);
+#endif
+		default: return bytes_hash_long_with(ptr, size, seed, long_accumulate_scalar, long_scramble_scalar);
+	}
+}
+
+COMMON_API hash_t bytes_hash(const void* bytes, u64 size, hash_t seed)
+{
+	if(size > HASH_FUNCTION_LONG_INPUT_THRESHOLD)
+		return bytes_hash_long(CAST_TO(const u8*, bytes), size, seed);
+	return bytes_hash_short(CAST_TO(const u8*, bytes), size, seed);
+}
+
+COMMON_API hash_t u64_mix(u64 value)
+{
+	/* moremur, a stronger variant of the splitmix64 finalizer */
+	value ^= value >> 27;
+	value *= 0x3C79AC492BA7B653ULL;
+	value ^= value >> 33;
+	value *= 0x1C69B3F74AC4AE35ULL;
+	value ^= value >> 27;
+	return value;
+}
+
+COMMON_API hash_t hash_mix_seed(hash_t hash, hash_t seed)
+{
+	return wy_mix(hash ^ wy_secret[0], seed ^ wy_secret[1]);
+}
+
+COMMON_API hash_t string_hash(void* v)
+{
+	const char* str = DEREF_TO(const char*, v);
+	return bytes_hash(str, strlen(str), HASH_FUNCTION_DEFAULT_SEED);
+}
+
+COMMON_API hash_t large_string_hash(void* v)
+{
+	return string_hash(v);
+}
+
+COMMON_API hash_t string_hash_seeded(void* v, hash_t seed)
+{
+	const char* str = DEREF_TO(const char*, v);
+	return bytes_hash(str, strlen(str), seed);
+}
+
+COMMON_API seeded_hash_function_t hash_function_get_seeded(hash_function_t hash_function)
+{
+	if((hash_function == string_hash) || (hash_function == large_string_hash))
+		return string_hash_seeded;
+	return NULL;
 }
 
 COMMON_API hash_t ptr_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(char* const, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(char* const, v)));
 }
 
 COMMON_API hash_t s8_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(s8, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(s8, v)));
 }
 
 COMMON_API hash_t s16_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(s16, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(s16, v)));
 }
 
 COMMON_API hash_t s32_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(s32, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(s32, v)));
 }
 
 COMMON_API hash_t s64_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(s64, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(s64, v)));
 }
 
 COMMON_API hash_t u8_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(u8, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(u8, v)));
 }
 
 COMMON_API hash_t u16_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(u16, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(u16, v)));
 }
 
 COMMON_API hash_t u32_hash(void* v)
 {
-	return CAST_TO(hash_t, CAST_TO(u64, DREF_TO(u32, v)));
+	return u64_mix(CAST_TO(u64, DREF_TO(u32, v)));
 }
 
 COMMON_API hash_t u64_hash(void* v)
 {
-	return CAST_TO(hash_t, DREF_TO(u64, v));
+	return u64_mix(DREF_TO(u64, v));
 }
 
 COMMON_API hash_t float_hash(void* v)
 {
 	com_debug_log_warning("You are trying to calculate hash of a float value %f, which is prone to miss calculation", DREF_TO(f32, v));
-	return CAST_TO(hash_t, REINTERPRET_TO(u32, DREF_TO(f32, v)));
+	return u64_mix(CAST_TO(u64, REINTERPRET_TO(u32, DREF_TO(f32, v))));
 }
 
 COMMON_API hash_t double_hash(void* v)
 {
 	com_debug_log_warning("You are trying to calculate hash of a double value %f, which is prone to miss calculation", DREF_TO(f64, v));
-	return CAST_TO(hash_t, REINTERPRET_TO(u64, DREF_TO(f64, v)));
+	return u64_mix(REINTERPRET_TO(u64, DREF_TO(f64, v)));
 }
-
@@ -3,78 +3,258 @@
 #include <common/debug.h>
 #include <common/assert.h>
 
+static void flat_free(hash_table_t* table);
+static void flat_clear(hash_table_t* table);
+static void* flat_add_get(hash_table_t* table, void* key, void* value);
+static bool flat_remove(hash_table_t* table, void* key);
+static void* flat_get_value(hash_table_t* table, void* key);
+static void flat_foreach_until(hash_table_t* table, bool (*visitor)(void* key, void* value, void* user_data), void* user_data);
+static void flat_get_stats(hash_table_t* table, hash_table_stats_t* stats);
+static void flat_get_values_window(hash_table_t* table, void* keys, u32 count, void** out_values);
+
+static INLINE_IF_RELEASE_MODE hash_t get_key_hash(hash_table_t* table, void* key)
+{
+	if(table->seed == 0)
+		return table->get_hash(key);
+	if(table->get_seeded_hash != NULL)
+		return table->get_seeded_hash(key, table->seed);
+	return hash_mix_seed(table->get_hash(key), table->seed);
+}
+
+static void buckets_create(com_allocation_callbacks_t* callbacks, u32 bucket_count, u32 capacity, multi_buffer_t* out_buffer, bucket_handle_list_t* out_handles)
+{
+	/* create buffer to store hash table entries */
+	multi_buffer_create(sizeof(void*), capacity, out_buffer);
+
+	/* the buckets (sub buffers) are created lazily upon the first push into them */
+	*out_handles = buf_create_with_callbacks(callbacks, sizeof(sub_buffer_handle_t), bucket_count, 0);
+	buf_push_pseudo(out_handles, bucket_count);
+	sub_buffer_handle_t* handles = CAST_TO(sub_buffer_handle_t*, buf_get_ptr(out_handles));
+	for(u32 i = 0; i < bucket_count; i++)
+		handles[i] = SUB_BUFFER_HANDLE_INVALID;
+}
+
+static void buckets_free(multi_buffer_t* buffer, bucket_handle_list_t* handles)
+{
+	buf_free(handles);
+	multi_buffer_free(buffer);
+}
+
 COMMON_API hash_table_t __hash_table_create(u32 key_size, u32 value_size, u32 capacity, u32 bucket_count, comparer_t key_comparer, hash_function_t key_hash_function, com_allocation_callbacks_t* allocation_callbacks_ptr)
 {
 	com_assert(COM_DESCRIPTION(bucket_count >= 1), "Bucket count must always be >= 1");
 	hash_table_t table =
 	{
 		.allocation_callbacks = allocation_callbacks_ptr ? *allocation_callbacks_ptr : com_allocation_callbacks_get_std(),
+		.bucket_allocation_callbacks = allocation_callbacks_ptr,
 		.key_size = key_size,
 		.value_size = value_size,
 		.bucket_count = bucket_count,
 		.get_hash = key_hash_function,
 		.is_equal = key_comparer,
-		.bucket_handles = buf_create_with_callbacks(allocation_callbacks_ptr, sizeof(sub_buffer_handle_t), capacity, 0)
+		.storage = HASH_TABLE_STORAGE_CHAINED,
+		.value_offset = key_size,
+		.max_load_factor = HASH_TABLE_DEFAULT_MAX_LOAD_FACTOR
 	};
 
-	/* create buffer to store hash table entries */
-	multi_buffer_create(sizeof(void*), capacity, &table.buffer);
+	buckets_create(table.bucket_allocation_callbacks, bucket_count, capacity, &table.buffer, &table.bucket_handles);
+	return table;
+}
+
+static INLINE_IF_RELEASE_MODE sub_buffer_handle_t get_handle_at(bucket_handle_list_t* handles, u32 index)
+{
+	return DREF_TO(sub_buffer_handle_t, buf_get_ptr_at(handles, index));
+}
+
+/* calls 'visitor' for each key value pair in the buckets [begin, end), returns false if the visitor stopped it */
+static bool buckets_foreach_until(hash_table_t* table, multi_buffer_t* buffer, bucket_handle_list_t* handles, u32 begin, u32 end, bool (*visitor)(void* key, void* value, void* user_data), void* user_data)
+{
+	for(u32 i = begin; i < end; i++)
+	{
+		/* get the bucket handle */
+		sub_buffer_handle_t bucket_handle = get_handle_at(handles, i);
+		if(bucket_handle == SUB_BUFFER_HANDLE_INVALID)
+			continue;
 
-	/* create buckets */
+		/* for each key value pair in the bucket */
+		u32 count = sub_buffer_get_count(buffer, bucket_handle);
+		for(u32 j = 0; j < count; j++)
+		{
+			/* visit */
+			void* pair = DREF_VOID_PTR(sub_buffer_get_ptr_at(buffer, bucket_handle, j));
+			if(!visitor(pair, pair + table->value_offset, user_data))
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool deallocate_pair(void* key, void*, void* user_data)
+{
+	com_deallocate(CAST_TO(com_allocation_callbacks_t*, user_data), key);
+	return true;
+}
+
+static void buckets_clear(multi_buffer_t* buffer, bucket_handle_list_t* handles)
+{
+	u32 bucket_count = buf_get_element_count(handles);
 	for(u32 i = 0; i < bucket_count; i++)
 	{
-		AUTO handle = multi_buffer_sub_buffer_create(&table.buffer, 1);
-		buf_push(&table.bucket_handles, &handle);
+		sub_buffer_handle_t bucket_handle = get_handle_at(handles, i);
+		if(bucket_handle != SUB_BUFFER_HANDLE_INVALID)
+			multi_buffer_sub_buffer_clear(buffer, bucket_handle);
 	}
+}
 
-	return table;
+/* ends the rehash, the buckets in the old bucket list must have been migrated or their key value pairs deallocated */
+static void end_rehash(hash_table_t* table)
+{
+	buckets_free(&table->old_buffer, &table->old_bucket_handles);
+	table->old_bucket_count = 0;
+	table->rehash_index = 0;
 }
 
 COMMON_API void hash_table_free(hash_table_t* table)
 {
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+	{
+		flat_free(table);
+		return;
+	}
 	hash_table_clear(table);
-	buf_free(&table->bucket_handles);
-	multi_buffer_free(&table->buffer);
+	buckets_free(&table->buffer, &table->bucket_handles);
 }
 
 COMMON_API void hash_table_clear(hash_table_t* table)
 {
-	u32 bucket_count = buf_get_element_count(&table->bucket_handles);
-	for(u32 i = 0; i < bucket_count; i++)
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
 	{
-		/* get the bucket handle */
-		sub_buffer_handle_t bucket_handle;
-		buf_get_at(&table->bucket_handles, i, &bucket_handle);
+		flat_clear(table);
+		return;
+	}
 
-		/* for each key value pair in the bucket */
-		u32 count = sub_buffer_get_count(&table->buffer, bucket_handle);
+	/* free the key value pair memory blocks */
+	if(hash_table_is_rehashing(table))
+	{
+		buckets_foreach_until(table, &table->old_buffer, &table->old_bucket_handles, table->rehash_index, table->old_bucket_count, deallocate_pair, &table->allocation_callbacks);
+		end_rehash(table);
+	}
+	buckets_foreach_until(table, &table->buffer, &table->bucket_handles, 0, table->bucket_count, deallocate_pair, &table->allocation_callbacks);
+	buckets_clear(&table->buffer, &table->bucket_handles);
+	table->count = 0;
+}
+
+static INLINE_IF_RELEASE_MODE u32 get_bucket_index(hash_t hash, u32 bucket_count)
+{
+	/* power of 2 bucket counts (the bucket count is always a power of 2 after the first growth) don't need the modulo */
+	if((bucket_count & (bucket_count - 1)) == 0)
+		return CAST_TO(u32, hash & (bucket_count - 1));
+	return CAST_TO(u32, hash % bucket_count);
+}
+
+/* reference to the bucket which contains (or would contain) a key */
+typedef struct bucket_ref_t
+{
+	multi_buffer_t* buffer;
+	bucket_handle_list_t* handles;
+	u32 index;
+	/* SUB_BUFFER_HANDLE_INVALID if the bucket hasn't been created yet */
+	sub_buffer_handle_t handle;
+} bucket_ref_t;
+
+static bucket_ref_t make_bucket_ref(multi_buffer_t* buffer, bucket_handle_list_t* handles, u32 index)
+{
+	return (bucket_ref_t) { buffer, handles, index, get_handle_at(handles, index) };
+}
+
+/* same as get_bucket() but the bucket handle is left SUB_BUFFER_HANDLE_INVALID, so that it can be prefetched before being read */
+static bucket_ref_t locate_bucket(hash_table_t* table, hash_t hash)
+{
+	/* while rehashing, the buckets in the old bucket list which haven't been migrated yet still own their keys */
+	if(hash_table_is_rehashing(table))
+	{
+		u32 index = get_bucket_index(hash, table->old_bucket_count);
+		if(index >= table->rehash_index)
+			return (bucket_ref_t) { &table->old_buffer, &table->old_bucket_handles, index, SUB_BUFFER_HANDLE_INVALID };
+	}
+	return (bucket_ref_t) { &table->buffer, &table->bucket_handles, get_bucket_index(hash, table->bucket_count), SUB_BUFFER_HANDLE_INVALID };
+}
+
+static bucket_ref_t get_bucket(hash_table_t* table, void* key)
+{
+	bucket_ref_t bucket = locate_bucket(table, get_key_hash(table, key));
+	bucket.handle = get_handle_at(bucket.handles, bucket.index);
+	return bucket;
+}
+
+static void bucket_push(bucket_ref_t* bucket, void* key_value_pair)
+{
+	if(bucket->handle == SUB_BUFFER_HANDLE_INVALID)
+	{
+		bucket->handle = multi_buffer_sub_buffer_create(bucket->buffer, 1);
+		buf_set_at(bucket->handles, bucket->index, &bucket->handle);
+	}
+	sub_buffer_push(bucket->buffer, bucket->handle, &key_value_pair);
+}
+
+/* migrates at most 'bucket_steps' non-empty buckets from the old bucket list into the new one */
+static void rehash_step(hash_table_t* table, u32 bucket_steps)
+{
+	/* bound the number of empty buckets visited too */
+	u32 empty_visits = bucket_steps * 8;
+	while((bucket_steps > 0) && (table->rehash_index < table->old_bucket_count))
+	{
+		sub_buffer_handle_t handle = get_handle_at(&table->old_bucket_handles, table->rehash_index);
+		u32 count = (handle == SUB_BUFFER_HANDLE_INVALID) ? 0 : sub_buffer_get_count(&table->old_buffer, handle);
+		table->rehash_index++;
+		if(count == 0)
+		{
+			if(--empty_visits == 0)
+				break;
+			continue;
+		}
 		for(u32 j = 0; j < count; j++)
 		{
-			/* free the key value pair memory block  */
-			com_deallocate(&table->allocation_callbacks, DREF_VOID_PTR(sub_buffer_get_ptr_at(&table->buffer, bucket_handle, j)));
+			void* pair = DREF_VOID_PTR(sub_buffer_get_ptr_at(&table->old_buffer, handle, j));
+			bucket_ref_t bucket = make_bucket_ref(&table->buffer, &table->bucket_handles, get_bucket_index(get_key_hash(table, pair), table->bucket_count));
+			bucket_push(&bucket, pair);
 		}
-
-		multi_buffer_sub_buffer_clear(&table->buffer, bucket_handle);
+		bucket_steps--;
 	}
+	if(table->rehash_index == table->old_bucket_count)
+		end_rehash(table);
 }
 
-static u32 get_bucket_index(hash_table_t* table, void* key)
+static u32 get_next_power_of_two(u64 value)
 {
-	return table->get_hash(key) % table->bucket_count;
+	u64 power = 1;
+	while(power < value)
+		power <<= 1;
+	com_assert(COM_DESCRIPTION(power <= BIT32(31)), "Bucket count is getting too large");
+	return CAST_TO(u32, power);
 }
 
-static sub_buffer_handle_t get_bucket_handle(hash_table_t* table, void* key)
+static void begin_rehash_if_needed(hash_table_t* table)
 {
-	sub_buffer_handle_t bucket_handle;
-	buf_get_at(&table->bucket_handles, get_bucket_index(table, key), &bucket_handle);
-	return bucket_handle;
+	if(hash_table_is_rehashing(table) || (table->max_load_factor <= 0))
+		return;
+	if(CAST_TO(f32, table->count) <= (CAST_TO(f32, table->bucket_count) * table->max_load_factor))
+		return;
+
+	/* the current bucket list becomes the old one, and its buckets are migrated a few at a time by the subsequent operations */
+	table->old_buffer = table->buffer;
+	table->old_bucket_handles = table->bucket_handles;
+	table->old_bucket_count = table->bucket_count;
+	table->rehash_index = 0;
+	table->bucket_count = get_next_power_of_two(CAST_TO(u64, table->bucket_count) * 2);
+	buckets_create(table->bucket_allocation_callbacks, table->bucket_count, table->count, &table->buffer, &table->bucket_handles);
 }
 
 static void* create_key_value_pair(hash_table_t* table, void* key, void* value)
 {
 	void* buffer = com_allocate(&table->allocation_callbacks, table->key_size + table->value_size);
 	memcpy(buffer, key, table->key_size);
-	memcpy(buffer + table->key_size, value, table->value_size);
+	memcpy(buffer + table->value_offset, value, table->value_size);
 	return buffer;
 }
 
@@ -86,13 +266,27 @@ static bool is_equal(void* lhs, void* rhs)
 	return pair->first->is_equal(CAST_TO(void*, DREF_TO(u8*, (void**)lhs)), pair->second);
 }
 
+static buf_ucount_t bucket_find_index_of(hash_table_t* table, bucket_ref_t* bucket, void* key)
+{
+	if(bucket->handle == SUB_BUFFER_HANDLE_INVALID)
+		return BUF_INVALID_INDEX;
+	pair_t(hash_table_ptr_t, void_ptr_t) pair = { table, key };
+	return sub_buffer_find_index_of(bucket->buffer, bucket->handle, &pair, is_equal);
+}
+
 COMMON_API void* hash_table_add_get(hash_table_t* table, void* key, void* value)
-{	/* get handle to the bucket */
-	sub_buffer_handle_t bucket_handle = get_bucket_handle(table, key);
+{
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+		return flat_add_get(table, key, value);
+
+	if(hash_table_is_rehashing(table))
+		rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+	/* get the bucket */
+	bucket_ref_t bucket = get_bucket(table, key);
 
 	/* if a key with the same hash already exists then don't add */
-	pair_t(hash_table_ptr_t, void_ptr_t) pair = { table, key };
-	if(sub_buffer_find_index_of(&table->buffer, bucket_handle, &pair, is_equal) != BUF_INVALID_INDEX)
+	if(bucket_find_index_of(table, &bucket, key) != BUF_INVALID_INDEX)
 	{
 		com_debug_log_warning("Failed to add key value pair as a key with the same hash already exists in the hash table");
 		return NULL;
@@ -101,8 +295,10 @@ COMMON_API void* hash_table_add_get(hash_table_t* table, void* key, void* value)
 	/* create key value pair in the heap memory */
 	void* key_value_pair = create_key_value_pair(table, key, value);
 	/* add the key value pair into the bucket */
-	sub_buffer_push(&table->buffer, bucket_handle, &key_value_pair);
-	return key_value_pair + table->key_size;
+	bucket_push(&bucket, key_value_pair);
+	table->count++;
+	begin_rehash_if_needed(table);
+	return key_value_pair + table->value_offset;
 }
 
 COMMON_API void hash_table_add(hash_table_t* table, void* key, void* value)
@@ -110,99 +306,445 @@ COMMON_API void hash_table_add(hash_table_t* table, void* key, void* value)
 	hash_table_add_get(table, key, value);
 }
 
-static void** __hash_table_get_value(hash_table_t* table, void* key)
+COMMON_API bool hash_table_remove(hash_table_t* table, void* key)
 {
-	AUTO bucket_handle = get_bucket_handle(table, key);
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+		return flat_remove(table, key);
+
+	if(hash_table_is_rehashing(table))
+		rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+	bucket_ref_t bucket = get_bucket(table, key);
+	AUTO index = bucket_find_index_of(table, &bucket, key);
+	if(index == BUF_INVALID_INDEX)
+		return false;
+	void* _ptr = DREF_VOID_PTR(sub_buffer_get_ptr_at(bucket.buffer, bucket.handle, index));
 	pair_t(hash_table_ptr_t, void_ptr_t) pair = { table, key };
-	AUTO index = sub_buffer_find_index_of(&table->buffer, bucket_handle, &pair, is_equal);
+	CAN_BE_UNUSED_VARIABLE bool result = sub_buffer_remove(bucket.buffer, bucket.handle, &pair, is_equal);
+	_COM_ASSERT(result == true);
+	com_deallocate(&table->allocation_callbacks, _ptr);
+	table->count--;
+	return true;
+}
+
+COMMON_API bool hash_table_contains(hash_table_t* table, void* key)
+{
+	return hash_table_get_value(table, key) != NULL;
+}
+
+COMMON_API u32 hash_table_get_count(hash_table_t* table)
+{
+	/* the count is maintained by hash_table_add_get() and hash_table_remove(), so no need to visit the buckets */
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+		return table->flat.count;
+	return table->count;
+}
+
+static void buckets_get_stats(multi_buffer_t* buffer, bucket_handle_list_t* handles, u32 begin, u32 end, hash_table_stats_t* stats)
+{
+	for(u32 i = begin; i < end; i++)
+	{
+		sub_buffer_handle_t bucket_handle = get_handle_at(handles, i);
+		/* the buckets which haven't been created yet are empty */
+		u32 length = (bucket_handle == SUB_BUFFER_HANDLE_INVALID) ? 0 : sub_buffer_get_count(buffer, bucket_handle);
+		if(length == 0)
+			stats->empty_bucket_count++;
+		else if(length > stats->max_chain_length)
+			stats->max_chain_length = length;
+	}
+	stats->bucket_count += end - begin;
+}
+
+COMMON_API void hash_table_get_stats(hash_table_t* table, hash_table_stats_t* out_stats)
+{
+	hash_table_stats_t stats = { .count = hash_table_get_count(table) };
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+		flat_get_stats(table, &stats);
+	else
+	{
+		/* while rehashing, only the old buckets in [rehash_index, old_bucket_count) are still live */
+		if(table->old_bucket_count > 0)
+			buckets_get_stats(&table->old_buffer, &table->old_bucket_handles, table->rehash_index, table->old_bucket_count, &stats);
+		buckets_get_stats(&table->buffer, &table->bucket_handles, 0, table->bucket_count, &stats);
+	}
+	u32 non_empty_bucket_count = stats.bucket_count - stats.empty_bucket_count;
+	stats.load_factor = (stats.bucket_count > 0) ? (CAST_TO(f32, stats.count) / CAST_TO(f32, stats.bucket_count)) : 0.0f;
+	stats.average_chain_length = (non_empty_bucket_count > 0) ? (CAST_TO(f32, stats.count) / CAST_TO(f32, non_empty_bucket_count)) : 0.0f;
+	*out_stats = stats;
+}
+
+COMMON_API void* hash_table_get_value(hash_table_t* table, void* key)
+{
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+		return flat_get_value(table, key);
+	bucket_ref_t bucket = get_bucket(table, key);
+	AUTO index = bucket_find_index_of(table, &bucket, key);
 	/* if not found then return NULL */
 	if(index == BUF_INVALID_INDEX)
 		return NULL;
 	/* otherwise a valid value */
-	return CAST_TO(void**, sub_buffer_get_ptr_at(&table->buffer, bucket_handle, index));
+	return DREF_VOID_PTR(sub_buffer_get_ptr_at(bucket.buffer, bucket.handle, index)) + table->value_offset;
 }
 
-COMMON_API bool hash_table_remove(hash_table_t* table, void* key)
+/* number of keys whose buckets are prefetched before resolving any of them, enough to keep the memory busy without evicting the prefetched lines */
+#define BATCH_WINDOW_SIZE 16
+
+/* each pass over the window touches memory which was prefetched by the previous pass, so the dependent cache misses of one key overlap with those of the other keys */
+static void get_values_window(hash_table_t* table, void* keys, u32 count, void** out_values)
 {
-	void** ptr = __hash_table_get_value(table, key);
-	void* _ptr = NULL;
-	if(ptr != NULL)
-		_ptr = DREF_VOID_PTR(ptr);
-	pair_t(hash_table_ptr_t, void_ptr_t) pair = { table, key };
-	bool result = sub_buffer_remove(&table->buffer, get_bucket_handle(table, key), &pair, is_equal);
-	if(ptr != NULL)
+	bucket_ref_t buckets[BATCH_WINDOW_SIZE];
+	/* hash all the keys and prefetch the bucket handles */
+	for(u32 i = 0; i < count; i++)
+	{
+		buckets[i] = locate_bucket(table, get_key_hash(table, keys + i * table->key_size));
+		COM_PREFETCH_READ(buf_get_ptr_at(buckets[i].handles, buckets[i].index));
+	}
+	/* read the bucket handles and prefetch the sub buffers */
+	for(u32 i = 0; i < count; i++)
 	{
-		_COM_ASSERT(result == true);
-		com_deallocate(&table->allocation_callbacks, _ptr);
+		buckets[i].handle = get_handle_at(buckets[i].handles, buckets[i].index);
+		if(buckets[i].handle != SUB_BUFFER_HANDLE_INVALID)
+			sub_buffer_prefetch(buckets[i].buffer, buckets[i].handle);
+	}
+	/* prefetch the entries (pointers to the key value pairs) of the buckets */
+	for(u32 i = 0; i < count; i++)
+		if(buckets[i].handle != SUB_BUFFER_HANDLE_INVALID)
+			sub_buffer_prefetch_elements(buckets[i].buffer, buckets[i].handle);
+	/* prefetch the first key value pair of each bucket, it is the only one for the most of the buckets if the load factor is <= 1 */
+	for(u32 i = 0; i < count; i++)
+		if((buckets[i].handle != SUB_BUFFER_HANDLE_INVALID) && (sub_buffer_get_count(buckets[i].buffer, buckets[i].handle) > 0))
+			COM_PREFETCH_READ(DREF_VOID_PTR(sub_buffer_get_ptr_at(buckets[i].buffer, buckets[i].handle, 0)));
+	/* resolve */
+	for(u32 i = 0; i < count; i++)
+	{
+		void* key = keys + i * table->key_size;
+		AUTO index = bucket_find_index_of(table, &buckets[i], key);
+		out_values[i] = (index == BUF_INVALID_INDEX) ? NULL : (DREF_VOID_PTR(sub_buffer_get_ptr_at(buckets[i].buffer, buckets[i].handle, index)) + table->value_offset);
 	}
-	return result;
 }
 
-COMMON_API bool hash_table_contains(hash_table_t* table, void* key)
+COMMON_API u32 hash_table_get_values_batch(hash_table_t* table, void* keys, u32 count, void** out_values)
 {
-	pair_t(hash_table_ptr_t, void_ptr_t) pair = { table, key };
-	return sub_buffer_find_index_of(&table->buffer, get_bucket_handle(table, key), &pair, is_equal) != BUF_INVALID_INDEX;
+	u32 found_count = 0;
+	for(u32 i = 0; i < count; i += BATCH_WINDOW_SIZE)
+	{
+		u32 window_size = ((count - i) < BATCH_WINDOW_SIZE) ? (count - i) : BATCH_WINDOW_SIZE;
+		if(table->storage == HASH_TABLE_STORAGE_FLAT)
+			flat_get_values_window(table, keys + i * table->key_size, window_size, out_values + i);
+		else
+			get_values_window(table, keys + i * table->key_size, window_size, out_values + i);
+		for(u32 j = 0; j < window_size; j++)
+			found_count += (out_values[i + j] != NULL) ? 1 : 0;
+	}
+	return found_count;
 }
 
-static void accumulate(void*, void*, void* user_data)
+COMMON_API void hash_table_set_max_load_factor(hash_table_t* table, f32 max_load_factor)
 {
-	DREF_TO(u32, user_data) += 1;
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+	{
+		com_assert(COM_DESCRIPTION(max_load_factor > 0), "Automatic growth can't be disabled for a flat hash table");
+		table->max_load_factor = (max_load_factor > HASH_TABLE_FLAT_MAX_LOAD_FACTOR) ? HASH_TABLE_FLAT_MAX_LOAD_FACTOR : max_load_factor;
+		return;
+	}
+	table->max_load_factor = max_load_factor;
 }
 
-COMMON_API u32 hash_table_get_count(hash_table_t* table)
+COMMON_API void hash_table_set_seed(hash_table_t* table, hash_t seed)
 {
-	u32 count = 0;
-	hash_table_foreach(table, accumulate, (void*)&count);
-	return count;
+	hash_table_set_seed_with(table, seed, hash_function_get_seeded(table->get_hash));
 }
 
-COMMON_API void* hash_table_get_value(hash_table_t* table, void* key)
+COMMON_API void hash_table_set_seed_with(hash_table_t* table, hash_t seed, seeded_hash_function_t seeded_hash_function)
 {
-	void* ptr = __hash_table_get_value(table, key);
-	if(ptr == NULL)
-		return NULL;
-	return DREF_VOID_PTR(ptr) + table->key_size;
+	/* the key value pairs already added would be in the wrong buckets */
+	com_assert(COM_DESCRIPTION(hash_table_get_count(table) == 0), "Seed can only be set while the hash table is empty");
+	table->seed = seed;
+	table->get_seeded_hash = seeded_hash_function;
+}
+
+typedef void (*hash_table_visitor_t)(void* key, void* value, void* user_data);
+typedef_pair_t(hash_table_visitor_t, void_ptr_t);
+
+static bool visit_all(void* key, void* value, void* user_data)
+{
+	AUTO pair = CAST_TO(pair_t(hash_table_visitor_t, void_ptr_t)*, user_data);
+	pair->first(key, value, pair->second);
+	return true;
 }
 
 COMMON_API void hash_table_foreach(hash_table_t* table, void (*visitor)(void* key, void* value, void* user_data), void* user_data)
 {
+	pair_t(hash_table_visitor_t, void_ptr_t) pair = { visitor, user_data };
+	hash_table_foreach_until(table, visit_all, &pair);
+}
+
+COMMON_API void hash_table_foreach_until(hash_table_t* table, bool (*visitor)(void* key, void* value, void* user_data), void* user_data)
+{
+	if(table->storage == HASH_TABLE_STORAGE_FLAT)
+	{
+		flat_foreach_until(table, visitor, user_data);
+		return;
+	}
+	/* for each bucket which hasn't been migrated yet */
+	if(hash_table_is_rehashing(table))
+	{
+		if(!buckets_foreach_until(table, &table->old_buffer, &table->old_bucket_handles, table->rehash_index, table->old_bucket_count, visitor, user_data))
+			return;
+	}
 	/* for each bucket */
-	u32 bucket_count = buf_get_element_count(&table->bucket_handles);
-	for(u32 i = 0; i < bucket_count; i++)
+	buckets_foreach_until(table, &table->buffer, &table->bucket_handles, 0, table->bucket_count, visitor, user_data);
+}
+
+/* ------------------------------ flat (open addressing) storage ------------------------------ */
+
+#define FLAT_MIN_SLOT_COUNT 8
+#define FLAT_INVALID_INDEX U32_MAX
+
+/* returns the largest power of 2 which divides 'size', clamped to 8 */
+static u32 get_natural_alignment(u32 size)
+{
+	if(size == 0)
+		return 1;
+	u32 align = size & (~size + 1);
+	return (align > 8) ? 8 : align;
+}
+
+/* returns the number of slots needed to hold 'capacity' number of key value pairs without exceeding the maximum load factor (7/8) */
+static u32 get_flat_slot_count(u32 capacity)
+{
+	u64 required = (CAST_TO(u64, capacity) * 8 + 6) / 7;
+	u64 slot_count = FLAT_MIN_SLOT_COUNT;
+	while(slot_count < required)
+		slot_count <<= 1;
+	com_assert(COM_DESCRIPTION(slot_count <= BIT32(31)), "Requested capacity is too large for a flat hash table");
+	return CAST_TO(u32, slot_count);
+}
+
+static INLINE_IF_RELEASE_MODE u8* get_flat_slot(hash_table_flat_storage_t* flat, u32 index)
+{
+	return flat->slots + CAST_TO(u64, index) * flat->stride;
+}
+
+static void flat_storage_allocate(hash_table_t* table, u32 slot_count)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	u64 size = CAST_TO(u64, slot_count) * (flat->stride + 1);
+	com_assert(COM_DESCRIPTION(size <= U32_MAX), "Flat hash table slab can't be larger than 4 GB");
+	flat->slots = com_allocate(&table->allocation_callbacks, CAST_TO(u32, size));
+	flat->ctrl = get_flat_slot(flat, 0) + CAST_TO(u64, slot_count) * flat->stride;
+	flat->slot_count = slot_count;
+	flat->count = 0;
+	flat->tombstone_count = 0;
+	memset(flat->ctrl, HASH_TABLE_FLAT_CTRL_EMPTY, slot_count);
+	table->bucket_count = slot_count;
+}
+
+/* returns index of the slot containing 'key', otherwise FLAT_INVALID_INDEX (com::HashTable::findIndex() does the same inline) */
+static u32 flat_find_index(hash_table_t* table, void* key, u64 hash)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	u32 mask = flat->slot_count - 1;
+	u8 h2 = HASH_TABLE_FLAT_H2(hash);
+	/* there is always at least one empty slot, so this loop always terminates */
+	for(u32 i = HASH_TABLE_FLAT_H1(hash) & mask;; i = (i + 1) & mask)
 	{
-		/* get the bucket handle */
-		sub_buffer_handle_t bucket_handle;
-		buf_get_at(&table->bucket_handles, i, &bucket_handle);
+		u8 ctrl = flat->ctrl[i];
+		if(ctrl == HASH_TABLE_FLAT_CTRL_EMPTY)
+			return FLAT_INVALID_INDEX;
+		/* compare the keys only if the control byte matches */
+		if((ctrl == h2) && table->is_equal(get_flat_slot(flat, i), key))
+			return i;
+	}
+}
 
-		/* for each key value pair in the bucket */
-		u32 count = sub_buffer_get_count(&table->buffer, bucket_handle);
-		for(u32 j = 0; j < count; j++)
-		{
-			/* visit */
-			void* pair = DREF_VOID_PTR(sub_buffer_get_ptr_at(&table->buffer, bucket_handle, j));
-			visitor(pair, pair + table->key_size, user_data);
-		}
+/* returns index of the first empty or deleted slot in the probe sequence of 'hash' */
+static u32 flat_find_insert_index(hash_table_flat_storage_t* flat, u64 hash)
+{
+	u32 mask = flat->slot_count - 1;
+	u32 i = HASH_TABLE_FLAT_H1(hash) & mask;
+	while(HASH_TABLE_FLAT_CTRL_IS_FULL(flat->ctrl[i]))
+		i = (i + 1) & mask;
+	return i;
+}
+
+/* moves all the key value pairs into a newly allocated slab of 'slot_count' slots, it also gets rid of the tombstones */
+static void flat_rehash(hash_table_t* table, u32 slot_count)
+{
+	hash_table_flat_storage_t old = table->flat;
+	flat_storage_allocate(table, slot_count);
+	hash_table_flat_storage_t* flat = &table->flat;
+	for(u32 i = 0; i < old.slot_count; i++)
+	{
+		if(!HASH_TABLE_FLAT_CTRL_IS_FULL(old.ctrl[i]))
+			continue;
+		u8* pair = get_flat_slot(&old, i);
+		u64 hash = hash_table_flat_mix_hash(get_key_hash(table, pair));
+		u32 index = flat_find_insert_index(flat, hash);
+		flat->ctrl[index] = HASH_TABLE_FLAT_H2(hash);
+		memcpy(get_flat_slot(flat, index), pair, flat->stride);
 	}
+	flat->count = old.count;
+	com_deallocate(&table->allocation_callbacks, old.slots);
 }
 
-COMMON_API void hash_table_foreach_until(hash_table_t* table, bool (*visitor)(void* key, void* value, void* user_data), void* user_data)
+COMMON_API hash_table_t __hash_table_create_flat(u32 key_size, u32 value_size, u32 capacity, comparer_t key_comparer, hash_function_t key_hash_function, com_allocation_callbacks_t* allocation_callbacks_ptr)
 {
-	/* for each bucket */
-	u32 bucket_count = buf_get_element_count(&table->bucket_handles);
-	for(u32 i = 0; i < bucket_count; i++)
+	hash_table_t table =
 	{
-		/* get the bucket handle */
-		sub_buffer_handle_t bucket_handle;
-		buf_get_at(&table->bucket_handles, i, &bucket_handle);
+		.allocation_callbacks = allocation_callbacks_ptr ? *allocation_callbacks_ptr : com_allocation_callbacks_get_std(),
+		.key_size = key_size,
+		.value_size = value_size,
+		.get_hash = key_hash_function,
+		.is_equal = key_comparer,
+		.storage = HASH_TABLE_STORAGE_FLAT,
+		.max_load_factor = HASH_TABLE_FLAT_MAX_LOAD_FACTOR
+	};
 
-		/* for each key value pair in the bucket */
-		u32 count = sub_buffer_get_count(&table->buffer, bucket_handle);
-		for(u32 j = 0; j < count; j++)
+	/* keep the values naturally aligned, so that the pointers returned by hash_table_get_value() can be dereferenced directly */
+	u32 key_align = get_natural_alignment(key_size);
+	u32 value_align = get_natural_alignment(value_size);
+	table.value_offset = U32_NEXT_MULTIPLE(key_size, value_align);
+	table.flat.stride = U32_NEXT_MULTIPLE(table.value_offset + value_size, u32_max(key_align, value_align));
+
+	flat_storage_allocate(&table, get_flat_slot_count(capacity));
+	return table;
+}
+
+static void flat_free(hash_table_t* table)
+{
+	com_deallocate(&table->allocation_callbacks, table->flat.slots);
+	table->flat.slots = NULL;
+	table->flat.ctrl = NULL;
+	table->flat.slot_count = 0;
+	table->flat.count = 0;
+}
+
+static void flat_clear(hash_table_t* table)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	memset(flat->ctrl, HASH_TABLE_FLAT_CTRL_EMPTY, flat->slot_count);
+	flat->count = 0;
+	flat->tombstone_count = 0;
+}
+
+static void* flat_add_get(hash_table_t* table, void* key, void* value)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	u64 hash = hash_table_flat_mix_hash(get_key_hash(table, key));
+
+	/* if a key with the same hash already exists then don't add */
+	if(flat_find_index(table, key, hash) != FLAT_INVALID_INDEX)
+	{
+		com_debug_log_warning("Failed to add key value pair as a key with the same hash already exists in the hash table");
+		return NULL;
+	}
+
+	/* keep the load factor (including the tombstones) at or below the maximum load factor,
+	 * if the tombstones are the reason of exceeding it then rehashing into the same number of slots is enough */
+	if(CAST_TO(f32, flat->count + flat->tombstone_count + 1) > (CAST_TO(f32, flat->slot_count) * table->max_load_factor))
+	{
+		u32 slot_count = flat->slot_count;
+		while(CAST_TO(f32, flat->count + 1) > (CAST_TO(f32, slot_count) * table->max_load_factor))
+			slot_count <<= 1;
+		flat_rehash(table, slot_count);
+	}
+
+	u32 index = flat_find_insert_index(flat, hash);
+	if(flat->ctrl[index] == HASH_TABLE_FLAT_CTRL_DELETED)
+		flat->tombstone_count--;
+	flat->ctrl[index] = HASH_TABLE_FLAT_H2(hash);
+	u8* pair = get_flat_slot(flat, index);
+	memcpy(pair, key, table->key_size);
+	memcpy(pair + table->value_offset, value, table->value_size);
+	flat->count++;
+	return pair + table->value_offset;
+}
+
+static bool flat_remove(hash_table_t* table, void* key)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	u32 index = flat_find_index(table, key, hash_table_flat_mix_hash(get_key_hash(table, key)));
+	if(index == FLAT_INVALID_INDEX)
+		return false;
+	/* no probe sequence can pass through this slot if the next one is empty, so no tombstone is needed in that case */
+	if(flat->ctrl[(index + 1) & (flat->slot_count - 1)] == HASH_TABLE_FLAT_CTRL_EMPTY)
+		flat->ctrl[index] = HASH_TABLE_FLAT_CTRL_EMPTY;
+	else
+	{
+		flat->ctrl[index] = HASH_TABLE_FLAT_CTRL_DELETED;
+		flat->tombstone_count++;
+	}
+	flat->count--;
+	return true;
+}
+
+static void* flat_get_value(hash_table_t* table, void* key)
+{
+	u32 index = flat_find_index(table, key, hash_table_flat_mix_hash(get_key_hash(table, key)));
+	if(index == FLAT_INVALID_INDEX)
+		return NULL;
+	return get_flat_slot(&table->flat, index) + table->value_offset;
+}
+
+static void flat_foreach_until(hash_table_t* table, bool (*visitor)(void* key, void* value, void* user_data), void* user_data)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	for(u32 i = 0; i < flat->slot_count; i++)
+	{
+		if(!HASH_TABLE_FLAT_CTRL_IS_FULL(flat->ctrl[i]))
+			continue;
+		u8* pair = get_flat_slot(flat, i);
+		if(!visitor(pair, pair + table->value_offset, user_data))
+			return;
+	}
+}
+
+static void flat_get_stats(hash_table_t* table, hash_table_stats_t* stats)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	stats->bucket_count = flat->slot_count;
+	stats->tombstone_count = flat->tombstone_count;
+	/* a run of non-empty slots is what a probe has to walk through in the worst case, the probing wraps around the end */
+	u32 run = 0;
+	u32 leading_run = 0;
+	bool is_leading = true;
+	for(u32 i = 0; i < flat->slot_count; i++)
+	{
+		if(flat->ctrl[i] == HASH_TABLE_FLAT_CTRL_EMPTY)
 		{
-			/* visit */
-			void* pair = DREF_VOID_PTR(sub_buffer_get_ptr_at(&table->buffer, bucket_handle, j));
-			if(!visitor(pair, pair + table->key_size, user_data))
-				return;
+			stats->empty_bucket_count++;
+			if(is_leading)
+				leading_run = run;
+			is_leading = false;
+			run = 0;
+			continue;
 		}
+		run++;
+		if(run > stats->max_chain_length)
+			stats->max_chain_length = run;
+	}
+	/* the trailing run continues into the leading one */
+	if(!is_leading && ((run + leading_run) > stats->max_chain_length))
+		stats->max_chain_length = run + leading_run;
+}
+
+static void flat_get_values_window(hash_table_t* table, void* keys, u32 count, void** out_values)
+{
+	hash_table_flat_storage_t* flat = &table->flat;
+	u64 hashes[BATCH_WINDOW_SIZE];
+	u32 mask = flat->slot_count - 1;
+	/* hash all the keys and prefetch the control byte and the slot at which the probing starts */
+	for(u32 i = 0; i < count; i++)
+	{
+		hashes[i] = hash_table_flat_mix_hash(get_key_hash(table, keys + i * table->key_size));
+		u32 index = HASH_TABLE_FLAT_H1(hashes[i]) & mask;
+		COM_PREFETCH_READ(&flat->ctrl[index]);
+		COM_PREFETCH_READ(get_flat_slot(flat, index));
+	}
+	for(u32 i = 0; i < count; i++)
+	{
+		u32 index = flat_find_index(table, keys + i * table->key_size, hashes[i]);
+		out_values[i] = (index == FLAT_INVALID_INDEX) ? NULL : (get_flat_slot(flat, index) + table->value_offset);
 	}
 }
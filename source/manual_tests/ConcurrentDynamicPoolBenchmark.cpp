@@ -0,0 +1,104 @@
+// Throughput of get()/put() on com::ConcurrentDynamicPool against com::DynamicPool behind a mutex,
+// with various numbers of threads, each taking out a batch of objects and then putting them back
+// Each pair of threads swaps their batches through a shared slot, so the objects are mostly put back by the other thread of the pair
+// (cross-thread recycling, as in a pipeline)
+// Build in release mode, and run as:
+// ./build/ConcurrentDynamicPoolBenchmark
+
+#include <common/DynamicPool.hpp>
+#include <common/ConcurrentDynamicPool.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+static constexpr u64 gOperationCount = 1 << 22;
+static constexpr std::size_t gBatchSize = 64;
+
+struct LockedPool
+{
+	com::DynamicPool<int*> pool;
+	std::mutex mutex;
+
+	LockedPool() : pool([]() { return new int(0); }, [](int*& value) { delete value; }, nullptr, nullptr, [](int*& a, int*& b) { return a == b; }) { }
+
+	int* get()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pool.get();
+	}
+
+	void put(int* value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pool.put(value);
+	}
+};
+
+struct ConcurrentPool
+{
+	com::ConcurrentDynamicPool<int*> pool;
+
+	ConcurrentPool() : pool([]() { return new int(0); }, [](int*& value) { delete value; }) { }
+
+	int* get() { return pool.get(); }
+	void put(int* value) { pool.put(value); }
+};
+
+// Returns millions of get() + put() pairs per second
+template<typename Pool>
+static double measure(u32 threadCount)
+{
+	Pool pool;
+	std::atomic<bool> isStarted = false;
+	u64 batchCountPerThread = gOperationCount / gBatchSize / threadCount;
+	std::vector<std::vector<int*>> exchange((threadCount + 1) / 2);
+	std::vector<std::mutex> exchangeMutexes((threadCount + 1) / 2);
+	std::vector<std::thread> threads;
+	for(u32 t = 0; t < threadCount; ++t)
+		threads.emplace_back([&, t]()
+		{
+			while(!isStarted.load(std::memory_order_acquire));
+			u32 pair = t / 2;
+			std::vector<int*> batch;
+			batch.reserve(gBatchSize);
+			for(u64 i = 0; i < batchCountPerThread; ++i)
+			{
+				for(std::size_t j = 0; j < gBatchSize; ++j)
+					batch.push_back(pool.get());
+				if(threadCount > 1)
+				{
+					std::lock_guard<std::mutex> lock(exchangeMutexes[pair]);
+					exchange[pair].swap(batch);
+				}
+				for(int* value : batch)
+					pool.put(value);
+				batch.clear();
+			}
+		});
+	auto start = std::chrono::steady_clock::now();
+	isStarted.store(true, std::memory_order_release);
+	for(auto& thread : threads)
+		thread.join();
+	auto end = std::chrono::steady_clock::now();
+	// The batches left in the exchange
+	for(auto& batch : exchange)
+		for(int* value : batch)
+			pool.put(value);
+	return static_cast<double>(batchCountPerThread * gBatchSize * threadCount) / std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int main()
+{
+	std::cout << "operations: " << gOperationCount << ", batch size: " << gBatchSize << ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+	std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(28) << "DynamicPool + mutex (M/s)" << std::setw(30) << "ConcurrentDynamicPool (M/s)" << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for(u32 threadCount : { 1u, 2u, 4u, 8u })
+		std::cout << std::left << std::setw(10) << threadCount << std::right << std::setw(28) << measure<LockedPool>(threadCount)
+					<< std::setw(30) << measure<ConcurrentPool>(threadCount) << "\n";
+	return 0;
+}
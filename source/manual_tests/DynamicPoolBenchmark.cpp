@@ -0,0 +1,113 @@
+// Cost of returning objects to com::DynamicPool by value (linear search among the active objects)
+// against returning them by handle (constant time), with various numbers of active objects.
+// Then the cost of the hooks: the same pools (and com::DynamicPoolFast) with std::function hooks against a policy with inline hooks.
+// And finally com::DynamicPool against com::StableDynamicPool with 4KB objects, the former moves them around on every put()
+// Build in release mode, and run as:
+// ./build/DynamicPoolBenchmark
+
+#include <common/DynamicPool.hpp>
+#include <common/DynamicPoolFast.hpp>
+#include <common/StableDynamicPool.hpp>
+
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+#include <array>
+
+static constexpr u64 gOperationCount = 1 << 20;
+
+// Returns nanoseconds per get() + put() pair
+template<typename GetFn, typename PutFn>
+static double measure(std::size_t activeCount, GetFn getFn, PutFn putFn)
+{
+	using Value = decltype(getFn());
+	std::vector<Value> actives;
+	for(std::size_t i = 0; i < activeCount; ++i)
+		actives.push_back(getFn());
+	std::default_random_engine engine(1);
+	std::uniform_int_distribution<std::size_t> distribution(0, activeCount - 1);
+	auto start = std::chrono::steady_clock::now();
+	for(u64 i = 0; i < gOperationCount; ++i)
+	{
+		// Returns a random active object and takes out another one in its place
+		std::size_t index = distribution(engine);
+		putFn(actives[index]);
+		actives[index] = getFn();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(gOperationCount);
+}
+
+// Same hooks as the std::function ones in main()
+struct CountingPolicy
+{
+	int* counter;
+	int* hookCounter;
+
+	int create() { return (*counter)++; }
+	void onReturn(int&) { ++(*hookCounter); }
+	void onRecycle(int&) { ++(*hookCounter); }
+};
+
+struct Message
+{
+	std::array<char, 4096> data;
+};
+
+struct MessagePolicy
+{
+	static Message create() { return { }; }
+};
+
+int main()
+{
+	std::cout << std::left << std::setw(16) << "active objects" << std::right << std::setw(24) << "put(T) (ns/op)" << std::setw(24) << "put(Handle) (ns/op)" << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for(std::size_t activeCount : { 16, 256, 4096 })
+	{
+		int counter = 0;
+		com::DynamicPool<int> valuePool([&counter]() { return counter++; });
+		double valueTime = measure(activeCount, [&]() { return valuePool.get(); }, [&](int value) { valuePool.put(value); });
+		com::DynamicPool<int> handlePool([&counter]() { return counter++; });
+		double handleTime = measure(activeCount, [&]() { return handlePool.getHandle(); }, [&](com::DynamicPoolHandle handle) { handlePool.put(handle); });
+		std::cout << std::left << std::setw(16) << activeCount << std::right << std::setw(24) << valueTime << std::setw(24) << handleTime << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "active objects" << std::right << std::setw(24) << "std::function (ns/op)" << std::setw(24) << "policy (ns/op)"
+				<< std::setw(28) << "Fast, std::function (ns/op)" << std::setw(24) << "Fast, policy (ns/op)" << "\n";
+	for(std::size_t activeCount : { 16, 256, 4096 })
+	{
+		int counter = 0;
+		int hookCounter = 0;
+		auto onCreate = [&counter]() { return counter++; };
+		auto onHook = [&hookCounter](int&) { ++hookCounter; };
+		com::DynamicPool<int> functionPool(onCreate, nullptr, onHook, onHook);
+		double functionTime = measure(activeCount, [&]() { return functionPool.getHandle(); }, [&](com::DynamicPoolHandle handle) { functionPool.put(handle); });
+		com::DynamicPool<int, CountingPolicy> policyPool(CountingPolicy { &counter, &hookCounter });
+		double policyTime = measure(activeCount, [&]() { return policyPool.getHandle(); }, [&](com::DynamicPoolHandle handle) { policyPool.put(handle); });
+		com::DynamicPoolFast<int> functionFastPool(onCreate, nullptr, onHook, onHook);
+		double functionFastTime = measure(activeCount, [&]() { return functionFastPool.get(); }, [&](com::DynamicPoolFastElement<int> el) { functionFastPool.put(el); });
+		com::DynamicPoolFast<int, CountingPolicy> policyFastPool(CountingPolicy { &counter, &hookCounter });
+		double policyFastTime = measure(activeCount, [&]() { return policyFastPool.get(); }, [&](com::DynamicPoolFastElement<int> el) { policyFastPool.put(el); });
+		std::cout << std::left << std::setw(16) << activeCount << std::right << std::setw(24) << functionTime << std::setw(24) << policyTime
+					<< std::setw(28) << functionFastTime << std::setw(24) << policyFastTime << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "active messages" << std::right << std::setw(28) << "DynamicPool, handle (ns/op)"
+				<< std::setw(34) << "StableDynamicPool, handle (ns/op)" << std::setw(37) << "StableDynamicPool, reference (ns/op)" << "\n";
+	for(std::size_t activeCount : { 16, 256, 4096 })
+	{
+		com::DynamicPool<Message, MessagePolicy> pool;
+		double poolTime = measure(activeCount, [&]() { return pool.getHandle(); }, [&](com::DynamicPoolHandle handle) { pool.put(handle); });
+		com::StableDynamicPool<Message, MessagePolicy> stablePool;
+		double stableTime = measure(activeCount, [&]() { return stablePool.getHandle(); }, [&](com::DynamicPoolHandle handle) { stablePool.put(handle); });
+		com::StableDynamicPool<Message, MessagePolicy> referencePool;
+		double referenceTime = measure(activeCount, [&]() { return &referencePool.get(); }, [&](Message* message) { referencePool.put(*message); });
+		std::cout << std::left << std::setw(16) << activeCount << std::right << std::setw(28) << poolTime
+					<< std::setw(34) << stableTime << std::setw(37) << referenceTime << "\n";
+	}
+	return 0;
+}
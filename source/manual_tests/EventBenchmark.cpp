@@ -0,0 +1,284 @@
+// Cost of com::Event::publish() per handler, with various numbers of subscribers, against handlers
+// kept in a std::unordered_map (the layout com::Event used before it packed its handlers in a vector)
+// The subscriptions are made in between other allocations, and half of them are removed and made again before measuring,
+// as it happens over the lifetime of an event
+// Then the cost of subscribe() + unsubscribe() and the memory allocations they make, with a handler capturing 'this' and two more words,
+// which is too large for the inline storage of std::function (but not for com::Delegate)
+// And finally the cost of com::OrderedEvent::publish() per handler, against a std::multimap of keys to handlers kept in
+// a std::unordered_map (the layout com::OrderedEvent used before it kept its handlers in a sorted vector)
+// And the time a publisher spends per event when the handler is slow, publishing com::Event directly against enqueuing into com::EventQueue
+// dispatched by its dispatcher thread (a machine with at least 2 cores is needed for a meaningful result)
+// And the cost of publish() per handler for com::Event, for com::Event behind a std::shared_mutex (what makes it safe to subscribe
+// on another thread), and for com::ConcurrentEvent, on one thread
+// Build in release mode, and run as:
+// ./build/EventBenchmark
+
+#include <common/Event.hpp>
+#include <common/OrderedEvent.hpp>
+#include <common/EventQueue.hpp>
+#include <common/ConcurrentEvent.hpp>
+
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <functional>
+#include <utility>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <new>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <shared_mutex>
+#include <mutex>
+
+static constexpr u64 gHandlerCallCount = 1 << 24;
+
+static u64 gAllocationCount = 0;
+
+// None of them is inlined, GCC would take the std::free() of a pointer returned by operator new for a mismatch
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+	++gAllocationCount;
+	if(void* ptr = std::malloc(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct Subscriber
+{
+	int state = 0;
+
+	void onEvent(int value, int* total) { state += value; *total += state; }
+};
+
+// Returns nanoseconds per handler call
+template<typename PublishFn>
+static double measure(std::size_t handlerCount, PublishFn publishFn)
+{
+	u64 publishCount = gHandlerCallCount / handlerCount;
+	auto start = std::chrono::steady_clock::now();
+	for(u64 i = 0; i < publishCount; ++i)
+		publishFn(static_cast<int>(i));
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(publishCount * handlerCount);
+}
+
+int main()
+{
+	std::cout << std::left << std::setw(16) << "subscribers" << std::right << std::setw(28) << "std::unordered_map (ns/call)" << std::setw(24) << "com::Event (ns/call)" << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for(std::size_t handlerCount : { 16, 256, 4096, 65536 })
+	{
+		// Each handler has a state of its own, as handlers capturing 'this' do
+		std::vector<int> states(handlerCount, 0);
+		// Allocations of the rest of the program, made in between the subscriptions
+		std::vector<std::unique_ptr<char[]>> noise;
+		std::default_random_engine engine(1);
+		std::uniform_int_distribution<std::size_t> noiseSize(16, 2048);
+
+		std::unordered_map<std::size_t, std::pair<std::function<void(int)>, bool>> map;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+		{
+			map.insert({ i, { [&states, i](int value) { states[i] += value; }, true } });
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		for(std::size_t i = 0; i < handlerCount; i += 2)
+		{
+			map.erase(i);
+			map.insert({ handlerCount + i, { [&states, i](int value) { states[i] += value; }, true } });
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		double mapTime = measure(handlerCount, [&map](int value)
+		{
+			for(auto& pair : map)
+				if(pair.second.second)
+					pair.second.first(value);
+		});
+
+		com::Event<com::no_publish_ptr_t, int> event;
+		std::vector<com::Event<com::no_publish_ptr_t, int>::SubscriptionID> ids;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+		{
+			ids.push_back(event.subscribe([&states, i](int value) { states[i] += value; }));
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		for(std::size_t i = 0; i < handlerCount; i += 2)
+		{
+			event.unsubscribe(ids[i]);
+			event.subscribe([&states, i](int value) { states[i] += value; });
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		double eventTime = measure(handlerCount, [&event](int value) { event.publish(value); });
+
+		std::cout << std::left << std::setw(16) << handlerCount << std::right << std::setw(28) << mapTime << std::setw(24) << eventTime << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "subscriptions" << std::right << std::setw(28) << "std::unordered_map (ns/op)" << std::setw(16) << "allocations"
+				<< std::setw(24) << "com::Event (ns/op)" << std::setw(16) << "allocations" << "\n";
+	constexpr u64 subscriptionCount = 1 << 20;
+	// Subscribes and unsubscribes the handlers in batches of 'batchSize', returns nanoseconds and allocations per subscription
+	auto measureSubscribe = [](std::size_t batchSize, auto subscribe, auto unsubscribe)
+	{
+		using ID = decltype(subscribe());
+		std::vector<ID> ids;
+		ids.reserve(batchSize);
+		u64 allocationCount = gAllocationCount;
+		auto start = std::chrono::steady_clock::now();
+		for(u64 i = 0; i < subscriptionCount; i += batchSize)
+		{
+			for(std::size_t j = 0; j < batchSize; ++j)
+				ids.push_back(subscribe());
+			for(ID id : ids)
+				unsubscribe(id);
+			ids.clear();
+		}
+		auto end = std::chrono::steady_clock::now();
+		return std::make_pair(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(subscriptionCount),
+								static_cast<double>(gAllocationCount - allocationCount) / static_cast<double>(subscriptionCount));
+	};
+	for(std::size_t batchSize : { 16, 256, 4096 })
+	{
+		Subscriber subscriber;
+		int total = 0;
+		int* totalPtr = &total;
+		int extra = 1;
+
+		std::unordered_map<std::size_t, std::pair<std::function<void(int)>, bool>> map;
+		std::size_t nextID = 0;
+		auto mapResult = measureSubscribe(batchSize, [&]()
+		{
+			std::size_t id = nextID++;
+			map.insert({ id, { [ptr = &subscriber, totalPtr, extra](int value) { ptr->onEvent(value + extra, totalPtr); }, true } });
+			return id;
+		},
+		[&map](std::size_t id) { map.erase(id); });
+
+		com::Event<com::no_publish_ptr_t, int> event;
+		auto eventResult = measureSubscribe(batchSize, [&]()
+		{
+			return event.subscribe([ptr = &subscriber, totalPtr, extra](int value) { ptr->onEvent(value + extra, totalPtr); });
+		},
+		[&event](com::Event<com::no_publish_ptr_t, int>::SubscriptionID id) { event.unsubscribe(id); });
+
+		std::cout << std::left << std::setw(16) << batchSize << std::right << std::setw(28) << mapResult.first << std::setw(16) << mapResult.second
+					<< std::setw(24) << eventResult.first << std::setw(16) << eventResult.second << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "subscribers" << std::right << std::setw(24) << "std::multimap (ns/call)" << std::setw(32) << "com::OrderedEvent (ns/call)" << "\n";
+	for(std::size_t handlerCount : { 16, 256, 4096, 65536 })
+	{
+		std::vector<int> states(handlerCount, 0);
+		std::vector<std::unique_ptr<char[]>> noise;
+		std::default_random_engine engine(1);
+		std::uniform_int_distribution<std::size_t> noiseSize(16, 2048);
+		std::uniform_int_distribution<int> keys(0, 1000);
+
+		struct HandlerData
+		{
+			std::function<bool(int)> handler;
+			bool isActive;
+			int key;
+		};
+		std::unordered_map<std::size_t, HandlerData> handlers;
+		std::multimap<int, HandlerData*> orderedMap;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+		{
+			int key = keys(engine);
+			auto it = handlers.insert({ i, { [&states, i](int value) { states[i] += value; return false; }, true, key } }).first;
+			orderedMap.insert({ key, &it->second });
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		double mapTime = measure(handlerCount, [&orderedMap](int value)
+		{
+			for(auto& pair : orderedMap)
+				if(pair.second->isActive && pair.second->handler(value))
+					break;
+		});
+
+		com::OrderedEvent<com::no_publish_ptr_t, int, std::less<int>, int> event;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+		{
+			event.subscribe([&states, i](int value) { states[i] += value; return false; }, keys(engine));
+			noise.push_back(std::make_unique<char[]>(noiseSize(engine)));
+		}
+		double eventTime = measure(handlerCount, [&event](int value) { event.publish(value); });
+
+		std::cout << std::left << std::setw(16) << handlerCount << std::right << std::setw(24) << mapTime << std::setw(32) << eventTime << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "handler (ns)" << std::right << std::setw(32) << "com::Event::publish (ns/event)"
+				<< std::setw(36) << "com::EventQueue::enqueue (ns/event)" << "\n";
+	constexpr u64 eventCount = 1 << 16;
+	for(u64 handlerTime : { 100, 1000, 10000 })
+	{
+		// Spins for 'handlerTime' nanoseconds, as a handler doing some work does
+		auto handler = [handlerTime](int)
+		{
+			auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(handlerTime);
+			while(std::chrono::steady_clock::now() < end);
+		};
+		auto measurePublisher = [](auto publish)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for(u64 i = 0; i < eventCount; ++i)
+				publish(static_cast<int>(i));
+			auto end = std::chrono::steady_clock::now();
+			return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(eventCount);
+		};
+
+		com::Event<com::no_publish_ptr_t, int> event;
+		event.subscribe(handler);
+		double publishTime = measurePublisher([&event](int value) { event.publish(value); });
+
+		// Large enough to hold all the events, so the publisher measures the enqueuing only
+		com::EventQueue<com::no_publish_ptr_t, int> queue({ .capacity = eventCount });
+		std::atomic<u64> dispatchedCount = 0;
+		queue.subscribe([&handler, &dispatchedCount](int value)
+		{
+			handler(value);
+			dispatchedCount.fetch_add(1, std::memory_order_relaxed);
+		});
+		queue.start();
+		double enqueueTime = measurePublisher([&queue](int value) { queue.enqueue(value); });
+		while(dispatchedCount.load(std::memory_order_relaxed) < eventCount)
+			std::this_thread::yield();
+		queue.stop();
+
+		std::cout << std::left << std::setw(16) << handlerTime << std::right << std::setw(32) << publishTime << std::setw(36) << enqueueTime << "\n";
+	}
+
+	std::cout << "\n" << std::left << std::setw(16) << "subscribers" << std::right << std::setw(24) << "com::Event (ns/call)"
+				<< std::setw(36) << "std::shared_mutex + Event (ns/call)" << std::setw(36) << "com::ConcurrentEvent (ns/call)" << "\n";
+	for(std::size_t handlerCount : { 1, 16, 256, 4096 })
+	{
+		std::vector<int> states(handlerCount, 0);
+
+		com::Event<com::no_publish_ptr_t, int> event;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+			event.subscribe([&states, i](int value) { states[i] += value; });
+		double eventTime = measure(handlerCount, [&event](int value) { event.publish(value); });
+
+		std::shared_mutex mutex;
+		double lockedTime = measure(handlerCount, [&event, &mutex](int value)
+		{
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			event.publish(value);
+		});
+
+		com::ConcurrentEvent<com::no_publish_ptr_t, int> concurrentEvent;
+		for(std::size_t i = 0; i < handlerCount; ++i)
+			concurrentEvent.subscribe([&states, i](int value) { states[i] += value; });
+		double concurrentTime = measure(handlerCount, [&concurrentEvent](int value) { concurrentEvent.publish(value); });
+
+		std::cout << std::left << std::setw(16) << handlerCount << std::right << std::setw(24) << eventTime
+					<< std::setw(36) << lockedTime << std::setw(36) << concurrentTime << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,137 @@
+// Collision quality and throughput of the hash functions in hash_function.h
+// Build in release mode, and run as:
+// ./build/HashFunctionBenchmark
+// Inputs longer than 2048 bytes take the AVX2 path only if built with -mavx2 (or /arch:AVX2), otherwise longer than 65536 bytes take the SSE2 path
+// Lower "max bucket" and "chi^2 / buckets" (close to 1.0) are better
+
+#include <common/hash_function.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+// The hash functions before they were replaced, to compare against
+static hash_t legacyStringHash(void* v)
+{
+	const char* str = DEREF_TO(const char*, v);
+	u16 hash1 = static_cast<u16>(strlen(str) % U16_MAX);
+	u16 hash2 = static_cast<u16>(strlen(str) >> 2);
+	u32 hash3 = 0;
+	for(u16 i = 0; i < hash1; i++)
+	{
+		hash2 ^= static_cast<u16>(str[i]);
+		hash3 += str[i];
+	}
+	return static_cast<hash_t>(BIT64_PACK32(BIT32_PACK16(hash1, hash2), hash3));
+}
+
+static hash_t legacyIdentityHash(void* v)
+{
+	return DREF_TO(u64, v);
+}
+
+static volatile hash_t gSink;
+
+static void printDistribution(const char* name, const std::vector<hash_t>& hashes)
+{
+	constexpr u64 bucketCount = 1024;
+	std::vector<u64> buckets(bucketCount, 0);
+	for(hash_t hash : hashes)
+		buckets[hash & (bucketCount - 1)]++;
+	f64 expected = static_cast<f64>(hashes.size()) / bucketCount;
+	f64 chiSquare = 0;
+	for(u64 count : buckets)
+		chiSquare += (count - expected) * (count - expected) / expected;
+	std::vector<hash_t> sorted = hashes;
+	std::sort(sorted.begin(), sorted.end());
+	u64 fullCollisions = sorted.size() - static_cast<u64>(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
+	std::cout << "  " << std::left << std::setw(34) << name
+		<< " max bucket: " << std::setw(8) << *std::max_element(buckets.begin(), buckets.end())
+		<< " chi^2 / buckets: " << std::setw(12) << (chiSquare / bucketCount)
+		<< " 64 bit collisions: " << fullCollisions << "\n";
+}
+
+static void compare(const char* keySetName, const std::function<void*(u64)>& getKey, u64 count, hash_function_t legacy, hash_function_t current)
+{
+	std::cout << keySetName << " (" << count << " keys, 1024 buckets indexed by the low bits)\n";
+	std::vector<hash_t> legacyHashes, currentHashes;
+	for(u64 i = 0; i < count; ++i)
+	{
+		void* key = getKey(i);
+		legacyHashes.push_back(legacy(key));
+		currentHashes.push_back(current(key));
+	}
+	printDistribution("legacy", legacyHashes);
+	printDistribution("current", currentHashes);
+}
+
+template<typename F>
+static f64 measureSeconds(F&& f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	std::cout << std::fixed << std::setprecision(2);
+
+	// Collision quality
+	{
+		constexpr u64 count = 100000;
+		std::vector<u64> integers(count);
+		compare("Sequential integers (stride 1)", [&](u64 i) { integers[i] = i; return &integers[i]; }, count, legacyIdentityHash, u64_hash);
+		compare("Sequential integers (stride 1024)", [&](u64 i) { integers[i] = i * 1024; return &integers[i]; }, count, legacyIdentityHash, u64_hash);
+
+		std::vector<std::unique_ptr<u64>> allocations;
+		std::vector<void*> pointers(count);
+		compare("Heap pointers", [&](u64 i) { allocations.emplace_back(new u64 { i }); pointers[i] = allocations.back().get(); return &pointers[i]; }, count, legacyIdentityHash, ptr_hash);
+
+		std::vector<std::string> strings(count);
+		std::vector<const char*> stringPtrs(count);
+		compare("Strings \"key_<n>\"", [&](u64 i) { strings[i] = "key_" + std::to_string(i); stringPtrs[i] = strings[i].c_str(); return &stringPtrs[i]; }, count, legacyStringHash, string_hash);
+
+		std::string anagram = "abcdefgh";
+		compare("Anagrams of \"abcdefgh\"", [&](u64 i) { strings[i] = anagram; std::next_permutation(anagram.begin(), anagram.end()); stringPtrs[i] = strings[i].c_str(); return &stringPtrs[i]; }, 40320, legacyStringHash, string_hash);
+	}
+
+	// Throughput
+	std::cout << "\nbytes_hash throughput\n";
+	for(u64 size : { 4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 65536, 1 << 20 })
+	{
+		std::vector<u8> bytes(size, 0x5A);
+		u64 iterations = std::max<u64>((256ULL << 20) / size, 16);
+		hash_t sum = 0;
+		f64 seconds = measureSeconds([&]()
+		{
+			// Different seed for each iteration, so the calls can't be hoisted out of the loop
+			for(u64 i = 0; i < iterations; ++i)
+				sum += bytes_hash(bytes.data(), size, i);
+		});
+		gSink = sum;
+		std::cout << "  " << std::right << std::setw(8) << size << " bytes: "
+			<< std::setw(10) << (static_cast<f64>(size) * iterations / seconds / (1 << 30)) << " GiB/s "
+			<< std::setw(10) << (seconds * 1e9 / iterations) << " ns/hash\n";
+	}
+
+	std::cout << "\nInteger hashing\n";
+	{
+		constexpr u64 iterations = 100000000;
+		hash_t sum = 0;
+		f64 seconds = measureSeconds([&]() { for(u64 i = 0; i < iterations; ++i) sum += u64_hash(&i); });
+		gSink = sum;
+		std::cout << "  u64_hash: " << (seconds * 1e9 / iterations) << " ns/hash\n";
+		seconds = measureSeconds([&]() { for(u64 i = 0; i < iterations; ++i) sum += hash_mix_seed(i, 0x9E3779B97F4A7C15ULL); });
+		gSink = sum;
+		std::cout << "  hash_mix_seed: " << (seconds * 1e9 / iterations) << " ns/hash\n";
+	}
+	return 0;
+}
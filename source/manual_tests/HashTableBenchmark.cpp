@@ -0,0 +1,109 @@
+// Compares the void* C API of hash_table_t and dictionary_t against their typed wrappers (com::HashTable and com::Dictionary)
+// which inline the hash and key comparison into the lookups, and against std::unordered_map
+// Build in release mode, and run as:
+// ./build/HashTableBenchmark
+
+#include <common/hash_table.h>
+#include <common/dictionary.h>
+#include <common/HashTable.hpp>
+#include <common/Dictionary.hpp>
+
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <unordered_map>
+#include <iostream>
+#include <iomanip>
+
+static volatile u64 gSink;
+
+template<typename Fn>
+static f64 measureNsPerOp(u64 opCount, Fn&& fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<f64, std::nano>(end - start).count() / opCount;
+}
+
+static void printRow(const char* name, f64 insertNs, f64 hitNs, f64 missNs)
+{
+	std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(12) << insertNs << std::setw(12) << hitNs << std::setw(12) << missNs << "\n";
+}
+
+static void runBenchmark(u32 keyCount)
+{
+	std::mt19937 rng(keyCount);
+	std::vector<u32> keys(keyCount);
+	std::iota(keys.begin(), keys.end(), 0);
+	for(u32& key : keys)
+		key = key * 2654435761u;
+	std::vector<u32> hits = keys;
+	std::shuffle(hits.begin(), hits.end(), rng);
+	std::vector<u32> misses(keyCount);
+	for(u32 i = 0; i < keyCount; i++)
+		misses[i] = hits[i] + 1;
+	/* repeat the lookups so that each row takes a measurable time */
+	u32 rounds = std::max(1u, (1u << 22) / keyCount);
+	u64 lookupCount = static_cast<u64>(rounds) * keyCount;
+
+	std::cout << "keys: " << keyCount << "\n";
+	std::cout << "  " << std::left << std::setw(28) << "" << std::right << std::setw(12) << "add (ns)" << std::setw(12) << "hit (ns)" << std::setw(12) << "miss (ns)" << "\n";
+
+	auto lookupAll = [&](const std::vector<u32>& lookups, auto&& find)
+	{
+		return measureNsPerOp(lookupCount, [&]()
+		{
+			u64 sum = 0;
+			for(u32 r = 0; r < rounds; r++)
+				for(u32 key : lookups)
+					sum += find(key);
+			gSink = sum;
+		});
+	};
+
+	{
+		hash_table_t table = hash_table_create_flat(u32, u32, 0, u32_equal_to, u32_hash, NULL);
+		f64 insertNs = measureNsPerOp(keyCount, [&]() { for(u32 key : keys) hash_table_add(&table, &key, &key); });
+		auto find = [&](u32 key) -> u64 { void* value = hash_table_get_value(&table, &key); return value ? DREF_TO(u32, value) : 0; };
+		printRow("hash_table_t (flat)", insertNs, lookupAll(hits, find), lookupAll(misses, find));
+		hash_table_free(&table);
+	}
+	{
+		com::HashTable<u32, u32> table;
+		f64 insertNs = measureNsPerOp(keyCount, [&]() { for(u32 key : keys) table.add(key, key); });
+		auto find = [&](u32 key) -> u64 { u32* value = table.find(key); return value ? *value : 0; };
+		printRow("com::HashTable", insertNs, lookupAll(hits, find), lookupAll(misses, find));
+	}
+	{
+		std::unordered_map<u32, u32> map;
+		f64 insertNs = measureNsPerOp(keyCount, [&]() { for(u32 key : keys) map.emplace(key, key); });
+		auto find = [&](u32 key) -> u64 { auto it = map.find(key); return (it != map.end()) ? it->second : 0; };
+		printRow("std::unordered_map", insertNs, lookupAll(hits, find), lookupAll(misses, find));
+	}
+	{
+		dictionary_t dictionary = dictionary_create_hashed(u32, u32, 0, dictionary_key_comparer_u32, u32_hash);
+		f64 insertNs = measureNsPerOp(keyCount, [&]() { for(u32 key : keys) dictionary_push(&dictionary, &key, &key); });
+		auto find = [&](u32 key) -> u64 { void* value; return dictionary_try_get_value_ptr(&dictionary, &key, &value) ? DREF_TO(u32, value) : 0; };
+		printRow("dictionary_t (hashed)", insertNs, lookupAll(hits, find), lookupAll(misses, find));
+		dictionary_free(&dictionary);
+	}
+	{
+		com::Dictionary<u32, u32> dictionary;
+		f64 insertNs = measureNsPerOp(keyCount, [&]() { for(u32 key : keys) dictionary.add(key, key); });
+		auto find = [&](u32 key) -> u64 { u32* value = dictionary.find(key); return value ? *value : 0; };
+		printRow("com::Dictionary", insertNs, lookupAll(hits, find), lookupAll(misses, find));
+	}
+	std::cout << "\n";
+}
+
+int main()
+{
+	for(u32 keyCount : { 1000u, 64000u, 1000000u })
+		runBenchmark(keyCount);
+	return 0;
+}
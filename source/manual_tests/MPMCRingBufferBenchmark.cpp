@@ -0,0 +1,129 @@
+// Throughput of com::MPMCRingBuffer against com::ProducerConsumerBuffer (both bounded to the same capacity)
+// with various numbers of producer and consumer threads
+// The 'bulk' column moves gBatchSize items per pushBulk()/popBulk() call on com::ProducerConsumerBuffer
+// Build in release mode, and run as:
+// ./build/MPMCRingBufferBenchmark
+
+#include <common/MPMCRingBuffer.hpp>
+#include <common/ProducerConsumerBuffer.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <span>
+#include <algorithm>
+
+static constexpr std::size_t gCapacity = 1024;
+static constexpr u64 gItemCount = 1 << 22;
+static constexpr std::size_t gBatchSize = 64;
+
+static void checkSum(u64 sum, u32 producerCount, u64 countPerProducer)
+{
+	u64 expectedSum = producerCount * (countPerProducer * (countPerProducer - 1) / 2);
+	if(sum != expectedSum)
+	{
+		std::cerr << "Checksum mismatch, expected: " << expectedSum << ", got: " << sum << "\n";
+		std::exit(1);
+	}
+}
+
+// Returns millions of items per second
+template<typename Buffer>
+static f64 measure(u32 producerCount, u32 consumerCount)
+{
+	Buffer buffer(gCapacity);
+	std::atomic<u64> sum = 0;
+	std::atomic<bool> isStarted = false;
+	std::vector<std::thread> threads;
+	u64 countPerProducer = gItemCount / producerCount;
+	u64 countPerConsumer = gItemCount / consumerCount;
+	for(u32 p = 0; p < producerCount; ++p)
+		threads.emplace_back([&]()
+		{
+			while(!isStarted.load(std::memory_order_acquire));
+			for(u64 i = 0; i < countPerProducer; ++i)
+				buffer.push(i);
+		});
+	for(u32 c = 0; c < consumerCount; ++c)
+		threads.emplace_back([&]()
+		{
+			while(!isStarted.load(std::memory_order_acquire));
+			u64 localSum = 0;
+			for(u64 i = 0; i < countPerConsumer; ++i)
+				localSum += buffer.pop();
+			sum += localSum;
+		});
+	auto start = std::chrono::steady_clock::now();
+	isStarted.store(true, std::memory_order_release);
+	for(auto& thread : threads)
+		thread.join();
+	auto end = std::chrono::steady_clock::now();
+	checkSum(sum, producerCount, countPerProducer);
+	return static_cast<f64>(gItemCount) / std::chrono::duration<f64, std::micro>(end - start).count();
+}
+
+// Returns millions of items per second
+static f64 measureBulk(u32 producerCount, u32 consumerCount)
+{
+	com::ProducerConsumerBuffer<u64> buffer(gCapacity);
+	std::atomic<u64> sum = 0;
+	std::atomic<bool> isStarted = false;
+	std::atomic<u32> activeProducerCount = producerCount;
+	std::vector<std::thread> threads;
+	u64 countPerProducer = gItemCount / producerCount;
+	for(u32 p = 0; p < producerCount; ++p)
+		threads.emplace_back([&]()
+		{
+			while(!isStarted.load(std::memory_order_acquire));
+			u64 batch[gBatchSize];
+			for(u64 i = 0; i < countPerProducer; i += gBatchSize)
+			{
+				std::size_t count = static_cast<std::size_t>(std::min<u64>(gBatchSize, countPerProducer - i));
+				for(std::size_t j = 0; j < count; ++j)
+					batch[j] = i + j;
+				buffer.pushBulk(std::span<const u64>(batch, count));
+			}
+			// The last producer to finish tells the consumers that no more items are coming
+			if(activeProducerCount.fetch_sub(1) == 1)
+				buffer.close();
+		});
+	for(u32 c = 0; c < consumerCount; ++c)
+		threads.emplace_back([&]()
+		{
+			while(!isStarted.load(std::memory_order_acquire));
+			u64 localSum = 0;
+			u64 batch[gBatchSize];
+			while(std::size_t count = buffer.popBulk(batch, gBatchSize))
+				for(std::size_t i = 0; i < count; ++i)
+					localSum += batch[i];
+			sum += localSum;
+		});
+	auto start = std::chrono::steady_clock::now();
+	isStarted.store(true, std::memory_order_release);
+	for(auto& thread : threads)
+		thread.join();
+	auto end = std::chrono::steady_clock::now();
+	checkSum(sum, producerCount, countPerProducer);
+	return static_cast<f64>(gItemCount) / std::chrono::duration<f64, std::micro>(end - start).count();
+}
+
+int main()
+{
+	std::cout << "items: " << gItemCount << ", capacity: " << gCapacity << ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+	std::cout << std::left << std::setw(24) << "producers x consumers" << std::right
+		<< std::setw(28) << "ProducerConsumerBuffer (M/s)" << std::setw(35) << "ProducerConsumerBuffer bulk (M/s)" << std::setw(22) << "MPMCRingBuffer (M/s)" << "\n";
+	std::pair<u32, u32> configs[] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 8, 1 }, { 8, 8 } };
+	for(auto [producerCount, consumerCount] : configs)
+	{
+		f64 mutexThroughput = measure<com::ProducerConsumerBuffer<u64>>(producerCount, consumerCount);
+		f64 bulkThroughput = measureBulk(producerCount, consumerCount);
+		f64 ringThroughput = measure<com::MPMCRingBuffer<u64>>(producerCount, consumerCount);
+		std::cout << std::left << std::setw(24) << (std::to_string(producerCount) + " x " + std::to_string(consumerCount)) << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(28) << mutexThroughput << std::setw(35) << bulkThroughput << std::setw(22) << ringThroughput << "\n";
+	}
+	return 0;
+}
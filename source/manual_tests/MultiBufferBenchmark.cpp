@@ -0,0 +1,46 @@
+// Push throughput of multi_buffer_t as the number of sub buffers grows
+// Build in release mode, and run as:
+// ./build/MultiBufferBenchmark
+// The time per push should stay (roughly) the same for any number of sub buffers
+
+#include <common/multi_buffer.h>
+
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+static constexpr u64 PUSHES_PER_SUB_BUFFER = 8;
+
+// Pushes PUSHES_PER_SUB_BUFFER elements into each sub buffer (round robin) and returns nanoseconds per push
+static f64 measurePush(u64 subBufferCount, buf_ucount_t initialCapacity)
+{
+	multi_buffer_t buffer;
+	multi_buffer_create(sizeof(u64), static_cast<u32>(subBufferCount * initialCapacity), &buffer);
+	std::vector<sub_buffer_handle_t> handles;
+	for(u64 i = 0; i < subBufferCount; ++i)
+		handles.push_back(multi_buffer_sub_buffer_create(&buffer, initialCapacity));
+	auto start = std::chrono::steady_clock::now();
+	for(u64 j = 0; j < PUSHES_PER_SUB_BUFFER; ++j)
+		for(u64 i = 0; i < subBufferCount; ++i)
+		{
+			u64 value = i * PUSHES_PER_SUB_BUFFER + j;
+			multi_buffer_sub_buffer_push(&buffer, handles[i], &value);
+		}
+	f64 nanoseconds = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+	multi_buffer_free(&buffer);
+	return nanoseconds / static_cast<f64>(subBufferCount * PUSHES_PER_SUB_BUFFER);
+}
+
+int main()
+{
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "sub buffers   reserved (ns/push)   growing from capacity 1 (ns/push)\n";
+	for(u64 subBufferCount : { 16, 256, 4096, 16384 })
+	{
+		std::cout << std::setw(11) << subBufferCount
+			<< std::setw(21) << measurePush(subBufferCount, PUSHES_PER_SUB_BUFFER)
+			<< std::setw(36) << measurePush(subBufferCount, 1) << "\n";
+	}
+	return 0;
+}
@@ -1,11 +1,24 @@
+// 3 stage pipeline, measured with com::ProducerConsumerBuffer or com::SpscQueue between the stages
+// (each hop has exactly one producer and one consumer) and with com::DynamicPoolFast behind a mutex or com::ConcurrentDynamicPool
+// for the objects flowing through them, and then built with com::Pipeline
+// Build in release mode, and run as:
+// ./build/Pipeline
+
 #include <common/DynamicPoolFast.hpp>
+#include <common/ConcurrentDynamicPool.hpp>
 #include <common/ProducerConsumerBuffer.hpp>
+#include <common/SpscQueue.hpp>
+#include <common/Pipeline.hpp>
 
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <vector>
 #include <random>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
 #include <cassert>
 
 static std::atomic<std::size_t> gPool1DataCounter = 0;
@@ -14,6 +27,9 @@ static std::atomic<std::size_t> gPool2DataCounter = 0;
 static std::vector<int> gGeneratedRandomNumberList;
 static std::vector<int> gProcessedRandomNumberList;
 
+static constexpr std::size_t gDataCount = 1 << 20;
+static constexpr std::size_t gPipeCapacity = 1024;
+
 static int GenerateRandomNumber()
 {
 	static std::random_device r;
@@ -26,149 +42,267 @@ static int GenerateRandomNumber()
 	return value;
 }
 
-struct Context
+// DynamicPoolFast is single-threaded, so every get() and put() takes a lock
+struct LockedPool
 {
-	com::DynamicPoolFast<int> pool12;
-	com::DynamicPoolFast<int> pool23;
+	using ElementType = com::DynamicPoolFast<int>::ElementType;
+	static constexpr std::size_t CachedCount = 0;
 
-	std::mutex pool12Mutex;
-	std::mutex pool23Mutex;
+	com::DynamicPoolFast<int> pool;
+	std::mutex mutex;
 
-	com::ProducerConsumerBuffer<com::DynamicPoolFast<int>::ElementType> pipe1;
-	com::ProducerConsumerBuffer<com::DynamicPoolFast<int>::ElementType> pipe2;
-	com::ProducerConsumerBuffer<com::DynamicPoolFast<int>::ElementType> pipe3;
-
-	Context() : pool12([]()
+	LockedPool(std::atomic<std::size_t>& counter) : pool([&counter]()
 	{
-		++gPool1DataCounter;
+		++counter;
 		return 0;
 	},
-	[](int&)
+	[&counter](int&)
 	{
-		--gPool1DataCounter;
-	}),
-	pool23([]()
+		--counter;
+	})
 	{
-		++gPool2DataCounter;
-		return 0;
+
+	}
+
+	ElementType get()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pool.get();
+	}
+
+	void put(ElementType value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pool.put(std::move(value));
+	}
+};
+
+struct ConcurrentPool
+{
+	using ElementType = std::unique_ptr<int>;
+	// The magazines of the thread putting the objects back
+	static constexpr std::size_t CachedCount = 2 * com::ConcurrentDynamicPool<ElementType>::MagazineSize;
+
+	com::ConcurrentDynamicPool<ElementType> pool;
+
+	ConcurrentPool(std::atomic<std::size_t>& counter) : pool([&counter]()
+	{
+		++counter;
+		return std::make_unique<int>(0);
 	},
-	[](int&)
+	[&counter](ElementType&)
 	{
-		--gPool2DataCounter;
+		--counter;
 	})
 	{
 
 	}
+
+	ElementType get() { return pool.get(); }
+	void put(ElementType value) { pool.put(std::move(value)); }
 };
 
-static Context gContext;
-static constexpr std::size_t gDataCount = 100;
+// Both the pipes are bounded to gPipeCapacity, so each pool never grows beyond gPipeCapacity + 2 elements
+// (the ones in the pipe plus the ones held by the producing and the consuming stage) plus the ones cached by the pool
+template<typename T>
+struct ProducerConsumerBufferPipe : public com::ProducerConsumerBuffer<T>
+{
+	ProducerConsumerBufferPipe() : com::ProducerConsumerBuffer<T>(gPipeCapacity) { }
+};
+
+template<typename T>
+using SpscQueuePipe = com::SpscQueue<T, gPipeCapacity>;
 
-static void _pipe1Process(com::DynamicPoolFast<int>::ElementType& output)
+template<template<typename> class PipeType, typename PoolType>
+struct Context
+{
+	using ElementType = typename PoolType::ElementType;
+
+	PoolType pool12;
+	PoolType pool23;
+
+	PipeType<ElementType> pipe1;
+	PipeType<ElementType> pipe2;
+
+	Context() : pool12(gPool1DataCounter), pool23(gPool2DataCounter) { }
+};
+
+template<typename ElementType>
+static void _pipe1Process(ElementType& output)
 {
 	*output = GenerateRandomNumber();
 }
 
-static void pipe1Process()
+template<typename ContextType>
+static void pipe1Process(ContextType& context)
 {
 	auto dataCount = gDataCount;
 	while(dataCount)
 	{
-		com::DynamicPoolFast<int>::ElementType value;
-		{
-			std::lock_guard<std::mutex> lock(gContext.pool12Mutex);
-			value = gContext.pool12.get();	
-		} 
+		auto value = context.pool12.get();
 		_pipe1Process(value);
-		gContext.pipe1.push(value);
+		context.pipe1.push(std::move(value));
 		--dataCount;
 	}
 }
 
-static void _pipe2Process(const com::DynamicPoolFast<int>::ElementType& input, com::DynamicPoolFast<int>::ElementType& output)
+template<typename ElementType>
+static void _pipe2Process(const ElementType& input, ElementType& output)
 {
 	*output = *input;
 }
 
-static void pipe2Process()
+template<typename ContextType>
+static void pipe2Process(ContextType& context)
 {
 	auto dataCount = gDataCount;
 	while(dataCount)
 	{
 		// Take out the output of pipe1
-		auto value = gContext.pipe1.pop();
+		auto value = context.pipe1.pop();
 
 		// Process it
-		com::DynamicPoolFast<int>::ElementType value2;
-		{
-			std::lock_guard<std::mutex> lock(gContext.pool23Mutex);
-			value2 = gContext.pool23.get();
-		}
+		auto value2 = context.pool23.get();
 		_pipe2Process(value, value2);
-		
+
 		// Push the output of pipe2
-		gContext.pipe2.push(value2);
+		context.pipe2.push(std::move(value2));
 
 		// Return the output of pipe1 back to pipe1's pool
-		{
-			std::lock_guard<std::mutex> lock(gContext.pool12Mutex);
-			gContext.pool12.put(value);
-		}
+		context.pool12.put(std::move(value));
 		--dataCount;
 	}
 }
 
-static void pipe3Process()
+template<typename ContextType>
+static void pipe3Process(ContextType& context)
 {
 	auto dataCount = gDataCount;
 	while(dataCount)
 	{
-		// Take out the output of pipe1
-		auto value = gContext.pipe2.pop();
+		// Take out the output of pipe2
+		auto value = context.pipe2.pop();
 
 		gProcessedRandomNumberList.push_back(*value);
 
 		// Return the output of pipe2 back to pipe2's pool
-		{
-			std::lock_guard<std::mutex> lock(gContext.pool23Mutex);
-			gContext.pool23.put(value);
-		}
+		context.pool23.put(std::move(value));
 		--dataCount;
 	}
 }
 
+static void resetPipeline()
+{
+	gPool1DataCounter = 0;
+	gPool2DataCounter = 0;
+	gGeneratedRandomNumberList.clear();
+	gProcessedRandomNumberList.clear();
+	gGeneratedRandomNumberList.reserve(gDataCount);
+	gProcessedRandomNumberList.reserve(gDataCount);
+}
+
+static void checkPipeline()
+{
+	assert(gProcessedRandomNumberList.size() == gGeneratedRandomNumberList.size());
+	assert(gProcessedRandomNumberList.size() == gDataCount);
+
+	for(std::size_t i = 0; i < gGeneratedRandomNumberList.size(); ++i)
+	{
+		assert(gGeneratedRandomNumberList[i] == gProcessedRandomNumberList[i]);
+	}
+
+	if(gProcessedRandomNumberList != gGeneratedRandomNumberList)
+	{
+		std::cerr << "Pipeline output mismatch\n";
+		std::exit(1);
+	}
+}
 
-// 3 stage pipeline
 // Pipe 1: generate input and put into Pipe 2
 // Pipe 2: process input and put into Pipe 3
 // Pipe 3: process input and compare with pipe 1's generated output
-int main()
+// Returns millions of items per second
+template<template<typename> class PipeType, typename PoolType>
+static double runPipeline()
 {
-	std::thread pipe1Thread(pipe1Process);
-	std::thread pipe2Thread(pipe2Process);
-	std::thread pipe3Thread(pipe3Process);
+	resetPipeline();
 
-	if(pipe1Thread.joinable())
-		pipe1Thread.join();
-	if(pipe2Thread.joinable())
-		pipe2Thread.join();
-	if(pipe3Thread.joinable())
-		pipe3Thread.join();
+	double throughput;
+	{
+		// SpscQueue keeps its slots inline, so the context is too big for the stack
+		using ContextType = Context<PipeType, PoolType>;
+		auto context = std::make_unique<ContextType>();
 
-	assert(gProcessedRandomNumberList.size() == gGeneratedRandomNumberList.size());
-	assert(gProcessedRandomNumberList.size() == gDataCount);
+		auto start = std::chrono::steady_clock::now();
+		std::thread pipe1Thread(pipe1Process<ContextType>, std::ref(*context));
+		std::thread pipe2Thread(pipe2Process<ContextType>, std::ref(*context));
+		std::thread pipe3Thread(pipe3Process<ContextType>, std::ref(*context));
 
-	for(std::size_t i = 0; i < gGeneratedRandomNumberList.size(); ++i)
+		if(pipe1Thread.joinable())
+			pipe1Thread.join();
+		if(pipe2Thread.joinable())
+			pipe2Thread.join();
+		if(pipe3Thread.joinable())
+			pipe3Thread.join();
+		auto end = std::chrono::steady_clock::now();
+		throughput = static_cast<double>(gDataCount) / std::chrono::duration<double, std::micro>(end - start).count();
+
+		assert(gPool1DataCounter <= (gPipeCapacity + 2 + PoolType::CachedCount));
+		assert(gPool2DataCounter <= (gPipeCapacity + 2 + PoolType::CachedCount));
+	}
+
+	checkPipeline();
+	return throughput;
+}
+
+// The same stages declared with com::Pipeline, which wires the queues and the pools by itself
+// Returns millions of items per second
+static double runPipelineFramework()
+{
+	resetPipeline();
+
+	double throughput;
+	std::vector<com::PipelineStageStats> stats;
 	{
-		assert(gGeneratedRandomNumberList[i] == gProcessedRandomNumberList[i]);
+		com::PipelineStageConfig config { .queueCapacity = gPipeCapacity };
+		auto pipeline = com::Pipeline<std::size_t>()
+							.addPooledStage<int>("pipe1", [](std::size_t, int& output) { output = GenerateRandomNumber(); },
+								[]() { ++gPool1DataCounter; return 0; }, config)
+							.addPooledStage<int>("pipe2", [](const int& input, int& output) { output = input; },
+								[]() { ++gPool2DataCounter; return 0; }, config);
+
+		auto start = std::chrono::steady_clock::now();
+		pipeline.start([](com::PipelinePooled<int> value) { gProcessedRandomNumberList.push_back(*value); });
+		for(std::size_t i = 0; i < gDataCount; ++i)
+			pipeline.push(i);
+		pipeline.close();
+		pipeline.wait();
+		auto end = std::chrono::steady_clock::now();
+		throughput = static_cast<double>(gDataCount) / std::chrono::duration<double, std::micro>(end - start).count();
+		stats = pipeline.getStats();
 	}
 
-	std::cout << "gDataCount: " << gDataCount << "\n";
+	checkPipeline();
+	for(auto& stageStats : stats)
+		std::cout << "    " << std::left << std::setw(24) << stageStats.name << std::right << std::setw(10) << (stageStats.throughput / 1000000) << " M items/s, "
+					<< stageStats.averageLatencyUs << " us/item\n";
+	return throughput;
+}
+
+int main()
+{
+	std::cout << "gDataCount: " << gDataCount << ", pipe capacity: " << gPipeCapacity << ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << std::left << std::setw(28) << "pipe" << std::right << std::setw(28) << "DynamicPoolFast + mutex" << std::setw(28) << "ConcurrentDynamicPool" << " (M items/s)\n";
+	std::cout << std::left << std::setw(28) << "ProducerConsumerBuffer" << std::right << std::setw(28) << runPipeline<ProducerConsumerBufferPipe, LockedPool>()
+				<< std::setw(28) << runPipeline<ProducerConsumerBufferPipe, ConcurrentPool>() << "\n";
+	std::cout << std::left << std::setw(28) << "SpscQueue" << std::right << std::setw(28) << runPipeline<SpscQueuePipe, LockedPool>()
+				<< std::setw(28) << runPipeline<SpscQueuePipe, ConcurrentPool>() << "\n";
+	// The pools have destroyed all of their objects by now
 	std::cout << "gPool1DataCounter: " << gPool1DataCounter << "\n";
 	std::cout << "gPool2DataCounter: " << gPool2DataCounter << "\n";
-
-	assert(gPool1DataCounter <= gDataCount);
-	assert(gPool2DataCounter <= gDataCount);
+	double frameworkThroughput = runPipelineFramework();
+	std::cout << std::left << std::setw(28) << "com::Pipeline" << std::right << std::setw(10) << frameworkThroughput << " M items/s\n";
 
 	return 0;
 }
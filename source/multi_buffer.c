@@ -1,6 +1,11 @@
 #include <common/multi_buffer.h>
 #include <common/assert.h>
 #include <common/alloc.h>
+#include <stdlib.h> // qsort
+#include <time.h> // timespec_get
+#ifdef COMPILER_MSVC
+#	include <intrin.h> // _BitScanReverse64
+#endif
 
 #ifndef GLOBAL_DEBUG
 #	define check_pre_condition(multi_buffer)
@@ -24,6 +29,138 @@ inline static buf_ucount_t get_master_index(sub_buffer_t* sub_buffer, buf_ucount
 	return sub_buffer->ptr + index;
 }
 
+static void holes_reset(multi_buffer_t* multi_buffer)
+{
+	for(u32 i = 0; i < MULTI_BUFFER_HOLE_CLASS_COUNT; i++)
+		multi_buffer->hole_heads[i] = MULTI_BUFFER_HOLE_INVALID;
+	multi_buffer->free_hole_head = MULTI_BUFFER_HOLE_INVALID;
+	multi_buffer->hole_capacity = 0;
+}
+
+/* returns the index of the most significant set bit of 'value', which must not be zero */
+static INLINE_IF_RELEASE_MODE u32 get_msb_index(u64 value)
+{
+#if defined(COMPILER_CLANG) || defined(COMPILER_MINGW) || defined(COMPILER_GCC)
+	return 63 - __builtin_clzll(value);
+#elif defined(COMPILER_MSVC) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return CAST_TO(u32, index);
+#else
+	u32 index = 0;
+	while(value >>= 1)
+		index++;
+	return index;
+#endif
+}
+
+/* returns the size class of a hole having 'capacity', i.e. floor(log2(capacity)) */
+static u32 get_hole_class(buf_ucount_t capacity)
+{
+	u32 hole_class = get_msb_index(capacity);
+	return (hole_class < MULTI_BUFFER_HOLE_CLASS_COUNT) ? hole_class : (MULTI_BUFFER_HOLE_CLASS_COUNT - 1);
+}
+
+/* returns the index of the hole record, MULTI_BUFFER_HOLE_INVALID if 'capacity' is zero */
+static u32 hole_add(multi_buffer_t* multi_buffer, buf_ucount_t ptr, buf_ucount_t capacity)
+{
+	if(capacity == 0)
+		return MULTI_BUFFER_HOLE_INVALID;
+	/* reuse an unused hole record if any */
+	u32 index = multi_buffer->free_hole_head;
+	if(index != MULTI_BUFFER_HOLE_INVALID)
+		multi_buffer->free_hole_head = buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index)->next;
+	else
+	{
+		index = CAST_TO(u32, buf_get_element_count(&multi_buffer->holes));
+		buf_push_pseudo(&multi_buffer->holes, 1);
+	}
+	u32 hole_class = get_hole_class(capacity);
+	AUTO hole = buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index);
+	hole->ptr = ptr;
+	hole->capacity = capacity;
+	hole->next = multi_buffer->hole_heads[hole_class];
+	multi_buffer->hole_heads[hole_class] = index;
+	multi_buffer->hole_capacity += capacity;
+	return index;
+}
+
+/* the size class lists are singly linked, so a hole merged into another one while compacting is only marked as killed (zero capacity),
+ * and its record is returned once it reaches the head of its list (see hole_take) */
+static void hole_kill(multi_buffer_t* multi_buffer, u32 index)
+{
+	if(index == MULTI_BUFFER_HOLE_INVALID)
+		return;
+	AUTO hole = buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index);
+	multi_buffer->hole_capacity -= hole->capacity;
+	hole->capacity = 0;
+}
+
+/* takes 'capacity' number of elements out of a hole, the rest of the hole (if any) remains a hole
+ * it only looks at the first hole of each size class, so it is O(MULTI_BUFFER_HOLE_CLASS_COUNT) */
+static bool hole_take(multi_buffer_t* multi_buffer, buf_ucount_t capacity, buf_ucount_t* out_ptr)
+{
+	/* every hole in the size class of ceil(log2(capacity)) and above is big enough (except in the last class) */
+	u32 hole_class = (capacity <= 1) ? 0 : (get_hole_class(capacity - 1) + 1);
+	for(; hole_class < MULTI_BUFFER_HOLE_CLASS_COUNT; hole_class++)
+	{
+		u32 index = multi_buffer->hole_heads[hole_class];
+		/* return the records of the killed holes at the head */
+		while((index != MULTI_BUFFER_HOLE_INVALID) && (buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index)->capacity == 0))
+		{
+			AUTO killed = buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index);
+			multi_buffer->hole_heads[hole_class] = killed->next;
+			killed->next = multi_buffer->free_hole_head;
+			multi_buffer->free_hole_head = index;
+			index = multi_buffer->hole_heads[hole_class];
+		}
+		if(index == MULTI_BUFFER_HOLE_INVALID)
+			continue;
+		AUTO hole = buf_get_ptr_at_typeof(&multi_buffer->holes, multi_buffer_hole_t, index);
+		if(hole->capacity < capacity)
+			continue;
+		multi_buffer_hole_t taken = *hole;
+		/* unlink it and return its record */
+		multi_buffer->hole_heads[hole_class] = hole->next;
+		hole->next = multi_buffer->free_hole_head;
+		multi_buffer->free_hole_head = index;
+		multi_buffer->hole_capacity -= taken.capacity;
+		hole_add(multi_buffer, taken.ptr + capacity, taken.capacity - capacity);
+		*out_ptr = taken.ptr;
+		return true;
+	}
+	return false;
+}
+
+/* grows the capacity of the sub buffer to 'capacity' without moving any other sub buffer */
+static void sub_buffer_reserve(multi_buffer_t* multi_buffer, sub_buffer_t* sub_buffer, buf_ucount_t capacity)
+{
+	BUFFER* buffer = &multi_buffer->buffer;
+	if(capacity <= sub_buffer->capacity)
+		return;
+	/* the sorted regions kept by multi_buffer_compact_incremental() don't match anymore */
+	multi_buffer->is_compacting = false;
+	/* the last sub buffer in the master buffer can be extended in place */
+	if((sub_buffer->ptr + sub_buffer->capacity) == buf_get_element_count(buffer))
+	{
+		buf_push_pseudo(buffer, capacity - sub_buffer->capacity);
+		sub_buffer->capacity = capacity;
+		return;
+	}
+	/* otherwise move it into a hole, or to the end of the master buffer, and its old region becomes a hole */
+	buf_ucount_t ptr;
+	if(!hole_take(multi_buffer, capacity, &ptr))
+	{
+		ptr = buf_get_element_count(buffer);
+		buf_push_pseudo(buffer, capacity);
+	}
+	if(sub_buffer->count > 0)
+		memcpy(buf_get_ptr_at(buffer, ptr), buf_get_ptr_at(buffer, sub_buffer->ptr), sub_buffer->count * buf_get_element_size(buffer));
+	hole_add(multi_buffer, sub_buffer->ptr, sub_buffer->capacity);
+	sub_buffer->ptr = ptr;
+	sub_buffer->capacity = capacity;
+}
+
 // constructors and destructors
 COMMON_API void multi_buffer_create(u32 element_size, u32 capacity, multi_buffer_t* out_multi_buffer)
 {
@@ -31,6 +168,12 @@ COMMON_API void multi_buffer_create(u32 element_size, u32 capacity, multi_buffer
 	out_multi_buffer->buffer = buf_create(element_size, capacity, 0);
 	out_multi_buffer->id_gen = id_generator_create(0, NULL);
 	out_multi_buffer->sub_buffers = buf_create(sizeof(sub_buffer_t), 1, 0);
+	out_multi_buffer->holes = buf_create(sizeof(multi_buffer_hole_t), 0, 0);
+	holes_reset(out_multi_buffer);
+	out_multi_buffer->is_compacting = false;
+	out_multi_buffer->compaction_regions = buf_create(sizeof(sub_buffer_region_t), 0, 0);
+	out_multi_buffer->compaction_index = 0;
+	out_multi_buffer->compaction_cursor = 0;
 }
 
 COMMON_API void multi_buffer_free(multi_buffer_t* multi_buffer)
@@ -39,6 +182,8 @@ COMMON_API void multi_buffer_free(multi_buffer_t* multi_buffer)
 	buf_free(&multi_buffer->buffer);
 	id_generator_destroy(&multi_buffer->id_gen);
 	buf_free(&multi_buffer->sub_buffers);
+	buf_free(&multi_buffer->holes);
+	buf_free(&multi_buffer->compaction_regions);
 }
 
 // getters
@@ -68,6 +213,8 @@ COMMON_API buf_ucount_t multi_buffer_get_combined_sub_buffers_count(multi_buffer
 	return total_count;
 }
 
+/* multi_buffer_verify() walks all the sub buffers, so it is compiled in only in the debug builds or if COMMON_MULTI_BUFFER_VALIDATE is defined */
+#if defined(COMMON_DEBUG) || defined(COMMON_MULTI_BUFFER_VALIDATE)
 static void multi_buffer_verify(multi_buffer_t* multi_buffer)
 {
 	buf_ucount_t total_count = 0;
@@ -77,8 +224,11 @@ static void multi_buffer_verify(multi_buffer_t* multi_buffer)
 		AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, i);
 		total_count += sub_buffer->capacity;
 	}
-	_com_assert(total_count == multi_buffer->buffer.element_count);
+	_com_assert((total_count + multi_buffer->hole_capacity) == multi_buffer->buffer.element_count);
 }
+#else
+#	define multi_buffer_verify(multi_buffer)
+#endif /* COMMON_DEBUG || COMMON_MULTI_BUFFER_VALIDATE */
 
 COMMON_API buf_ucount_t multi_buffer_get_sub_buffer_count(multi_buffer_t* multi_buffer)
 {
@@ -94,6 +244,9 @@ COMMON_API void multi_buffer_clear(multi_buffer_t* multi_buffer)
 	buf_clear(&multi_buffer->buffer, NULL);
 	id_generator_reset(&multi_buffer->id_gen, 0);
 	buf_clear(&multi_buffer->sub_buffers, NULL);
+	buf_clear(&multi_buffer->holes, NULL);
+	holes_reset(multi_buffer);
+	multi_buffer->is_compacting = false;
 }
 COMMON_API void multi_buffer_flatcopy_to(multi_buffer_t* multi_buffer, void* dst_ptr)
 {
@@ -112,6 +265,167 @@ COMMON_API void multi_buffer_flatcopy_to(multi_buffer_t* multi_buffer, void* dst
 	}
 }
 
+static int compare_regions(const void* lhs, const void* rhs)
+{
+	buf_ucount_t lhs_ptr = CAST_TO(const sub_buffer_region_t*, lhs)->ptr;
+	buf_ucount_t rhs_ptr = CAST_TO(const sub_buffer_region_t*, rhs)->ptr;
+	return (lhs_ptr < rhs_ptr) ? -1 : ((lhs_ptr > rhs_ptr) ? 1 : 0);
+}
+
+static u64 get_time_us(void)
+{
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
+	return CAST_TO(u64, time.tv_sec) * 1000000ULL + CAST_TO(u64, time.tv_nsec) / 1000ULL;
+}
+
+static buf_ucount_t get_trimmed_capacity(sub_buffer_t* sub_buffer, multi_buffer_trim_policy_t policy)
+{
+	buf_ucount_t capacity = sub_buffer->capacity;
+	switch(policy)
+	{
+		case MULTI_BUFFER_TRIM_EXACT:
+			capacity = sub_buffer->count;
+			break;
+		case MULTI_BUFFER_TRIM_POWER_OF_TWO:
+			capacity = (sub_buffer->count == 0) ? 0 : 1;
+			while(capacity < sub_buffer->count)
+				capacity <<= 1;
+			break;
+		default:
+			break;
+	}
+	return (capacity < sub_buffer->capacity) ? capacity : sub_buffer->capacity;
+}
+
+/* sorts the regions of the sub buffers by their locations, and turns the gaps in between them into holes
+ * returns the number of elements removed from the end of the master buffer */
+static buf_ucount_t compaction_begin(multi_buffer_t* multi_buffer)
+{
+	BUFFER* buffer = &multi_buffer->buffer;
+	BUFFER* regions = &multi_buffer->compaction_regions;
+
+	/* collect the regions of the sub buffers, the destroyed ones give up theirs */
+	buf_clear(regions, NULL);
+	buf_ucount_t sub_buffer_count = buf_get_element_count(&multi_buffer->sub_buffers);
+	for(buf_ucount_t i = 0; i < sub_buffer_count; i++)
+	{
+		AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, i);
+		if(sub_buffer->is_free)
+			sub_buffer->capacity = 0;
+		if(sub_buffer->capacity == 0)
+		{
+			sub_buffer->ptr = 0;
+			continue;
+		}
+		sub_buffer_region_t region = { sub_buffer->ptr, CAST_TO(sub_buffer_handle_t, i), MULTI_BUFFER_HOLE_INVALID };
+		buf_push(regions, &region);
+	}
+	buf_ucount_t region_count = buf_get_element_count(regions);
+	sub_buffer_region_t* sorted_regions = CAST_TO(sub_buffer_region_t*, buf_get_ptr(regions));
+	if(region_count > 0)
+		qsort(sorted_regions, region_count, sizeof(sub_buffer_region_t), compare_regions);
+
+	/* each gap is recorded along with the sub buffer which follows it, so that it can be merged into the compacted part */
+	buf_clear(&multi_buffer->holes, NULL);
+	holes_reset(multi_buffer);
+	buf_ucount_t end = 0;
+	for(buf_ucount_t i = 0; i < region_count; i++)
+	{
+		AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, sorted_regions[i].handle);
+		sorted_regions[i].hole = hole_add(multi_buffer, end, sub_buffer->ptr - end);
+		end = sub_buffer->ptr + sub_buffer->capacity;
+	}
+	multi_buffer->is_compacting = true;
+	multi_buffer->compaction_index = 0;
+	multi_buffer->compaction_cursor = 0;
+
+	/* and the free space at the end is removed */
+	buf_ucount_t old_count = buf_get_element_count(buffer);
+	if(end < old_count)
+		buf_remove_pseudo(buffer, end, old_count - end);
+	return old_count - end;
+}
+
+/* slides the sub buffers, in the order of their locations, down to the end of the previous one
+ * and resumes from where the previous call has stopped, unless the layout of the sub buffers has changed since then */
+static buf_ucount_t compact(multi_buffer_t* multi_buffer, multi_buffer_trim_policy_t policy, u64 time_budget_us, bool* out_is_complete)
+{
+	check_pre_condition(multi_buffer);
+	BUFFER* buffer = &multi_buffer->buffer;
+	u32 element_size = buf_get_element_size(buffer);
+	u64 start_time = get_time_us();
+	buf_ucount_t reclaimed_count = multi_buffer->is_compacting ? 0 : compaction_begin(multi_buffer);
+
+	buf_ucount_t region_count = buf_get_element_count(&multi_buffer->compaction_regions);
+	sub_buffer_region_t* sorted_regions = CAST_TO(sub_buffer_region_t*, buf_get_ptr(&multi_buffer->compaction_regions));
+	/* everything below 'cursor' is compacted */
+	buf_ucount_t cursor = multi_buffer->compaction_cursor;
+	bool is_moved = false;
+	buf_ucount_t i = multi_buffer->compaction_index;
+	for(; i < region_count; i++)
+	{
+		AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, sorted_regions[i].handle);
+		if(sub_buffer->ptr != cursor)
+		{
+			/* at least one sub buffer is moved in each call */
+			if(is_moved && ((get_time_us() - start_time) >= time_budget_us))
+				break;
+			/* the destination never overlaps with the other sub buffers as [cursor, sub_buffer->ptr) is free */
+			if(sub_buffer->count > 0)
+				memmove(buf_get_ptr_at(buffer, cursor), buf_get_ptr_at(buffer, sub_buffer->ptr), sub_buffer->count * element_size);
+			sub_buffer->ptr = cursor;
+			is_moved = true;
+		}
+		/* the gap before it is now part of the compacted part */
+		hole_kill(multi_buffer, sorted_regions[i].hole);
+		sub_buffer->capacity = get_trimmed_capacity(sub_buffer, policy);
+		cursor += sub_buffer->capacity;
+	}
+	if(out_is_complete != NULL)
+		*out_is_complete = (i == region_count);
+
+	if(i < region_count)
+	{
+		/* the gap in between the compacted part and the next sub buffer has grown by the regions left behind */
+		AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, sorted_regions[i].handle);
+		hole_kill(multi_buffer, sorted_regions[i].hole);
+		sorted_regions[i].hole = hole_add(multi_buffer, cursor, sub_buffer->ptr - cursor);
+		multi_buffer->compaction_index = i;
+		multi_buffer->compaction_cursor = cursor;
+	}
+	else
+	{
+		/* no hole is left, and the free space at the end is removed */
+		buf_clear(&multi_buffer->holes, NULL);
+		holes_reset(multi_buffer);
+		buf_ucount_t count = buf_get_element_count(buffer);
+		if(cursor < count)
+		{
+			buf_remove_pseudo(buffer, cursor, count - cursor);
+			reclaimed_count += count - cursor;
+		}
+		multi_buffer->is_compacting = false;
+	}
+	multi_buffer_verify(multi_buffer);
+	return reclaimed_count * element_size;
+}
+
+COMMON_API buf_ucount_t multi_buffer_compact(multi_buffer_t* multi_buffer, multi_buffer_trim_policy_t policy)
+{
+	buf_ucount_t reclaimed_size = compact(multi_buffer, policy, U64_MAX, NULL);
+	/* also release the memory */
+	buf_ucount_t count = buf_get_element_count(&multi_buffer->buffer);
+	if((count > 0) && (count < buf_get_capacity(&multi_buffer->buffer)))
+		buf_resize(&multi_buffer->buffer, count);
+	return reclaimed_size;
+}
+
+COMMON_API buf_ucount_t multi_buffer_compact_incremental(multi_buffer_t* multi_buffer, multi_buffer_trim_policy_t policy, u64 time_budget_us, bool* out_is_complete)
+{
+	return compact(multi_buffer, policy, time_budget_us, out_is_complete);
+}
+
 // sub buffer
 
 // constructors and destructors
@@ -125,35 +439,33 @@ COMMON_API sub_buffer_handle_t multi_buffer_sub_buffer_create(multi_buffer_t* mu
 	AUTO id = id_generator_get(&multi_buffer->id_gen);
 	if(id < buf_get_element_count(sub_buffers))
 	{
+		/* a destroyed sub buffer keeps its region, grow it if needed */
 		sub_buffer = buf_get_ptr_at_typeof(sub_buffers, sub_buffer_t, id);
-		if(capacity > sub_buffer->capacity)
-		{
-			buf_insert_pseudo(buffer, sub_buffer->ptr, capacity - sub_buffer->capacity);
-			sub_buffer->capacity = capacity;
-		}
+		sub_buffer->count = 0;
+		sub_buffer_reserve(multi_buffer, sub_buffer, capacity);
 	}
 	else
 	{
-		/* the base offset of this sub buffer should be after the 'combined sub buffers capacity' including the free ones */
-		buf_ucount_t base_offset = 0;
-		u32 sub_buffer_count = buf_get_element_count(sub_buffers);
-		for(u32 i = 0; i < sub_buffer_count; i++)
+		buf_ucount_t base_offset;
+		/* place it into a hole if there is a big enough one, otherwise at the end of the master buffer */
+		if((capacity == 0) || !hole_take(multi_buffer, capacity, &base_offset))
 		{
-			AUTO sub_buffer = buf_get_ptr_at_typeof(&multi_buffer->sub_buffers, sub_buffer_t, i);
-			base_offset += sub_buffer->capacity;
+			base_offset = buf_get_element_count(buffer);
+			if(capacity != 0)
+				// extend the master buffer to fit the newly created sub_buffer's capacity
+				buf_push_pseudo(buffer, capacity);
 		}
 		// create a new sub_buffer_t instance
 		buf_push_pseudo(sub_buffers, 1);
 		sub_buffer = buf_peek_ptr(sub_buffers);
 		sub_buffer->is_free = true;
 		sub_buffer->ptr = base_offset;
-		if(capacity != 0)
-			// extend the master buffer to fit the newly created sub_buffer's capacity
-			buf_push_pseudo(buffer, capacity);
 		sub_buffer->capacity = capacity;
 	}
 	_com_assert(sub_buffer->is_free);
 	sub_buffer->is_free = false;
+	/* the sorted regions kept by multi_buffer_compact_incremental() don't match anymore */
+	multi_buffer->is_compacting = false;
 	// set the element count in the newly created sub_buffer to zero
 	sub_buffer->count = 0;
 	// return the index of the newly created sub_buffer in the sub_buffers buffer as a handle to it
@@ -169,6 +481,7 @@ COMMON_API void multi_buffer_sub_buffer_destroy(multi_buffer_t* multi_buffer, su
 	id_generator_return(&multi_buffer->id_gen, handle);
 	sub_buffer->is_free = true;
 	sub_buffer->count = 0;
+	multi_buffer->is_compacting = false;
 	multi_buffer_verify(multi_buffer);
 }
 
@@ -181,22 +494,13 @@ COMMON_API void multi_buffer_sub_buffer_push(multi_buffer_t* multi_buffer, sub_b
 COMMON_API void multi_buffer_sub_buffer_push_n(multi_buffer_t* multi_buffer, sub_buffer_handle_t handle, void* in_value, u32 max_size)
 {
 	check_pre_condition(multi_buffer);
-	BUFFER* sub_buffers = &multi_buffer->sub_buffers;
 	sub_buffer_t* sub_buffer = get_sub_buffer(multi_buffer, handle);
 
-	// resize the master buffer if needed
-	buf_ucount_t prev_capacity = sub_buffer->capacity;
-	sub_buffer->capacity = (sub_buffer->capacity == 0) ? 1 : sub_buffer->capacity;
-	if(sub_buffer->capacity < (sub_buffer->count + 1))
-		sub_buffer->capacity <<= 1; 		// multiply by 2
-	if(sub_buffer->capacity > prev_capacity)
-	{
-		buf_ucount_t diff = sub_buffer->capacity - prev_capacity;
-		buf_insert_pseudo(&multi_buffer->buffer, sub_buffer->ptr + sub_buffer->count, diff);
-		// update the pointers of the sub_buffers to the new location
-		for(buf_ucount_t i = handle + 1; i < buf_get_element_count(sub_buffers); i++)
-			((sub_buffer_t*)buf_get_ptr_at(sub_buffers, i))->ptr += diff;
-	}
+	// grow the sub buffer if needed
+	buf_ucount_t capacity = (sub_buffer->capacity == 0) ? 1 : sub_buffer->capacity;
+	if(capacity < (sub_buffer->count + 1))
+		capacity <<= 1; 		// multiply by 2
+	sub_buffer_reserve(multi_buffer, sub_buffer, capacity);
 
 	// push the value
 	buf_set_at_n(&multi_buffer->buffer, sub_buffer->ptr + sub_buffer->count, in_value, max_size);
@@ -280,6 +584,20 @@ COMMON_API void* multi_buffer_sub_buffer_get_ptr_at(multi_buffer_t* multi_buffer
 	return buf_get_ptr_at(&multi_buffer->buffer, get_master_index(get_sub_buffer(multi_buffer, handle), index));
 }
 
+COMMON_API void multi_buffer_sub_buffer_prefetch(multi_buffer_t* multi_buffer, sub_buffer_handle_t handle)
+{
+	check_pre_condition(multi_buffer);
+	COM_PREFETCH_READ(get_sub_buffer(multi_buffer, handle));
+}
+
+COMMON_API void multi_buffer_sub_buffer_prefetch_elements(multi_buffer_t* multi_buffer, sub_buffer_handle_t handle)
+{
+	check_pre_condition(multi_buffer);
+	sub_buffer_t* sub_buffer = get_sub_buffer(multi_buffer, handle);
+	if(sub_buffer->count > 0)
+		COM_PREFETCH_READ(buf_get_ptr_at(&multi_buffer->buffer, sub_buffer->ptr));
+}
+
 // setters
 COMMON_API void multi_buffer_sub_buffer_set_at(multi_buffer_t* multi_buffer, sub_buffer_handle_t handle, buf_ucount_t index, void* in_value)
 {
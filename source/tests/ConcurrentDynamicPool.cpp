@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/ConcurrentDynamicPool.hpp>
+#include <common/SpscQueue.hpp>
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+TEST_CASE( "ConcurrentDynamicPool", "[concurrent-dynamic-pool]" ) {
+
+	std::atomic<int> createCount = 0;
+	std::atomic<int> destroyCount = 0;
+	auto onCreate = [&createCount]() { return std::make_unique<int>(createCount++); };
+	auto onDestroy = [&destroyCount](std::unique_ptr<int>&) { ++destroyCount; };
+	using Pool = com::ConcurrentDynamicPool<std::unique_ptr<int>>;
+
+	SECTION( "Single thread" ) {
+		{
+			Pool pool(onCreate, onDestroy);
+			auto v1 = pool.get();
+			auto v2 = pool.get();
+			REQUIRE( createCount == 2 );
+			REQUIRE( pool.size() == 2 );
+			int* p1 = v1.get();
+			pool.put(std::move(v1));
+			/* the last one put back is the first one to be reused */
+			auto v3 = pool.get();
+			REQUIRE( v3.get() == p1 );
+			REQUIRE( createCount == 2 );
+			pool.put(std::move(v2));
+			pool.put(std::move(v3));
+			/* more than two magazines worth, some of them go through the depot */
+			std::vector<std::unique_ptr<int>> values;
+			for(std::size_t i = 0; i < 5 * Pool::MagazineSize; ++i)
+				values.push_back(pool.get());
+			for(auto& value : values)
+				pool.put(std::move(value));
+			values.clear();
+			int count = createCount;
+			for(std::size_t i = 0; i < 5 * Pool::MagazineSize; ++i)
+				values.push_back(pool.get());
+			REQUIRE( createCount == count );
+			for(auto& value : values)
+				pool.put(std::move(value));
+			REQUIRE( destroyCount == 0 );
+		}
+		/* the pool destroys everything it holds */
+		REQUIRE( destroyCount == createCount );
+	}
+
+	SECTION( "Callbacks" ) {
+		int returnCount = 0;
+		int recycleCount = 0;
+		Pool pool(onCreate, onDestroy, [&returnCount](std::unique_ptr<int>&) { ++returnCount; }, [&recycleCount](std::unique_ptr<int>&) { ++recycleCount; });
+		auto value = pool.get();
+		REQUIRE( recycleCount == 0 );
+		pool.put(std::move(value));
+		REQUIRE( returnCount == 1 );
+		value = pool.get();
+		REQUIRE( recycleCount == 1 );
+		pool.put(std::move(value));
+		pool.reserve(100);
+		REQUIRE( createCount == 101 );
+		REQUIRE( returnCount == 102 );
+		REQUIRE( pool.size() == 101 );
+	}
+
+	SECTION( "Objects put back on one thread are reused on another" ) {
+		constexpr int count = 1000;
+		Pool pool(onCreate, onDestroy);
+		std::vector<std::unique_ptr<int>> values;
+		for(int i = 0; i < count; ++i)
+			values.push_back(pool.get());
+		/* the thread puts them back and exits, which hands its magazines over to the depot */
+		std::thread([&pool, &values]()
+		{
+			for(auto& value : values)
+				pool.put(std::move(value));
+		}).join();
+		values.clear();
+		for(int i = 0; i < count; ++i)
+			values.push_back(pool.get());
+		REQUIRE( createCount == count );
+		for(auto& value : values)
+			pool.put(std::move(value));
+	}
+
+	SECTION( "One thread gets, another puts" ) {
+		constexpr int count = 100000;
+		constexpr std::size_t capacity = 64;
+		{
+			Pool pool(onCreate, onDestroy);
+			auto queue = std::make_unique<com::SpscQueue<std::unique_ptr<int>, capacity>>();
+			std::thread consumer([&pool, &queue]()
+			{
+				for(int i = 0; i < count; ++i)
+					pool.put(queue->pop());
+			});
+			for(int i = 0; i < count; ++i)
+				queue->push(pool.get());
+			consumer.join();
+			/* an object is created only when the producer's magazines and the depot are empty,
+			 * so all the others are in the queue, in the consumer's magazines, or in the hands of either thread */
+			REQUIRE( createCount <= static_cast<int>(capacity + 2 * Pool::MagazineSize + 2) );
+			REQUIRE( pool.size() == static_cast<std::size_t>(createCount) );
+		}
+		REQUIRE( destroyCount == createCount );
+	}
+
+	SECTION( "The objects beyond the depot's capacity are destroyed" ) {
+		Pool pool(onCreate, onDestroy, nullptr, nullptr, 2);
+		std::vector<std::unique_ptr<int>> values;
+		for(std::size_t i = 0; i < 10 * Pool::MagazineSize; ++i)
+			values.push_back(pool.get());
+		for(auto& value : values)
+			pool.put(std::move(value));
+		/* 2 magazines in the thread's cache and 2 in the depot */
+		REQUIRE( pool.size() == 4 * Pool::MagazineSize );
+		REQUIRE( destroyCount == static_cast<int>(6 * Pool::MagazineSize) );
+	}
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/ConcurrentEvent.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+
+struct ConcurrentEventPublisher
+{
+	int id = 3;
+};
+
+/* unsubscribes on destruction, like a RAII subscription guard captured in a handler */
+struct ConcurrentEventGuard
+{
+	com::ConcurrentEvent<com::no_publish_ptr_t, int>* event;
+	com::ConcurrentEvent<com::no_publish_ptr_t, int>::SubscriptionID id;
+	~ConcurrentEventGuard() { event->unsubscribe(id); }
+};
+
+TEST_CASE( "ConcurrentEvent", "[concurrent-event]" ) {
+
+	SECTION( "Single thread" ) {
+		com::ConcurrentEvent<com::no_publish_ptr_t, int> event;
+		/* no subscription */
+		event.publish(1);
+		int sumA = 0;
+		int sumB = 0;
+		auto idA = event.subscribe([&sumA](int value) { sumA += value; });
+		auto idB = event.subscribe([&sumB](int value) { sumB += value; });
+		REQUIRE( event.size() == 2 );
+		event.publish(2);
+		REQUIRE( sumA == 2 );
+		REQUIRE( sumB == 2 );
+		event.deactivate(idA);
+		event.publish(3);
+		REQUIRE( sumA == 2 );
+		REQUIRE( sumB == 5 );
+		event.activate(idA);
+		event.unsubscribe(idB);
+		REQUIRE( event.size() == 1 );
+		event.publish(4);
+		REQUIRE( sumA == 6 );
+		REQUIRE( sumB == 5 );
+		event.clear();
+		REQUIRE( event.size() == 0 );
+		event.publish(5);
+		REQUIRE( sumA == 6 );
+	}
+
+	SECTION( "Mutations from a handler" ) {
+		com::ConcurrentEvent<com::no_publish_ptr_t, int> event;
+		int count = 0;
+		com::ConcurrentEvent<com::no_publish_ptr_t, int>::SubscriptionID id = 0;
+		id = event.subscribe([&](int value)
+		{
+			++count;
+			/* the publish() in progress keeps invoking its snapshot, the new handler is invoked from the next publish() */
+			event.subscribe([&count](int) { count += 10; });
+			event.unsubscribe(id);
+			/* nested publish */
+			if(value > 0)
+				event.publish(value - 1);
+		});
+		event.publish(1);
+		/* the outer handler, then the nested publish() invokes the outer handler no more but the one subscribed by it */
+		REQUIRE( count == 11 );
+		REQUIRE( event.size() == 1 );
+	}
+
+	SECTION( "Handler captures unsubscribing on destruction" ) {
+		com::ConcurrentEvent<com::no_publish_ptr_t, int> event;
+		int count = 0;
+		auto idA = event.subscribe([&count](int) { ++count; });
+		auto idB = event.subscribe([&count](int) { ++count; });
+		/* the last copy of the guard is destroyed along with the handler (or a snapshot holding it), it must not deadlock */
+		auto guardA = std::make_shared<ConcurrentEventGuard>(&event, idA);
+		auto guardB = std::make_shared<ConcurrentEventGuard>(&event, idB);
+		auto idC = event.subscribe([guardA](int) { });
+		event.subscribe([guardB](int) { });
+		guardA.reset();
+		guardB.reset();
+		event.publish(1);
+		REQUIRE( count == 2 );
+		event.unsubscribe(idC);
+		event.synchronize();
+		REQUIRE( event.size() == 2 );
+		event.publish(1);
+		REQUIRE( count == 3 );
+		/* the same through clear() */
+		event.clear();
+		event.synchronize();
+		REQUIRE( event.size() == 0 );
+	}
+
+	SECTION( "Publisher" ) {
+		ConcurrentEventPublisher publisher;
+		com::ConcurrentEvent<ConcurrentEventPublisher, int> event(&publisher);
+		int sum = 0;
+		event.subscribe([&sum](ConcurrentEventPublisher* ptr, int value) { sum += ptr->id * value; });
+		event.publish(2);
+		REQUIRE( sum == 6 );
+	}
+
+	SECTION( "Subscriptions from many threads while publishing" ) {
+		constexpr int publisherCount = 3;
+		constexpr int subscriberCount = 3;
+		constexpr int subscriptionsPerThread = 300;
+		com::ConcurrentEvent<com::no_publish_ptr_t, int> event;
+		/* subscribed all along, so each publish() invokes it */
+		std::atomic<long long> permanentCount = 0;
+		event.subscribe([&permanentCount](int) { permanentCount.fetch_add(1, std::memory_order_relaxed); });
+		std::atomic<bool> isPublishing = true;
+		std::atomic<long long> publishCount = 0;
+		std::vector<std::thread> publishers;
+		for(int i = 0; i < publisherCount; ++i)
+			publishers.emplace_back([&]()
+			{
+				while(isPublishing.load(std::memory_order_relaxed))
+				{
+					event.publish(1);
+					publishCount.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+		std::atomic<bool> isCalledAfterUnsubscribe = false;
+		std::vector<std::thread> subscribers;
+		for(int i = 0; i < subscriberCount; ++i)
+			subscribers.emplace_back([&]()
+			{
+				for(int j = 0; j < subscriptionsPerThread; ++j)
+				{
+					/* no publish() may invoke the handler once synchronize() has returned */
+					auto state = std::make_unique<std::atomic<bool>>(true);
+					auto id = event.subscribe([&isCalledAfterUnsubscribe, ptr = state.get()](int)
+					{
+						if(!ptr->load(std::memory_order_relaxed))
+							isCalledAfterUnsubscribe = true;
+					});
+					event.unsubscribe(id);
+					event.synchronize();
+					state->store(false, std::memory_order_relaxed);
+				}
+			});
+		for(auto& thread : subscribers)
+			thread.join();
+		isPublishing = false;
+		for(auto& thread : publishers)
+			thread.join();
+		REQUIRE( !isCalledAfterUnsubscribe );
+		REQUIRE( permanentCount == publishCount );
+		REQUIRE( event.size() == 1 );
+		event.synchronize();
+		REQUIRE( com::EpochDomain::global().getRetiredCount() == 0 );
+	}
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/Delegate.hpp>
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <string>
+
+namespace
+{
+	class Counter
+	{
+	public:
+		int count = 0;
+		auto getHandler() { return [this](int value) { count += value; }; }
+	};
+
+	// Counts the live copies of itself
+	struct Tracked
+	{
+		int* liveCount;
+		Tracked(int* count) : liveCount(count) { ++(*liveCount); }
+		Tracked(const Tracked& tracked) : liveCount(tracked.liveCount) { ++(*liveCount); }
+		~Tracked() { --(*liveCount); }
+		int operator()(int value) const { return value + 1; }
+	};
+}
+
+TEST_CASE( "Delegate", "[delegate]" ) {
+
+	SECTION( "Small callables are stored inline" ) {
+		Counter counter;
+		using Handler = com::Delegate<void(int)>;
+		static_assert(Handler::IsInline<decltype(counter.getHandler())>);
+		int* pointer = nullptr;
+		long long number = 0;
+		auto lambda = [&counter, pointer, number](int) { };
+		static_assert(Handler::IsInline<decltype(lambda)>);
+		static_assert(!Handler::IsInline<std::string>);
+		static_assert(!Handler::IsInline<Tracked>);
+		static_assert(!com::Delegate<void(int), sizeof(void*)>::IsInline<decltype(lambda)>);
+
+		Handler handler = counter.getHandler();
+		REQUIRE( static_cast<bool>(handler) );
+		handler(3);
+		handler(4);
+		REQUIRE( counter.count == 7 );
+	}
+
+	SECTION( "Empty delegates" ) {
+		com::Delegate<int(int)> delegate;
+		REQUIRE( !delegate );
+		REQUIRE( delegate == nullptr );
+		delegate = [](int value) { return value * 2; };
+		REQUIRE( delegate(21) == 42 );
+		delegate = nullptr;
+		REQUIRE( !delegate );
+	}
+
+	SECTION( "Copies and moves of a delegate" ) {
+		int liveCount = 0;
+		{
+			com::Delegate<int(int)> delegate = Tracked(&liveCount);
+			REQUIRE( liveCount == 1 );
+			auto copy = delegate;
+			REQUIRE( liveCount == 2 );
+			REQUIRE( copy(1) == 2 );
+			/* moving doesn't copy the callable */
+			auto moved = std::move(delegate);
+			REQUIRE( liveCount == 2 );
+			REQUIRE( !delegate );
+			REQUIRE( moved(2) == 3 );
+			/* and neither does a vector of delegates when it grows */
+			std::vector<com::Delegate<int(int)>> delegates;
+			for(int i = 0; i < 100; ++i)
+				delegates.push_back(moved);
+			REQUIRE( liveCount == 102 );
+			delegates.clear();
+			copy = moved;
+			REQUIRE( liveCount == 2 );
+		}
+		REQUIRE( liveCount == 0 );
+	}
+
+	SECTION( "Mutable and large callables" ) {
+		std::array<int, 16> values { };
+		com::Delegate<int()> delegate = [values, index = 0]() mutable
+		{
+			values[index] = index;
+			return index++;
+		};
+		REQUIRE( delegate() == 0 );
+		REQUIRE( delegate() == 1 );
+		auto copy = delegate;
+		REQUIRE( copy() == 2 );
+		REQUIRE( delegate() == 2 );
+	}
+
+	SECTION( "The arguments are forwarded" ) {
+		auto value = std::make_unique<int>(5);
+		com::Delegate<int(std::unique_ptr<int>)> take = [](std::unique_ptr<int> ptr) { return *ptr; };
+		REQUIRE( take(std::move(value)) == 5 );
+		REQUIRE( value == nullptr );
+		std::string text = "text";
+		com::Delegate<void(std::string&)> append = [](std::string& str) { str += "s"; };
+		append(text);
+		REQUIRE( text == "texts" );
+		/* the return value of a callable is discarded by a delegate returning void */
+		com::Delegate<void(int)> discard = [](int value) { return value; };
+		discard(1);
+	}
+}
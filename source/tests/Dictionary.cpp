@@ -0,0 +1,283 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/dictionary.h>
+#include <common/hash_function.h>
+#include <common/comparer.h>
+#include <common/Dictionary.hpp>
+
+#include <vector>
+#include <string>
+
+TEST_CASE( "dictionary_t hashed", "[dictionary_t]" ) {
+
+    dictionary_t dict = dictionary_create_hashed(u32, u64, 0, dictionary_key_comparer_u32, u32_hash);
+    REQUIRE( dictionary_is_hashed(&dict) == true );
+
+    SECTION( "Lookup" ) {
+        for(u32 i = 0; i < 10000; ++i)
+        {
+            u64 value = i * 3;
+            dictionary_push(&dict, &i, &value);
+        }
+        REQUIRE( dictionary_get_count(&dict) == 10000 );
+        for(u32 i = 0; i < 10000; ++i)
+        {
+            /* insertion order is preserved */
+            REQUIRE( dictionary_find_index_of(&dict, &i) == i );
+            REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&dict, i)) == i );
+            u64 value;
+            dictionary_get_value(&dict, &i, &value);
+            REQUIRE( value == i * 3 );
+        }
+        u32 key = 10000;
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+        u64 value;
+        REQUIRE( dictionary_try_get_value(&dict, &key, &value) == false );
+        value = 7;
+        key = 42;
+        dictionary_set_value(&dict, &key, &value);
+        value = 0;
+        dictionary_get_value(&dict, &key, &value);
+        REQUIRE( value == 7 );
+    }
+
+    SECTION( "Remove, pop and set_at" ) {
+        for(u32 i = 0; i < 1000; ++i)
+        {
+            u64 value = i;
+            dictionary_push(&dict, &i, &value);
+        }
+        for(u32 i = 0; i < 1000; i += 2)
+            dictionary_remove(&dict, &i);
+        REQUIRE( dictionary_get_count(&dict) == 500 );
+        for(u32 i = 0; i < 1000; ++i)
+        {
+            REQUIRE( dictionary_contains(&dict, &i) == ((i % 2) == 1) );
+            if((i % 2) == 1)
+                REQUIRE( dictionary_find_index_of(&dict, &i) == i / 2 );
+        }
+        u32 key;
+        u64 value;
+        dictionary_pop(&dict, &key, &value);
+        REQUIRE( key == 999 );
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+        /* replaces the key 1 with the key 5000 */
+        key = 5000;
+        value = 1;
+        dictionary_set_at(&dict, 0, &key, &value);
+        key = 1;
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+        key = 5000;
+        REQUIRE( dictionary_find_index_of(&dict, &key) == 0 );
+        dictionary_clear(&dict);
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+        dictionary_push(&dict, &key, &value);
+        REQUIRE( dictionary_find_index_of(&dict, &key) == 0 );
+    }
+
+    dictionary_free(&dict);
+}
+
+TEST_CASE( "dictionary_t string keys", "[dictionary_t]" ) {
+
+    std::vector<std::string> strings;
+    for(int i = 0; i < 500; ++i)
+        strings.push_back(std::string("key_") + std::to_string(i));
+
+    dictionary_t linear = dictionary_create(const char*, int, 0, dictionary_key_comparer_string);
+    dictionary_t hashed = dictionary_create_hashed(const char*, int, 0, dictionary_key_comparer_string, string_hash);
+    REQUIRE( dictionary_is_hashed(&linear) == false );
+    for(int i = 0; i < 500; ++i)
+    {
+        const char* str = strings[i].c_str();
+        dictionary_push(&linear, &str, &i);
+        dictionary_push(&hashed, &str, &i);
+    }
+    for(int i = 499; i >= 0; --i)
+    {
+        /* a different pointer to an equal string */
+        std::string copy = strings[i];
+        const char* str = copy.c_str();
+        int value1, value2;
+        REQUIRE( dictionary_try_get_value(&linear, &str, &value1) == true );
+        REQUIRE( dictionary_try_get_value(&hashed, &str, &value2) == true );
+        REQUIRE( value1 == i );
+        REQUIRE( value2 == i );
+    }
+    dictionary_free(&linear);
+    dictionary_free(&hashed);
+}
+
+TEST_CASE( "dictionary_t sorted", "[dictionary_t]" ) {
+
+    std::vector<u32> keys;
+    std::vector<u32> values;
+    for(u32 i = 0; i < 2000; ++i)
+    {
+        /* a permutation of [0, 2000) */
+        keys.push_back((i * 7919) % 2000);
+        values.push_back(keys.back() + 1);
+    }
+
+    SECTION( "Bulk load" ) {
+        dictionary_t dict = dictionary_create_sorted(u32, u32, 0, dictionary_key_comparer_u32, u32_less_than);
+        REQUIRE( dictionary_is_sorted(&dict) == true );
+        dictionary_bulk_load(&dict, keys.data(), values.data(), 1000);
+        dictionary_bulk_load(&dict, keys.data() + 1000, values.data() + 1000, 1000);
+        REQUIRE( dictionary_get_count(&dict) == 2000 );
+        for(u32 i = 0; i < 2000; ++i)
+        {
+            REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&dict, i)) == i );
+            REQUIRE( dictionary_find_index_of(&dict, &i) == i );
+            u32 value;
+            REQUIRE( dictionary_try_get_value(&dict, &i, &value) == true );
+            REQUIRE( value == i + 1 );
+        }
+        u32 key = 2000;
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+
+        /* push and remove keep the order */
+        key = 5;
+        dictionary_remove(&dict, &key);
+        REQUIRE( dictionary_contains(&dict, &key) == false );
+        REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&dict, 5)) == 6 );
+        u32 value = 100;
+        dictionary_push(&dict, &key, &value);
+        REQUIRE( dictionary_find_index_of(&dict, &key) == 5 );
+        dictionary_free(&dict);
+    }
+
+    SECTION( "Freeze" ) {
+        dictionary_t dict = dictionary_create_hashed(u32, u32, 0, dictionary_key_comparer_u32, u32_hash);
+        dictionary_bulk_load(&dict, keys.data(), values.data(), keys.size());
+        REQUIRE( dictionary_find_index_of(&dict, &keys[10]) == 10 );
+        dictionary_freeze(&dict, u32_less_than);
+        REQUIRE( dictionary_is_hashed(&dict) == false );
+        REQUIRE( dictionary_is_sorted(&dict) == true );
+        for(u32 i = 0; i < 2000; ++i)
+        {
+            REQUIRE( dictionary_find_index_of(&dict, &i) == i );
+            REQUIRE( DREF_TO(u32, dictionary_get_value_ptr_at(&dict, i)) == i + 1 );
+        }
+        dictionary_free(&dict);
+    }
+
+    SECTION( "String keys ordered by their length" ) {
+        /* string_less_than only compares the lengths, so the keys of the same length are equivalent but not equal */
+        dictionary_t dict = dictionary_create_sorted(const char*, int, 0, dictionary_key_comparer_string, string_less_than);
+        const char* strings[] = { "abc", "xyz", "foo", "a", "longer" };
+        for(int i = 0; i < 5; ++i)
+            dictionary_push(&dict, &strings[i], &i);
+        for(int i = 0; i < 5; ++i)
+        {
+            /* a different pointer to an equal string */
+            std::string copy = strings[i];
+            const char* str = copy.c_str();
+            int value;
+            REQUIRE( dictionary_contains(&dict, &str) == true );
+            REQUIRE( dictionary_try_get_value(&dict, &str, &value) == true );
+            REQUIRE( value == i );
+        }
+        const char* missing = "bar";
+        REQUIRE( dictionary_contains(&dict, &missing) == false );
+        dictionary_remove(&dict, &strings[2]);
+        REQUIRE( dictionary_contains(&dict, &strings[2]) == false );
+        REQUIRE( dictionary_contains(&dict, &strings[1]) == true );
+        dictionary_free(&dict);
+    }
+
+    SECTION( "Duplicate keys keep their insertion order" ) {
+        dictionary_t dict = dictionary_create(u32, u32, 0, dictionary_key_comparer_u32);
+        for(u32 i = 0; i < 100; ++i)
+        {
+            u32 key = i % 10;
+            dictionary_push(&dict, &key, &i);
+        }
+        dictionary_freeze(&dict, u32_less_than);
+        for(u32 i = 0; i < 100; ++i)
+        {
+            REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&dict, i)) == i / 10 );
+            REQUIRE( DREF_TO(u32, dictionary_get_value_ptr_at(&dict, i)) == (i % 10) * 10 + i / 10 );
+        }
+        dictionary_free(&dict);
+    }
+}
+
+TEST_CASE( "dictionary_t emplace and push_n", "[dictionary_t]" ) {
+
+    struct pair_t { u32 key; u32 value; };
+    std::vector<pair_t> pairs;
+    for(u32 i = 0; i < 1000; ++i)
+        pairs.push_back({ 999 - i, i });
+
+    dictionary_t linear = dictionary_create(u32, u32, 0, dictionary_key_comparer_u32);
+    dictionary_t hashed = dictionary_create_hashed(u32, u32, 0, dictionary_key_comparer_u32, u32_hash);
+    dictionary_t sorted = dictionary_create_sorted(u32, u32, 0, dictionary_key_comparer_u32, u32_less_than);
+    dictionary_t* dicts[] = { &linear, &hashed, &sorted };
+    for(dictionary_t* dict : dicts)
+    {
+        dictionary_push_n(dict, pairs.data(), 500);
+        dictionary_push_n(dict, pairs.data() + 500, 500);
+        u32 key = 1000;
+        DREF_TO(u32, dictionary_emplace(dict, &key)) = 1234;
+        REQUIRE( dictionary_get_count(dict) == 1001 );
+        for(u32 i = 0; i <= 1000; ++i)
+        {
+            u32 value;
+            REQUIRE( dictionary_try_get_value(dict, &i, &value) == true );
+            REQUIRE( value == ((i == 1000) ? 1234 : 999 - i) );
+        }
+    }
+    /* insertion order vs key order */
+    REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&hashed, 0)) == 999 );
+    REQUIRE( DREF_TO(u32, dictionary_get_key_ptr_at(&sorted, 0)) == 0 );
+    for(dictionary_t* dict : dicts)
+        dictionary_free(dict);
+}
+
+TEST_CASE( "com::Dictionary", "[dictionary_t]" ) {
+
+    /* the value is more aligned than the key, so there is padding in between */
+    com::Dictionary<u16, double> dict;
+    for(u16 i = 0; i < 3000; ++i)
+        dict.add(i, i * 0.5);
+    dict.emplace(60000) = 1.25;
+    REQUIRE( dict.size() == 3001 );
+    REQUIRE( *dict.find(60000) == 1.25 );
+    for(u16 i = 0; i < 3000; ++i)
+    {
+        REQUIRE( dict.findIndex(i) == i );
+        REQUIRE( *dict.find(i) == i * 0.5 );
+        /* the inline lookup and the C API agree */
+        u16 key = i;
+        REQUIRE( dictionary_find_index_of(dict.getHandle(), &key) == i );
+    }
+    REQUIRE( dict.find(3001) == nullptr );
+    REQUIRE( dict.remove(10) );
+    REQUIRE( !dict.remove(10) );
+    REQUIRE( dict[10].key == 11 );
+    REQUIRE( dict.findIndex(11) == 10 );
+
+    com::Dictionary<u16, double>::Entry entries[] = { { 7000, 1.0 }, { 7001, 2.0 } };
+    dict.add(entries, 2);
+    REQUIRE( *dict.find(7001) == 2.0 );
+    double sum = 0;
+    for(auto& entry : dict)
+        sum += entry.value;
+    REQUIRE( sum == (2999.0 * 3000.0 / 4.0) - 5.0 + 1.25 + 3.0 );
+
+    com::Dictionary<u16, double> moved = std::move(dict);
+    REQUIRE( moved.contains(7000) );
+
+    /* frozen through the C API, so there is no index anymore, but the lookups still work and the destructor still frees it */
+    dictionary_freeze(moved.getHandle(), u16_less_than);
+    REQUIRE( moved.contains(7000) );
+    REQUIRE( moved[moved.findIndex(11)].key == 11 );
+    REQUIRE( *moved.find(60000) == 1.25 );
+    REQUIRE( moved.find(3001) == nullptr );
+    REQUIRE( moved.remove(7001) );
+    REQUIRE( !moved.contains(7001) );
+    com::Dictionary<u16, double> assigned;
+    assigned = std::move(moved);
+    REQUIRE( assigned.contains(60000) );
+}
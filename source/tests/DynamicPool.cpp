@@ -7,6 +7,7 @@
 // Standard Headers
 #include <vector>
 #include <span>
+#include <type_traits>
 
 TEST_CASE("std::span on DynamicPool<>", "[DynamicPool-stdspan]")
 {
@@ -131,3 +132,178 @@ TEST_CASE("Simple tests on DynamicPool<>", "[DynamicPool-Simple]" )
         REQUIRE(std::next(pool.getActives().begin(), 0) == pool.getActives().end());
     }
 }
+
+TEST_CASE("Handles on DynamicPool<>", "[DynamicPool-Handle]")
+{
+    int returnCount = 0;
+    com::DynamicPool<int> pool([]()
+    {
+        static int counter = 0;
+        return counter++;
+    }, nullptr, [&returnCount](int&) { ++returnCount; });
+
+    SECTION("Constant time put")
+    {
+        auto h1 = pool.getHandle();
+        auto h2 = pool.getHandle();
+        auto h3 = pool.getHandle();
+        int v1 = pool.getValue(h1);
+        int v2 = pool.getValue(h2);
+        int v3 = pool.getValue(h3);
+        REQUIRE(pool.activeCount() == 3);
+
+        // Put back in the order they were taken out, which moves the others around
+        pool.put(h1);
+        REQUIRE(pool.activeCount() == 2);
+        REQUIRE(returnCount == 1);
+        REQUIRE(!pool.isValid(h1));
+        REQUIRE(pool.isValid(h2));
+        REQUIRE(pool.getValue(h2) == v2);
+        REQUIRE(pool.getValue(h3) == v3);
+
+        pool.put(h2);
+        REQUIRE(pool.getValue(h3) == v3);
+        pool.put(h3);
+        REQUIRE(pool.activeCount() == 0);
+        REQUIRE(returnCount == 3);
+
+        // Recycled, the old handles don't refer to it
+        auto h4 = pool.getHandle();
+        REQUIRE(pool.size() == 3);
+        REQUIRE(!pool.isValid(h1));
+        REQUIRE(!pool.isValid(h2));
+        REQUIRE(!pool.isValid(h3));
+        int v4 = pool.getValue(h4);
+        REQUIRE(((v4 == v1) || (v4 == v2) || (v4 == v3)));
+    }
+
+    SECTION("Stale and double puts are ignored")
+    {
+        auto h1 = pool.getHandle();
+        auto h2 = pool.getHandle();
+        pool.put(h1);
+        // Recycles the object h1 referred to
+        auto h3 = pool.getHandle();
+        REQUIRE(h3.slot == h1.slot);
+        REQUIRE(!(h3 == h1));
+        pool.put(h1);
+        REQUIRE(pool.activeCount() == 2);
+        REQUIRE(pool.isValid(h2));
+        REQUIRE(pool.isValid(h3));
+        pool.put(h3);
+        pool.put(h3);
+        REQUIRE(pool.activeCount() == 1);
+        REQUIRE(pool.isValid(h2));
+    }
+
+    SECTION("Value based put, reclaim() and clear() invalidate the handles")
+    {
+        auto h1 = pool.getHandle();
+        auto h2 = pool.getHandle();
+        pool.put(pool.getValue(h1));
+        REQUIRE(!pool.isValid(h1));
+        REQUIRE(pool.isValid(h2));
+
+        pool.reclaim();
+        REQUIRE(!pool.isValid(h2));
+
+        auto h3 = pool.getHandle();
+        pool.clear();
+        REQUIRE(!pool.isValid(h3));
+        // The slots are handed out again, but with newer generations
+        auto h4 = pool.getHandle();
+        auto h5 = pool.getHandle();
+        auto& sameSlot = (h4.slot == h3.slot) ? h4 : h5;
+        REQUIRE(sameSlot.slot == h3.slot);
+        REQUIRE(!(sameSlot == h3));
+        REQUIRE(!pool.isValid(h3));
+        REQUIRE(pool.isValid(h4));
+        REQUIRE(pool.isValid(h5));
+    }
+}
+
+// Counts the calls to its hooks, only the pool's own copy of it is called
+struct CountingPolicy
+{
+    int createCount = 0;
+    int destroyCount = 0;
+    int returnCount = 0;
+    int recycleCount = 0;
+    std::vector<u32> slots;
+
+    int create(u32 slot)
+    {
+        slots.push_back(slot);
+        return 100 + createCount++;
+    }
+    void destroy(int&) { ++destroyCount; }
+    void onReturn(int&) { ++returnCount; }
+    void onRecycle(int&) { ++recycleCount; }
+};
+
+// Compares the spans by their sizes
+struct SizePolicy
+{
+    static std::span<u8> create() { return { }; }
+    static bool isEqual(std::span<u8>& s1, std::span<u8>& s2) { return s1.size() == s2.size(); }
+};
+
+TEST_CASE("Policies on DynamicPool<>", "[DynamicPool-Policy]")
+{
+    // The std::function policy needs a create hook, so it can't be left out
+    static_assert(!std::is_default_constructible_v<com::DynamicPool<int>>);
+    static_assert(std::is_default_constructible_v<com::DynamicPool<int, CountingPolicy>>);
+
+    SECTION("Hooks of the policy")
+    {
+        com::DynamicPool<int, CountingPolicy> pool;
+        CountingPolicy& policy = pool.getPolicy();
+        auto v1 = pool.get();
+        auto v2 = pool.get();
+        REQUIRE(v1 == 100);
+        REQUIRE(v2 == 101);
+        REQUIRE(policy.slots == std::vector<u32> { 0, 1 });
+        pool.put(v1);
+        REQUIRE(policy.returnCount == 1);
+        REQUIRE(pool.get() == v1);
+        REQUIRE(policy.recycleCount == 1);
+        REQUIRE(policy.createCount == 2);
+        pool.reserve(4);
+        REQUIRE(policy.slots == std::vector<u32> { 0, 1, 2, 3 });
+        REQUIRE(policy.returnCount == 3);
+        pool.reclaim();
+        REQUIRE(policy.returnCount == 5);
+        pool.get();
+        pool.clear();
+        REQUIRE(policy.destroyCount == 4);
+    }
+
+    SECTION("Policy with only the create hook")
+    {
+        struct CreatePolicy
+        {
+            int counter = 0;
+            int create() { return counter++; }
+        };
+        com::DynamicPool<int, CreatePolicy> pool(CreatePolicy { 10 }, true, 2);
+        REQUIRE(pool.size() == 2);
+        auto v1 = pool.get();
+        auto h2 = pool.getHandle();
+        REQUIRE(v1 == 10);
+        // Found with operator==
+        pool.put(v1);
+        REQUIRE(pool.activeCount() == 1);
+        pool.put(h2);
+        REQUIRE(pool.activeCount() == 0);
+        REQUIRE(pool.get() == 11);
+    }
+
+    SECTION("Static equality hook")
+    {
+        com::DynamicPool<std::span<u8>, SizePolicy> pool;
+        pool.get();
+        REQUIRE(pool.activeCount() == 1);
+        pool.put(std::span<u8>(static_cast<u8*>(nullptr), std::size_t(0)));
+        REQUIRE(pool.activeCount() == 0);
+    }
+}
@@ -6,6 +6,7 @@
 
 // Standard Headers
 #include <vector>
+#include <type_traits>
 
 TEST_CASE("Simple tests on DynamicPoolFast<>", "[DynamicPoolFast-Simple]" )
 {
@@ -203,4 +204,88 @@ TEST_CASE("Putfast tests", "[DynamicPoolFast-PutFast]")
         REQUIRE(std::next(pool.begin(), 10) == pool.end());
         REQUIRE(std::next(pool.getActives().begin(), 0) == pool.getActives().end());
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Put back in any order", "[DynamicPoolFast-PutOrder]")
+{
+    com::DynamicPoolFast<int> pool([]()
+    {
+        static int counter = 0;
+        return counter++;
+    });
+
+    SECTION("First in first out, as in a pipeline")
+    {
+        std::vector<com::DynamicPoolFast<int>::ElementType> v;
+        for(int round = 0; round < 3; ++round)
+        {
+            for(int i = 0; i < 4; ++i)
+                v.push_back(pool.get());
+            for(int i = 0; i < 2; ++i)
+            {
+                pool.put(v.front());
+                v.erase(v.begin());
+            }
+        }
+        REQUIRE(pool.activeCount() == 6);
+        // The recycled elements are reused, so only 8 have ever been created
+        REQUIRE(pool.size() == 8);
+        for(auto& el : v)
+            pool.put(el);
+        REQUIRE(pool.activeCount() == 0);
+        REQUIRE(pool.size() == 8);
+    }
+
+    SECTION("Values written through the copies are put back")
+    {
+        auto v1 = pool.get();
+        auto v2 = pool.get();
+        auto v3 = pool.get();
+        *v1 = 100;
+        *v3 = 300;
+        pool.put(v1);
+        pool.put(v3);
+        REQUIRE(pool.activeCount() == 1);
+        REQUIRE(*pool.getActives().begin() == v2);
+        bool isFound100 = false, isFound300 = false;
+        for(auto& el : pool)
+        {
+            isFound100 = isFound100 || (*el == 100);
+            isFound300 = isFound300 || (*el == 300);
+        }
+        REQUIRE(isFound100);
+        REQUIRE(isFound300);
+        pool.put(v2);
+        REQUIRE(pool.activeCount() == 0);
+    }
+}
+
+TEST_CASE("Policies on DynamicPoolFast<>", "[DynamicPoolFast-Policy]")
+{
+    static_assert(!std::is_default_constructible_v<com::DynamicPoolFast<int>>);
+
+    struct Policy
+    {
+        int counter = 0;
+        int returnCount = 0;
+        int create() { return counter++; }
+        void onReturn(int&) { ++returnCount; }
+    };
+
+    com::DynamicPoolFast<int, Policy> pool;
+    std::vector<com::DynamicPoolFast<int, Policy>::ElementType> v;
+    for(int i = 0; i < 4; ++i)
+        v.push_back(pool.get());
+    REQUIRE(*v[3] == 3);
+    pool.put(v[1]);
+    pool.put(v[0]);
+    REQUIRE(pool.activeCount() == 2);
+    REQUIRE(pool.getPolicy().getPolicy().returnCount == 2);
+    auto el = pool.get();
+    REQUIRE(((*el == 0) || (*el == 1)));
+    REQUIRE(pool.size() == 4);
+    pool.put(el);
+    pool.put(v[2]);
+    pool.put(v[3]);
+    REQUIRE(pool.activeCount() == 0);
+    REQUIRE(pool.getPolicy().getPolicy().returnCount == 5);
+}
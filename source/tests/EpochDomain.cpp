@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/EpochDomain.hpp>
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+struct EpochDomainObject
+{
+	std::atomic<int>* deletedCount;
+	~EpochDomainObject() { deletedCount->fetch_add(1); }
+};
+
+TEST_CASE( "EpochDomain", "[epoch-domain]" ) {
+
+	auto& domain = com::EpochDomain::global();
+	domain.synchronize();
+	std::atomic<int> deletedCount = 0;
+
+	SECTION( "Deleted right away when there is no reader" ) {
+		domain.retire(new EpochDomainObject { &deletedCount });
+		REQUIRE( deletedCount == 1 );
+		REQUIRE( domain.getRetiredCount() == 0 );
+	}
+
+	SECTION( "Kept while a reader which has entered before is in the domain" ) {
+		std::atomic<int> state = 0;
+		std::thread reader([&domain, &state]()
+		{
+			com::EpochDomain::ReadScope scope(domain);
+			/* nested scopes have no effect */
+			{
+				com::EpochDomain::ReadScope nestedScope(domain);
+			}
+			state = 1;
+			while(state != 2)
+				std::this_thread::yield();
+		});
+		while(state != 1)
+			std::this_thread::yield();
+		domain.retire(new EpochDomainObject { &deletedCount });
+		REQUIRE( deletedCount == 0 );
+		REQUIRE( domain.reclaim() == 0 );
+		REQUIRE( domain.getRetiredCount() == 1 );
+		/* this thread enters after the object has been retired, so it doesn't hold it back */
+		{
+			com::EpochDomain::ReadScope scope(domain);
+			state = 2;
+			reader.join();
+			REQUIRE( domain.reclaim() == 1 );
+		}
+		REQUIRE( deletedCount == 1 );
+	}
+
+	SECTION( "Synchronize waits for the readers" ) {
+		std::atomic<bool> isEntered = false;
+		std::atomic<bool> isExited = false;
+		std::thread reader([&]()
+		{
+			domain.enter();
+			isEntered = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			isExited = true;
+			domain.exit();
+		});
+		while(!isEntered)
+			std::this_thread::yield();
+		domain.retire(new EpochDomainObject { &deletedCount });
+		domain.synchronize();
+		REQUIRE( isExited );
+		REQUIRE( deletedCount == 1 );
+		reader.join();
+	}
+}
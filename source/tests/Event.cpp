@@ -177,6 +177,79 @@ TEST_CASE("Complex tests on Event<>", "[Event-Complex]" )
 }
 
 
+TEST_CASE("Dense storage of the handlers on Event<>", "[Event-Dense]")
+{
+    using TestEvent = com::Event<com::no_publish_ptr_t>;
+    TestEvent event;
+    std::vector<int> calls(10, 0);
+    std::vector<TestEvent::SubscriptionID> ids;
+    for(int i = 0; i < 10; ++i)
+        ids.push_back(event.subscribe([&calls, i]() noexcept { ++calls[i]; }));
+
+    SECTION("Removing handlers moves the others around, the ids still refer to the same handlers")
+    {
+        event.unsubscribe(ids[0]);
+        event.unsubscribe(ids[4]);
+        event.deactivate(ids[9]);
+        event.deactivate(ids[5]);
+        event.activate(ids[5]);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 0, 1, 1, 1, 0, 1, 1, 1, 1, 0 });
+        event.unsubscribe(ids[9]);
+        event.unsubscribe(ids[1]);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 0, 1, 2, 2, 0, 2, 2, 2, 2, 0 });
+        REQUIRE(event.size() == 6);
+    }
+
+    SECTION("Subscribing and unsubscribing from within a handler takes effect after publish() returns")
+    {
+        int lateCalls = 0;
+        TestEvent::SubscriptionID lateID = TestEvent::InvalidSubscriptionID;
+        TestEvent::SubscriptionID selfID = event.subscribe([&]() noexcept
+        {
+            if(lateID != TestEvent::InvalidSubscriptionID)
+                return;
+            lateID = event.subscribe([&lateCalls]() noexcept { ++lateCalls; });
+            // Pending subscriptions can be deactivated as well
+            event.deactivate(lateID);
+            event.unsubscribe(ids[3]);
+            event.unsubscribe(selfID);
+            REQUIRE(event.size() == 12);
+        });
+        event.publish();
+        REQUIRE(lateCalls == 0);
+        REQUIRE(calls[3] == 1);
+        REQUIRE(event.size() == 10);
+        event.publish();
+        REQUIRE(lateCalls == 0);
+        REQUIRE(calls[3] == 1);
+        event.activate(lateID);
+        event.publish();
+        REQUIRE(lateCalls == 1);
+        REQUIRE(calls[2] == 3);
+    }
+
+    SECTION("A handler publishing the same event")
+    {
+        int depth = 0;
+        event.subscribe([&]() noexcept
+        {
+            if(depth++ == 0)
+            {
+                event.unsubscribe(ids[7]);
+                event.publish();
+                // Still subscribed until the outer publish() returns
+                REQUIRE(event.size() == 11);
+            }
+        });
+        event.publish();
+        REQUIRE(event.size() == 10);
+        REQUIRE(calls[0] == 2);
+    }
+}
+
+
 class UDT
 {
 private:
@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/EventQueue.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <utility>
+
+struct EventQueuePublisher
+{
+	int id = 7;
+};
+
+/* has no default constructor */
+struct EventQueueResize
+{
+	int width;
+	int height;
+
+	EventQueueResize(int _width, int _height) : width(_width), height(_height) { }
+	bool operator==(const EventQueueResize&) const = default;
+};
+
+TEST_CASE( "EventQueue", "[event-queue]" ) {
+
+	SECTION( "Events are published by dispatch()" ) {
+		com::EventQueue<com::no_publish_ptr_t, int, const std::string&> queue;
+		std::vector<std::pair<int, std::string>> received;
+		queue.subscribe([&received](int value, const std::string& name) { received.push_back({ value, name }); });
+		std::string name = "first";
+		queue.enqueue(1, name);
+		/* the argument is copied into the queue */
+		name = "changed";
+		REQUIRE( queue.tryEnqueue(2, std::string("second")) );
+		REQUIRE( received.empty() );
+		REQUIRE( queue.depth() == 2 );
+		REQUIRE( queue.dispatch() == 2 );
+		REQUIRE( received.size() == 2 );
+		REQUIRE( received[0] == std::make_pair(1, std::string("first")) );
+		REQUIRE( received[1] == std::make_pair(2, std::string("second")) );
+		REQUIRE( queue.depth() == 0 );
+		REQUIRE( queue.dispatch() == 0 );
+	}
+
+	SECTION( "Batches and frames" ) {
+		com::EventQueue<com::no_publish_ptr_t, int> queue({ .capacity = 256, .batchSize = 3 });
+		std::vector<int> received;
+		queue.subscribe([&queue, &received](int value)
+		{
+			received.push_back(value);
+			/* enqueued while dispatching, so they are published in the next frame */
+			if(value < 0)
+				queue.enqueue(-value);
+		});
+		for(int i = 0; i < 10; ++i)
+			queue.enqueue(i);
+		queue.enqueue(-100);
+		REQUIRE( queue.dispatch() == 11 );
+		REQUIRE( received.size() == 11 );
+		REQUIRE( received.back() == -100 );
+		REQUIRE( queue.depth() == 1 );
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( received.back() == 100 );
+	}
+
+	SECTION( "Full buffer" ) {
+		com::EventQueue<com::no_publish_ptr_t, int> queue({ .capacity = 4 });
+		int sum = 0;
+		queue.subscribe([&sum](int value) { sum += value; });
+		for(int i = 0; i < 4; ++i)
+			REQUIRE( queue.tryEnqueue(1) );
+		REQUIRE( !queue.tryEnqueue(1) );
+		auto stats = queue.getStats();
+		REQUIRE( stats.enqueuedCount == 4 );
+		REQUIRE( stats.droppedCount == 1 );
+		REQUIRE( stats.depth == 4 );
+		REQUIRE( stats.maxDepth == 4 );
+		REQUIRE( queue.dispatch() == 4 );
+		REQUIRE( sum == 4 );
+		stats = queue.getStats();
+		REQUIRE( stats.dispatchedCount == 4 );
+		REQUIRE( stats.depth == 0 );
+		REQUIRE( stats.maxDepth == 4 );
+	}
+
+	SECTION( "Coalescing duplicates" ) {
+		com::EventQueue<com::no_publish_ptr_t, int, std::string> queue({ .coalescing = com::EventQueueCoalescing::Duplicates });
+		std::vector<std::pair<int, std::string>> received;
+		queue.subscribe([&received](int value, std::string name) { received.push_back({ value, std::move(name) }); });
+		queue.enqueue(1, "a");
+		queue.enqueue(2, "a");
+		queue.enqueue(1, "a");
+		queue.enqueue(1, "b");
+		queue.enqueue(2, "a");
+		REQUIRE( queue.dispatch() == 3 );
+		REQUIRE( received.size() == 3 );
+		REQUIRE( received[0] == std::make_pair(1, std::string("a")) );
+		REQUIRE( received[1] == std::make_pair(2, std::string("a")) );
+		REQUIRE( received[2] == std::make_pair(1, std::string("b")) );
+		/* coalesced per frame only */
+		queue.enqueue(1, "a");
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( received.size() == 4 );
+		auto stats = queue.getStats();
+		REQUIRE( stats.enqueuedCount == 6 );
+		REQUIRE( stats.dispatchedCount == 4 );
+		REQUIRE( stats.coalescedCount == 2 );
+	}
+
+	SECTION( "Coalescing to the latest" ) {
+		com::EventQueue<com::no_publish_ptr_t, int, int> queue({ .coalescing = com::EventQueueCoalescing::Latest });
+		std::vector<std::pair<int, int>> received;
+		queue.subscribe([&received](int width, int height) { received.push_back({ width, height }); });
+		for(int i = 1; i <= 5; ++i)
+			queue.enqueue(i * 100, i * 50);
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( received.size() == 1 );
+		REQUIRE( received[0] == std::make_pair(500, 250) );
+		REQUIRE( queue.getStats().coalescedCount == 4 );
+	}
+
+	SECTION( "Arguments without a default constructor" ) {
+		com::EventQueue<com::no_publish_ptr_t, const EventQueueResize&> queue({ .coalescing = com::EventQueueCoalescing::Latest });
+		std::vector<EventQueueResize> received;
+		queue.subscribe([&received](const EventQueueResize& resize) { received.push_back(resize); });
+		queue.enqueue(EventQueueResize { 100, 50 });
+		queue.enqueue(EventQueueResize { 200, 100 });
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( received.size() == 1 );
+		REQUIRE( received[0] == EventQueueResize { 200, 100 } );
+	}
+
+	SECTION( "Publisher" ) {
+		EventQueuePublisher publisher;
+		com::EventQueue<EventQueuePublisher, int> queue(&publisher);
+		int sum = 0;
+		auto id = queue.subscribe([&sum](EventQueuePublisher* ptr, int value) { sum += ptr->id * value; });
+		queue.enqueue(2);
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( sum == 14 );
+		queue.deactivate(id);
+		queue.enqueue(2);
+		REQUIRE( queue.dispatch() == 1 );
+		REQUIRE( sum == 14 );
+	}
+
+	SECTION( "Dispatcher thread with many publishers" ) {
+		constexpr int threadCount = 4;
+		constexpr int countPerThread = 20000;
+		com::EventQueue<com::no_publish_ptr_t, int, int> queue({ .capacity = 64, .batchSize = 16 });
+		std::vector<int> lastValues(threadCount, -1);
+		bool isOrdered = true;
+		long long sum = 0;
+		std::atomic<int> receivedCount = 0;
+		queue.subscribe([&](int thread, int value)
+		{
+			/* the events of a publisher are published in the order they have been enqueued */
+			isOrdered = isOrdered && (value == lastValues[thread] + 1);
+			lastValues[thread] = value;
+			sum += value;
+			receivedCount.fetch_add(1, std::memory_order_release);
+		});
+		queue.start();
+		REQUIRE( queue.isRunning() );
+		std::vector<std::thread> threads;
+		for(int i = 0; i < threadCount; ++i)
+			threads.emplace_back([&queue, i]()
+			{
+				for(int j = 0; j < countPerThread; ++j)
+					queue.enqueue(i, j);
+			});
+		for(auto& thread : threads)
+			thread.join();
+		while(receivedCount.load(std::memory_order_acquire) < threadCount * countPerThread)
+			std::this_thread::yield();
+		queue.stop();
+		REQUIRE( !queue.isRunning() );
+		REQUIRE( isOrdered );
+		REQUIRE( sum == static_cast<long long>(threadCount) * countPerThread * (countPerThread - 1) / 2 );
+		auto stats = queue.getStats();
+		REQUIRE( stats.enqueuedCount == threadCount * countPerThread );
+		REQUIRE( stats.dispatchedCount == threadCount * countPerThread );
+		REQUIRE( stats.depth == 0 );
+		/* each publisher may count its event while the dispatcher has taken a batch out of the buffer but not yet counted it */
+		REQUIRE( stats.maxDepth <= 64 + 16 + threadCount );
+
+		/* the dispatcher can be started again after it has been parked */
+		queue.start();
+		queue.enqueue(0, countPerThread);
+		while(receivedCount.load(std::memory_order_acquire) < threadCount * countPerThread + 1)
+			std::this_thread::yield();
+	}
+}
@@ -1,8 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <common/hash_table.h>
+#include <common/HashTable.hpp>
 #include <common/defines.hpp> // for com::size_t
 #include <algorithm> // for std::next_permutation()
 #include <numeric> // for std::iota()
+#include <vector>
+#include <string>
+#include <cstdlib> // for malloc(), realloc() and free()
+#include <cstring> // for strlen()
 
 TEST_CASE( "Hash Table", "[hash_table]" ) {
     SECTION("Create and Destroy with zero capacity")
@@ -83,4 +88,441 @@ TEST_CASE( "Hash Table", "[hash_table]" ) {
         }
     }
     hash_table_free(&table);
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Flat Hash Table", "[hash_table_flat]" ) {
+    SECTION("Create and Destroy with zero capacity")
+    {
+        hash_table_t table = hash_table_create_flat(s32, float, 0, s32_equal_to, s32_hash, NULL);
+        REQUIRE(hash_table_get_count(&table) == 0);
+        REQUIRE(hash_table_get_bucket_count(&table) >= 1);
+        hash_table_free(&table);
+    }
+    SECTION("Values are naturally aligned")
+    {
+        hash_table_t table = hash_table_create_flat(u8, u64, 0, u8_equal_to, u8_hash, NULL);
+        for(u8 i = 0; i < 100; ++i)
+        {
+            u64 value = i * 3;
+            void* ptr = hash_table_add_get(&table, &i, &value);
+            REQUIRE((reinterpret_cast<uintptr_t>(ptr) % alignof(u64)) == 0);
+        }
+        hash_table_free(&table);
+    }
+    hash_table_t table = hash_table_create_flat(u64, u32, 0, u64_equal_to, u64_hash, NULL);
+    SECTION("Add, Get and Remove")
+    {
+        u64 key = 34;
+        u32 value = 23;
+        hash_table_add(&table, &key, &value);
+        REQUIRE(hash_table_get_count(&table) == 1);
+        REQUIRE(DREF_TO(u32, hash_table_get_value(&table, &key)) == 23);
+        // Adding the same key twice must fail
+        REQUIRE(hash_table_add_get(&table, &key, &value) == nullptr);
+        REQUIRE(hash_table_get_count(&table) == 1);
+        REQUIRE(hash_table_remove(&table, &key) == true);
+        REQUIRE(hash_table_remove(&table, &key) == false);
+        REQUIRE(hash_table_get_count(&table) == 0);
+        REQUIRE(hash_table_get_value(&table, &key) == nullptr);
+    }
+    SECTION("Grow, Remove and Re-add")
+    {
+        constexpr u64 count = 10000;
+        for(u64 i = 0; i < count; ++i)
+        {
+            u32 value = static_cast<u32>(i * 7);
+            REQUIRE(hash_table_add_get(&table, &i, &value) != nullptr);
+        }
+        REQUIRE(hash_table_get_count(&table) == count);
+        // Remove the even keys, this leaves tombstones in the slab
+        for(u64 i = 0; i < count; i += 2)
+            REQUIRE(hash_table_remove(&table, &i) == true);
+        REQUIRE(hash_table_get_count(&table) == (count / 2));
+        for(u64 i = 0; i < count; ++i)
+        {
+            void* value = hash_table_get_value(&table, &i);
+            if(i % 2)
+                REQUIRE(DREF_TO(u32, value) == static_cast<u32>(i * 7));
+            else
+                REQUIRE(value == nullptr);
+        }
+        // Reuse the deleted slots
+        COM_REPEAT(3)
+        {
+            for(u64 i = 0; i < count; i += 2)
+            {
+                u32 value = static_cast<u32>(i);
+                REQUIRE(hash_table_add_get(&table, &i, &value) != nullptr);
+            }
+            for(u64 i = 0; i < count; i += 2)
+                REQUIRE(hash_table_remove(&table, &i) == true);
+        }
+        u64 sum = 0;
+        hash_table_foreach(&table, [](void* key, void* value, void* user_data)
+        {
+            REQUIRE(DREF_TO(u32, value) == static_cast<u32>(DREF_TO(u64, key) * 7));
+            DREF_TO(u64, user_data) += 1;
+        }, &sum);
+        REQUIRE(sum == (count / 2));
+        hash_table_clear(&table);
+        REQUIRE(hash_table_get_count(&table) == 0);
+        for(u64 i = 0; i < count; ++i)
+            REQUIRE(hash_table_contains(&table, &i) == false);
+    }
+    hash_table_free(&table);
+}
+
+struct HashTableAllocationCounts
+{
+    u32 allocateCount = 0;
+    u32 deallocateCount = 0;
+};
+
+TEST_CASE( "Hash Table Allocation Callbacks", "[hash_table_callbacks]" ) {
+    HashTableAllocationCounts counts;
+    com_allocation_callbacks_t callbacks =
+    {
+        .user_data = &counts,
+        .allocate = [](void* user_data, u32 size, u32) -> void* { static_cast<HashTableAllocationCounts*>(user_data)->allocateCount++; return malloc(size); },
+        .reallocate = [](void* user_data, void* old_ptr, u32 size, u32) -> void*
+        {
+            /* realloc(NULL) is an allocation */
+            if(old_ptr == NULL)
+                static_cast<HashTableAllocationCounts*>(user_data)->allocateCount++;
+            return realloc(old_ptr, size);
+        },
+        .deallocate = [](void* user_data, void* ptr) { if(ptr != NULL) static_cast<HashTableAllocationCounts*>(user_data)->deallocateCount++; free(ptr); }
+    };
+    hash_table_t table = hash_table_create(u64, u32, 0, 4, u64_equal_to, u64_hash, &callbacks);
+    /* the bucket list, no key value pair yet */
+    REQUIRE(counts.allocateCount > 0);
+    u32 bucketListAllocateCount = counts.allocateCount;
+    /* grows the bucket list a few times */
+    for(u64 i = 0; i < 100; ++i)
+    {
+        u32 value = 0;
+        hash_table_add(&table, &i, &value);
+    }
+    REQUIRE(hash_table_get_bucket_count(&table) > 4);
+    /* a key value pair each, and the bigger bucket lists */
+    REQUIRE(counts.allocateCount > (100 + bucketListAllocateCount));
+    hash_table_free(&table);
+    REQUIRE(counts.allocateCount == counts.deallocateCount);
+}
+
+TEST_CASE( "Hash Table Automatic Growth", "[hash_table_growth]" ) {
+    hash_table_t table = hash_table_create(u64, u32, 0, 3, u64_equal_to, u64_hash, NULL);
+    REQUIRE(hash_table_get_max_load_factor(&table) == HASH_TABLE_DEFAULT_MAX_LOAD_FACTOR);
+    SECTION("Bucket count grows with the number of key value pairs")
+    {
+        constexpr u64 count = 5000;
+        std::vector<u32*> valuePtrs;
+        for(u64 i = 0; i < count; ++i)
+        {
+            u32 value = static_cast<u32>(i + 1);
+            valuePtrs.push_back(static_cast<u32*>(hash_table_add_get(&table, &i, &value)));
+            REQUIRE(valuePtrs.back() != nullptr);
+            REQUIRE(hash_table_get_count(&table) == (i + 1));
+            // Every key must be reachable even while the buckets are being migrated
+            for(u64 j = (i > 8) ? (i - 8) : 0; j <= i; ++j)
+                REQUIRE(hash_table_contains(&table, &j) == true);
+        }
+        REQUIRE(hash_table_get_bucket_count(&table) >= (count / 2));
+        // Power of 2 after the first growth
+        REQUIRE((hash_table_get_bucket_count(&table) & (hash_table_get_bucket_count(&table) - 1)) == 0);
+        for(u64 i = 0; i < count; ++i)
+        {
+            // Values don't move while rehashing
+            REQUIRE(hash_table_get_value(&table, &i) == valuePtrs[i]);
+            REQUIRE(DREF_TO(u32, valuePtrs[i]) == static_cast<u32>(i + 1));
+        }
+        for(u64 i = 0; i < count; i += 3)
+            REQUIRE(hash_table_remove(&table, &i) == true);
+        for(u64 i = 0; i < count; ++i)
+            REQUIRE(hash_table_contains(&table, &i) == ((i % 3) != 0));
+        hash_table_clear(&table);
+        REQUIRE(hash_table_get_count(&table) == 0);
+        REQUIRE(hash_table_is_rehashing(&table) == false);
+    }
+    SECTION("Zero max load factor disables the growth")
+    {
+        hash_table_set_max_load_factor(&table, 0);
+        for(u64 i = 0; i < 100; ++i)
+        {
+            u32 value = 0;
+            hash_table_add(&table, &i, &value);
+        }
+        REQUIRE(hash_table_get_bucket_count(&table) == 3);
+        REQUIRE(hash_table_get_count(&table) == 100);
+    }
+    hash_table_free(&table);
+}
+
+TEST_CASE( "Hash Table Stats", "[hash_table_stats]" ) {
+    SECTION("Chained")
+    {
+        hash_table_t table = hash_table_create(u64, u32, 0, 4, u64_equal_to, u64_hash, NULL);
+        hash_table_set_max_load_factor(&table, 0);
+        hash_table_stats_t stats;
+        hash_table_get_stats(&table, &stats);
+        REQUIRE(stats.count == 0);
+        REQUIRE(stats.bucket_count == 4);
+        REQUIRE(stats.empty_bucket_count == 4);
+        REQUIRE(stats.max_chain_length == 0);
+        for(u64 i = 0; i < 10; ++i)
+        {
+            u32 value = 0;
+            hash_table_add(&table, &i, &value);
+        }
+        hash_table_get_stats(&table, &stats);
+        REQUIRE(stats.count == 10);
+        REQUIRE(stats.bucket_count == 4);
+        REQUIRE(stats.empty_bucket_count < 4);
+        REQUIRE(stats.max_chain_length >= 3);
+        REQUIRE(stats.tombstone_count == 0);
+        REQUIRE(stats.load_factor == 2.5f);
+        hash_table_free(&table);
+    }
+    SECTION("Chained while rehashing")
+    {
+        hash_table_t table = hash_table_create(u64, u32, 0, 1, u64_equal_to, u64_hash, NULL);
+        for(u64 i = 0; i < 1000; ++i)
+        {
+            u32 value = 0;
+            hash_table_add(&table, &i, &value);
+            hash_table_stats_t stats;
+            hash_table_get_stats(&table, &stats);
+            REQUIRE(stats.count == (i + 1));
+            REQUIRE(stats.bucket_count >= hash_table_get_bucket_count(&table));
+        }
+        hash_table_free(&table);
+    }
+    SECTION("Flat")
+    {
+        hash_table_t table = hash_table_create_flat(u64, u32, 16, u64_equal_to, u64_hash, NULL);
+        for(u64 i = 0; i < 16; ++i)
+        {
+            u32 value = 0;
+            hash_table_add(&table, &i, &value);
+        }
+        for(u64 i = 0; i < 16; i += 2)
+            hash_table_remove(&table, &i);
+        hash_table_stats_t stats;
+        hash_table_get_stats(&table, &stats);
+        REQUIRE(stats.count == 8);
+        REQUIRE(stats.bucket_count == hash_table_get_bucket_count(&table));
+        REQUIRE(stats.empty_bucket_count + stats.tombstone_count + stats.count == stats.bucket_count);
+        REQUIRE(stats.max_chain_length >= 1);
+        REQUIRE(stats.max_chain_length < stats.bucket_count);
+        hash_table_free(&table);
+    }
+}
+
+TEST_CASE( "Hash Functions", "[hash_function]" ) {
+    SECTION("Anagrams don't collide")
+    {
+        const char* str1 = "listen";
+        const char* str2 = "silent";
+        REQUIRE(string_hash(&str1) != string_hash(&str2));
+    }
+    SECTION("Long strings are hashed entirely")
+    {
+        std::string str1(100000, 'a');
+        std::string str2 = str1;
+        str2.back() = 'b';
+        const char* ptr1 = str1.c_str();
+        const char* ptr2 = str2.c_str();
+        REQUIRE(large_string_hash(&ptr1) != large_string_hash(&ptr2));
+        REQUIRE(string_hash(&ptr1) == bytes_hash(ptr1, str1.size(), HASH_FUNCTION_DEFAULT_SEED));
+    }
+    SECTION("Every length and the seed affect the hash")
+    {
+        // Long enough to go through the multi-lane path as well
+        std::vector<u8> bytes(200000);
+        for(com::size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = static_cast<u8>(i * 31);
+        std::vector<com::size_t> sizes(1025);
+        std::iota(sizes.begin(), sizes.end(), 0);
+        for(com::size_t size : { 2048, 2049, 4095, 65536, 65537, 100000, 131136, 200000 })
+            sizes.push_back(size);
+        std::vector<hash_t> hashes;
+        for(com::size_t size : sizes)
+        {
+            hashes.push_back(bytes_hash(bytes.data(), size, 0));
+            REQUIRE(bytes_hash(bytes.data(), size, 0) != bytes_hash(bytes.data(), size, 1));
+        }
+        std::sort(hashes.begin(), hashes.end());
+        REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+    SECTION("All the long input paths give the same hash values")
+    {
+        std::vector<u8> bytes(100000);
+        for(com::size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = static_cast<u8>((i * 2654435761ULL) >> 13);
+        REQUIRE(bytes_hash_long_path_is_available(HASH_FUNCTION_LONG_PATH_SCALAR));
+        for(hash_function_long_path_t path : { HASH_FUNCTION_LONG_PATH_SSE2, HASH_FUNCTION_LONG_PATH_AVX2 })
+        {
+            if(!bytes_hash_long_path_is_available(path))
+                continue;
+            // Partial blocks and stripes, and several blocks
+            for(com::size_t size : { 64, 65, 127, 128, 1023, 1024, 1025, 2049, 4103, 65537, 100000 })
+            for(hash_t seed : { 0ULL, 1ULL, 0x9E3779B97F4A7C15ULL })
+                REQUIRE(bytes_hash_long_with_path(bytes.data(), size, seed, path) == bytes_hash_long_with_path(bytes.data(), size, seed, HASH_FUNCTION_LONG_PATH_SCALAR));
+        }
+        // bytes_hash() takes the long input path beyond the threshold (65536 at most)
+        REQUIRE(bytes_hash(bytes.data(), bytes.size(), 7) == bytes_hash_long_with_path(bytes.data(), bytes.size(), 7, HASH_FUNCTION_LONG_PATH_SCALAR));
+    }
+    SECTION("Seeded string hash")
+    {
+        std::string str1(100, 'x');
+        const char* ptrs[] = { "listen", str1.c_str() };
+        for(const char* ptr : ptrs)
+        {
+            REQUIRE(string_hash_seeded(&ptr, HASH_FUNCTION_DEFAULT_SEED) == string_hash(&ptr));
+            REQUIRE(string_hash_seeded(&ptr, 42) == bytes_hash(ptr, strlen(ptr), 42));
+        }
+        REQUIRE(hash_function_get_seeded(string_hash) == string_hash_seeded);
+        REQUIRE(hash_function_get_seeded(large_string_hash) == string_hash_seeded);
+        REQUIRE(hash_function_get_seeded(u64_hash) == nullptr);
+    }
+    SECTION("Sequential integers are spread over the low bits")
+    {
+        constexpr u32 bucketCount = 64;
+        std::vector<u32> buckets(bucketCount, 0);
+        for(u32 i = 0; i < bucketCount * 64; i += 16)
+            buckets[u32_hash(&i) & (bucketCount - 1)]++;
+        REQUIRE(*std::max_element(buckets.begin(), buckets.end()) < 16);
+    }
+    SECTION("Seeded Hash Table")
+    {
+        hash_table_t table = hash_table_create(u64, u32, 0, 8, u64_equal_to, u64_hash, NULL);
+        hash_table_set_seed(&table, 0x9E3779B97F4A7C15ULL);
+        REQUIRE(hash_table_get_seed(&table) == 0x9E3779B97F4A7C15ULL);
+        for(u64 i = 0; i < 1000; ++i)
+        {
+            u32 value = static_cast<u32>(i);
+            hash_table_add(&table, &i, &value);
+        }
+        for(u64 i = 0; i < 1000; ++i)
+            REQUIRE(DREF_TO(u32, hash_table_get_value(&table, &i)) == static_cast<u32>(i));
+        hash_table_free(&table);
+    }
+    SECTION("Seeded Hash Table with string keys")
+    {
+        // The seed goes into the string hash itself, so the keys colliding without the seed are spread with it
+        hash_table_t table = hash_table_create(const char*, u32, 0, 8, string_equal_to, string_hash, NULL);
+        hash_table_set_seed(&table, 0x9E3779B97F4A7C15ULL);
+        REQUIRE(table.get_seeded_hash == string_hash_seeded);
+        std::vector<std::string> keys;
+        for(u32 i = 0; i < 500; ++i)
+            keys.push_back("key" + std::to_string(i));
+        for(u32 i = 0; i < 500; ++i)
+        {
+            const char* key = keys[i].c_str();
+            hash_table_add(&table, &key, &i);
+        }
+        for(u32 i = 0; i < 500; ++i)
+        {
+            // A different pointer to an equal string
+            std::string copy = keys[i];
+            const char* key = copy.c_str();
+            REQUIRE(DREF_TO(u32, hash_table_get_value(&table, &key)) == i);
+        }
+        hash_table_free(&table);
+    }
+}
+
+TEST_CASE( "Hash Table Batch Lookup", "[hash_table_batch]" ) {
+    auto checkBatch = [](hash_table_t& table, u64 addedCount)
+    {
+        // Every third key is missing, and the count isn't a multiple of the batching window
+        std::vector<u64> keys;
+        for(u64 i = 0; i < (addedCount + addedCount / 2); i += 1)
+            keys.push_back(((i % 3) == 2) ? (addedCount + i) : (i % addedCount));
+        std::vector<void*> values(keys.size(), reinterpret_cast<void*>(1));
+        u32 foundCount = hash_table_get_values_batch(&table, keys.data(), static_cast<u32>(keys.size()), values.data());
+        u32 expectedCount = 0;
+        for(com::size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(values[i] == hash_table_get_value(&table, &keys[i]));
+            expectedCount += (values[i] != nullptr) ? 1 : 0;
+        }
+        REQUIRE(foundCount == expectedCount);
+        REQUIRE(hash_table_get_values_batch(&table, keys.data(), 0, values.data()) == 0);
+    };
+    SECTION("Chained")
+    {
+        hash_table_t table = hash_table_create(u64, u32, 0, 1, u64_equal_to, u64_hash, NULL);
+        for(u64 i = 0; i < 1000; ++i)
+        {
+            u32 value = static_cast<u32>(i);
+            hash_table_add(&table, &i, &value);
+            // Including while the buckets are being migrated
+            if((i % 97) == 0)
+                checkBatch(table, i + 1);
+        }
+        checkBatch(table, 1000);
+        hash_table_free(&table);
+    }
+    SECTION("Flat")
+    {
+        hash_table_t table = hash_table_create_flat(u64, u32, 0, u64_equal_to, u64_hash, NULL);
+        for(u64 i = 0; i < 1000; ++i)
+        {
+            u32 value = static_cast<u32>(i);
+            hash_table_add(&table, &i, &value);
+        }
+        checkBatch(table, 1000);
+        hash_table_free(&table);
+    }
+}
+
+TEST_CASE( "com::HashTable", "[hash_table_cpp]" ) {
+    struct Point { s32 x; s32 y; };
+    com::HashTable<u32, Point> table;
+    REQUIRE(table.empty());
+    for(u32 i = 0; i < 5000; i++)
+        REQUIRE(table.add(i * 3, { static_cast<s32>(i), -static_cast<s32>(i) }) != nullptr);
+    /* duplicates are rejected */
+    REQUIRE(table.add(3, { 0, 0 }) == nullptr);
+    REQUIRE(table.size() == 5000);
+    for(u32 i = 0; i < 15000; i++)
+    {
+        Point* point = table.find(i);
+        REQUIRE(table.contains(i) == ((i % 3) == 0));
+        if((i % 3) != 0)
+        {
+            REQUIRE(point == nullptr);
+            continue;
+        }
+        REQUIRE(point != nullptr);
+        REQUIRE(point->x == static_cast<s32>(i / 3));
+        /* the inline lookup and the C API agree */
+        REQUIRE(hash_table_get_value(table.getHandle(), &i) == point);
+    }
+    for(u32 i = 0; i < 5000; i += 2)
+        REQUIRE(table.remove(i * 3));
+    REQUIRE(!table.remove(1));
+    u32 visited = 0;
+    for(auto [key, value] : table)
+    {
+        REQUIRE((key % 6) == 3);
+        REQUIRE(value.y == -static_cast<s32>(key / 3));
+        visited++;
+    }
+    REQUIRE(visited == table.size());
+
+    SECTION("Seeded and moved")
+    {
+        com::HashTable<const void*, int> ptrs;
+        ptrs.setSeed(0x1234);
+        int values[64];
+        for(int i = 0; i < 64; i++)
+            ptrs.add(&values[i], i);
+        com::HashTable<const void*, int> moved = std::move(ptrs);
+        REQUIRE(moved.size() == 64);
+        for(int i = 0; i < 64; i++)
+            REQUIRE(*moved.find(&values[i]) == i);
+        REQUIRE(moved.find(nullptr) == nullptr);
+    }
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/MPMCRingBuffer.hpp>
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+
+TEST_CASE( "MPMCRingBuffer", "[mpmc-ring-buffer]" ) {
+
+	SECTION( "Single thread" ) {
+		com::MPMCRingBuffer<int> buffer(5);
+		REQUIRE( buffer.capacity() == 8 );
+		REQUIRE( buffer.isEmpty() );
+		for(int i = 0; i < 8; ++i)
+			REQUIRE( buffer.tryPush(i) );
+		REQUIRE( !buffer.tryPush(8) );
+		int value = -1;
+		for(int i = 0; i < 8; ++i)
+		{
+			REQUIRE( buffer.tryPop(value) );
+			REQUIRE( value == i );
+		}
+		REQUIRE( !buffer.tryPop(value) );
+		REQUIRE( buffer.isEmpty() );
+		REQUIRE( buffer.tryPush(42) );
+		REQUIRE( buffer.tryConsume([&value](int&& element) { value = element; }) );
+		REQUIRE( value == 42 );
+		REQUIRE( !buffer.tryConsume([](int&&) { }) );
+		/* wraps around */
+		for(int i = 0; i < 100; ++i)
+		{
+			buffer.push(i);
+			REQUIRE( buffer.pop() == i );
+		}
+	}
+
+	SECTION( "Non-trivial elements are destroyed" ) {
+		auto shared = std::make_shared<int>(1);
+		{
+			com::MPMCRingBuffer<std::shared_ptr<int>> buffer(4);
+			buffer.push(shared);
+			buffer.push(shared);
+			buffer.push(shared);
+			REQUIRE( shared.use_count() == 4 );
+			auto popped = buffer.pop();
+			REQUIRE( shared.use_count() == 4 );
+		}
+		REQUIRE( shared.use_count() == 1 );
+	}
+
+	SECTION( "Multiple producers and consumers" ) {
+		constexpr int producerCount = 4;
+		constexpr int consumerCount = 4;
+		constexpr int countPerProducer = 20000;
+		/* small capacity, so that both the producers and the consumers get parked */
+		com::MPMCRingBuffer<int> buffer(16);
+		std::atomic<long long> sum = 0;
+		std::vector<std::thread> threads;
+		for(int p = 0; p < producerCount; ++p)
+			threads.emplace_back([&buffer, p]()
+			{
+				for(int i = 0; i < countPerProducer; ++i)
+					buffer.push(p * countPerProducer + i);
+			});
+		for(int c = 0; c < consumerCount; ++c)
+			threads.emplace_back([&buffer, &sum]()
+			{
+				long long localSum = 0;
+				for(int i = 0; i < (producerCount * countPerProducer / consumerCount); ++i)
+					localSum += buffer.pop();
+				sum += localSum;
+			});
+		for(auto& thread : threads)
+			thread.join();
+		long long n = producerCount * countPerProducer;
+		REQUIRE( sum == n * (n - 1) / 2 );
+		REQUIRE( buffer.isEmpty() );
+	}
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include <common/multi_buffer.h>
+#include <vector>
 
 static void run_test(u32 capacity, u32 sub_capacity)
 {
@@ -98,3 +99,172 @@ TEST_CASE( "Multi Buffer", "[multi_buffer_test]" )
 	run_test(1, 4);
 	run_test(4, 5);
 }
+
+TEST_CASE( "Multi Buffer Growth", "[multi_buffer_growth]" )
+{
+	multi_buffer_t mbuf;
+	multi_buffer_create(sizeof(int), 0, &mbuf);
+
+	constexpr u32 sub_buffer_count = 64;
+	constexpr u32 push_count = 40;
+	sub_buffer_handle_t handles[sub_buffer_count];
+	for(u32 i = 0; i < sub_buffer_count; ++i)
+		handles[i] = multi_buffer_sub_buffer_create(&mbuf, i % 3);
+
+	/* interleaved pushes, so that almost every sub buffer has to move to grow */
+	for(u32 j = 0; j < push_count; ++j)
+		for(u32 i = 0; i < sub_buffer_count; ++i)
+		{
+			int value = static_cast<int>(i * push_count + j);
+			multi_buffer_sub_buffer_push(&mbuf, handles[i], &value);
+		}
+
+	for(u32 i = 0; i < sub_buffer_count; ++i)
+	{
+		REQUIRE(multi_buffer_sub_buffer_get_count(&mbuf, handles[i]) == push_count);
+		for(u32 j = 0; j < push_count; ++j)
+			REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handles[i], j)) == static_cast<int>(i * push_count + j));
+	}
+	REQUIRE(multi_buffer_get_combined_sub_buffers_count(&mbuf) == (sub_buffer_count * push_count));
+	/* the holes left behind are reused, so the master buffer stays within a small factor of the capacity of the sub buffers */
+	REQUIRE(multi_buffer_get_count(&mbuf) <= (4 * sub_buffer_count * push_count));
+
+	/* the contents are copied in the order of the handles, regardless of where the sub buffers are in the master buffer */
+	std::vector<int> flat(sub_buffer_count * push_count);
+	multi_buffer_flatcopy_to(&mbuf, flat.data());
+	for(u32 i = 0; i < flat.size(); ++i)
+		REQUIRE(flat[i] == static_cast<int>(i));
+
+	/* a recreated sub buffer with a larger capacity than it had */
+	multi_buffer_sub_buffer_destroy(&mbuf, handles[0]);
+	sub_buffer_handle_t handle = multi_buffer_sub_buffer_create(&mbuf, 1000);
+	REQUIRE(multi_buffer_sub_buffer_get_capacity(&mbuf, handle) >= 1000);
+	for(int value = 0; value < 1000; ++value)
+		multi_buffer_sub_buffer_push(&mbuf, handle, &value);
+	for(u32 i = 1; i < sub_buffer_count; ++i)
+		REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handles[i], push_count - 1)) == static_cast<int>(i * push_count + push_count - 1));
+	for(int value = 0; value < 1000; ++value)
+		REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handle, value)) == value);
+
+	multi_buffer_clear(&mbuf);
+	REQUIRE(multi_buffer_get_count(&mbuf) == 0);
+	handle = multi_buffer_sub_buffer_create(&mbuf, 2);
+	int value = 7;
+	multi_buffer_sub_buffer_push(&mbuf, handle, &value);
+	REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handle, 0)) == 7);
+
+	multi_buffer_free(&mbuf);
+}
+
+static void fill_for_compaction(multi_buffer_t* mbuf, std::vector<sub_buffer_handle_t>& handles)
+{
+	/* interleaved pushes leave holes behind, and every third sub buffer is destroyed */
+	for(u32 i = 0; i < 50; ++i)
+		handles.push_back(multi_buffer_sub_buffer_create(mbuf, 0));
+	for(int j = 0; j < 20; ++j)
+		for(u32 i = 0; i < handles.size(); ++i)
+			if((j < 10) || ((i % 2) == 0))
+			{
+				int value = static_cast<int>(i * 100) + j;
+				multi_buffer_sub_buffer_push(mbuf, handles[i], &value);
+			}
+	for(u32 i = 0; i < handles.size(); i += 3)
+		multi_buffer_sub_buffer_destroy(mbuf, handles[i]);
+}
+
+static void check_after_compaction(multi_buffer_t* mbuf, std::vector<sub_buffer_handle_t>& handles)
+{
+	for(u32 i = 0; i < handles.size(); ++i)
+	{
+		if((i % 3) == 0)
+			continue;
+		u32 count = ((i % 2) == 0) ? 20 : 10;
+		REQUIRE(multi_buffer_sub_buffer_get_count(mbuf, handles[i]) == count);
+		for(u32 j = 0; j < count; ++j)
+			REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(mbuf, handles[i], j)) == static_cast<int>(i * 100 + j));
+	}
+	/* still usable */
+	sub_buffer_handle_t handle = multi_buffer_sub_buffer_create(mbuf, 4);
+	for(int value = 0; value < 100; ++value)
+		multi_buffer_sub_buffer_push(mbuf, handle, &value);
+	REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(mbuf, handle, 99)) == 99);
+	REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(mbuf, handles[1], 9)) == 109);
+}
+
+TEST_CASE( "Multi Buffer Compaction", "[multi_buffer_compact]" )
+{
+	multi_buffer_t mbuf;
+	multi_buffer_create(sizeof(int), 0, &mbuf);
+	std::vector<sub_buffer_handle_t> handles;
+	fill_for_compaction(&mbuf, handles);
+
+	SECTION("Full")
+	{
+		buf_ucount_t old_count = multi_buffer_get_count(&mbuf);
+		buf_ucount_t reclaimed = multi_buffer_compact(&mbuf, MULTI_BUFFER_TRIM_EXACT);
+		/* no holes and no slack capacity left */
+		REQUIRE(multi_buffer_get_count(&mbuf) == multi_buffer_get_combined_sub_buffers_count(&mbuf));
+		REQUIRE(reclaimed == (old_count - multi_buffer_get_count(&mbuf)) * sizeof(int));
+		REQUIRE(reclaimed > 0);
+		REQUIRE(multi_buffer_compact(&mbuf, MULTI_BUFFER_TRIM_EXACT) == 0);
+		check_after_compaction(&mbuf, handles);
+	}
+	SECTION("Power of two trimming")
+	{
+		multi_buffer_compact(&mbuf, MULTI_BUFFER_TRIM_POWER_OF_TWO);
+		REQUIRE(multi_buffer_sub_buffer_get_capacity(&mbuf, handles[1]) == 16);
+		REQUIRE(multi_buffer_sub_buffer_get_capacity(&mbuf, handles[2]) == 32);
+		check_after_compaction(&mbuf, handles);
+	}
+	SECTION("Incremental")
+	{
+		buf_ucount_t old_count = multi_buffer_get_count(&mbuf);
+		buf_ucount_t reclaimed = 0;
+		bool is_complete = false;
+		u32 call_count = 0;
+		while(!is_complete)
+		{
+			/* zero budget still moves one sub buffer each call */
+			reclaimed += multi_buffer_compact_incremental(&mbuf, MULTI_BUFFER_TRIM_NONE, 0, &is_complete);
+			REQUIRE(++call_count <= handles.size());
+			/* modifications in between the calls are allowed */
+			int value = 119;
+			if(call_count == 3)
+				multi_buffer_sub_buffer_push(&mbuf, handles[1], &value);
+		}
+		REQUIRE(reclaimed == (old_count - multi_buffer_get_count(&mbuf)) * sizeof(int));
+		REQUIRE(multi_buffer_sub_buffer_get_count(&mbuf, handles[1]) == 11);
+		REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handles[1], 10)) == 119);
+		for(u32 j = 0; j < 20; ++j)
+			REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handles[2], j)) == static_cast<int>(200 + j));
+	}
+	SECTION("Incremental resumes where it has stopped")
+	{
+		bool is_complete = false;
+		multi_buffer_compact_incremental(&mbuf, MULTI_BUFFER_TRIM_EXACT, 0, &is_complete);
+		REQUIRE(!is_complete);
+		REQUIRE(mbuf.is_compacting);
+		buf_ucount_t index = mbuf.compaction_index;
+		/* the sorted regions are kept, and the next call goes on from there */
+		multi_buffer_compact_incremental(&mbuf, MULTI_BUFFER_TRIM_EXACT, 0, &is_complete);
+		REQUIRE(mbuf.compaction_index > index);
+		/* the holes left are still usable while compacting */
+		REQUIRE((multi_buffer_get_combined_sub_buffers_count(&mbuf) + mbuf.hole_capacity) <= multi_buffer_get_count(&mbuf));
+		/* a new sub buffer changes the layout, so the next call starts over */
+		sub_buffer_handle_t handle = multi_buffer_sub_buffer_create(&mbuf, 8);
+		REQUIRE(!mbuf.is_compacting);
+		int value = 7;
+		multi_buffer_sub_buffer_push(&mbuf, handle, &value);
+		u32 call_count = 0;
+		while(!is_complete)
+		{
+			multi_buffer_compact_incremental(&mbuf, MULTI_BUFFER_TRIM_EXACT, 0, &is_complete);
+			REQUIRE(++call_count <= handles.size() + 1);
+		}
+		REQUIRE(!mbuf.is_compacting);
+		REQUIRE(multi_buffer_get_count(&mbuf) == multi_buffer_get_combined_sub_buffers_count(&mbuf));
+		REQUIRE(DREF_TO(int, multi_buffer_sub_buffer_get_ptr_at(&mbuf, handle, 0)) == 7);
+		check_after_compaction(&mbuf, handles);
+	}
+	multi_buffer_free(&mbuf);
+}
@@ -183,4 +183,85 @@ TEST_CASE("Complex tests on OrderedEvent<>", "[OrderedEvent-Complex]" )
             REQUIRE(orderCheck2.size() == 0);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Ordering of the subscriptions on OrderedEvent<>", "[OrderedEvent-Flat]")
+{
+    using TestEvent = com::OrderedEvent<com::no_publish_ptr_t, int>;
+    TestEvent event;
+    std::vector<int> calls;
+    auto subscribe = [&event, &calls](int name, int key, bool isStop = false)
+    {
+        return event.subscribe([name, isStop, &calls]() noexcept { calls.push_back(name); return isStop; }, key);
+    };
+
+    SECTION("Equal keys are invoked in the order of subscription, a re-keyed subscription goes after the others with the new key")
+    {
+        auto id1 = subscribe(1, 10);
+        subscribe(2, 5);
+        subscribe(3, 10);
+        auto id4 = subscribe(4, 5);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 2, 4, 1, 3 });
+
+        calls.clear();
+        event.updateKey(id4, 10);
+        event.updateKey(id1, 1);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 1, 2, 3, 4 });
+
+        calls.clear();
+        event.unsubscribe(id4);
+        subscribe(5, 7);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 1, 2, 5, 3 });
+        REQUIRE(event.size() == 4);
+    }
+
+    SECTION("Requests made while publishing are applied after publish() returns")
+    {
+        TestEvent::SubscriptionID id1 = TestEvent::InvalidSubscriptionID;
+        TestEvent::SubscriptionID id3 = TestEvent::InvalidSubscriptionID;
+        id1 = event.subscribe([&]() noexcept
+        {
+            calls.push_back(1);
+            if(calls.size() == 1)
+            {
+                // Invoked from the next publish() on
+                auto id = subscribe(4, 0);
+                event.tempDeactivate(id);
+                event.updateKey(id1, 5);
+                event.unsubscribe(id3);
+                REQUIRE(event.size() == 4);
+            }
+            return false;
+        }, 1);
+        subscribe(2, 2);
+        id3 = subscribe(3, 3);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 1, 2, 3 });
+        REQUIRE(event.size() == 3);
+
+        calls.clear();
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 2, 1 });
+        calls.clear();
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 4, 2, 1 });
+    }
+
+    SECTION("A stopping handler lets the rest of the handlers with its key run")
+    {
+        subscribe(1, 1);
+        subscribe(2, 2, true);
+        auto id3 = subscribe(3, 2);
+        subscribe(4, 2);
+        subscribe(5, 3);
+        event.tempDeactivate(id3);
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 1, 2, 4 });
+        calls.clear();
+        event.publish();
+        REQUIRE(calls == std::vector<int> { 1, 2, 3, 4 });
+    }
+}
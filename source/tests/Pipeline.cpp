@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/Pipeline.hpp>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+TEST_CASE( "Pipeline", "[pipeline]" ) {
+
+	constexpr int count = 10000;
+
+	SECTION( "Ordered output with parallel stages" ) {
+		std::vector<std::string> outputs;
+		auto pipeline = com::Pipeline<int>()
+							.addStage("square", [](int value) { return static_cast<long long>(value) * value; }, { .parallelism = 4, .queueCapacity = 64, .batchSize = 8 })
+							.addStage("format", [](long long value) { return std::to_string(value); }, { .parallelism = 3, .queueCapacity = 16 });
+		pipeline.start([&outputs](std::string value) { outputs.push_back(std::move(value)); });
+		for(int i = 0; i < count; ++i)
+			REQUIRE( pipeline.push(i) );
+		pipeline.close();
+		REQUIRE( !pipeline.push(count) );
+		pipeline.wait();
+		REQUIRE( outputs.size() == count );
+		bool isOrdered = true;
+		for(int i = 0; i < count; ++i)
+			isOrdered = isOrdered && (outputs[i] == std::to_string(static_cast<long long>(i) * i));
+		REQUIRE( isOrdered );
+
+		auto stats = pipeline.getStats();
+		REQUIRE( stats.size() == 2 );
+		REQUIRE( stats[0].name == "square" );
+		REQUIRE( stats[0].itemCount == count );
+		REQUIRE( stats[1].name == "format" );
+		REQUIRE( stats[1].itemCount == count );
+		REQUIRE( stats[1].throughput > 0 );
+	}
+
+	SECTION( "Unordered output" ) {
+		std::vector<int> outputs;
+		{
+			auto pipeline = com::Pipeline<int>()
+								.addStage("negate", [](int value) { return -value; }, { .parallelism = 4, .batchSize = 4 });
+			pipeline.start([&outputs](int value) { outputs.push_back(value); }, com::PipelineOutputOrder::Unordered);
+			for(int i = 0; i < count; ++i)
+				pipeline.push(i);
+			/* the destructor closes the pipeline and waits for it */
+		}
+		REQUIRE( outputs.size() == count );
+		std::sort(outputs.begin(), outputs.end());
+		bool isComplete = true;
+		for(int i = 0; i < count; ++i)
+			isComplete = isComplete && (outputs[i] == (i - count + 1));
+		REQUIRE( isComplete );
+	}
+
+	SECTION( "Pooled stages recycle their objects" ) {
+		constexpr std::size_t queueCapacity = 8;
+		std::atomic<int> createdCount = 0;
+		std::vector<int> outputs;
+		auto pipeline = com::Pipeline<int>()
+							.addPooledStage<std::vector<int>>("fill", [](int value, std::vector<int>& output)
+							{
+								output.assign(4, value);
+							},
+							[&createdCount]()
+							{
+								++createdCount;
+								return std::vector<int> { };
+							}, { .queueCapacity = queueCapacity })
+							.addStage("sum", [](const std::vector<int>& input)
+							{
+								int sum = 0;
+								for(int value : input)
+									sum += value;
+								return sum;
+							}, { .parallelism = 2, .queueCapacity = queueCapacity });
+		pipeline.start([&outputs](int value) { outputs.push_back(value); });
+		for(int i = 0; i < count; ++i)
+			pipeline.push(i);
+		pipeline.close();
+		pipeline.wait();
+		REQUIRE( outputs.size() == count );
+		bool isCorrect = true;
+		for(int i = 0; i < count; ++i)
+			isCorrect = isCorrect && (outputs[i] == (4 * i));
+		REQUIRE( isCorrect );
+		/* a new object is created only when the "fill" thread's magazines and the depot are empty, so all the others can only be
+		 * in the batch of the "fill" thread, in the "sum" stage's queue, or in the batches and the magazines of the 2 "sum" threads */
+		constexpr std::size_t magazineSize = com::ConcurrentDynamicPool<std::vector<int>*>::MagazineSize;
+		REQUIRE( createdCount <= static_cast<int>(queueCapacity + 3 * com::PipelineStageConfig { }.batchSize + 2 * 2 * magazineSize) );
+	}
+
+	SECTION( "Ordered output is bounded while an item is held up" ) {
+		constexpr std::size_t sinkQueueCapacity = 16;
+		std::atomic<bool> isReleased = false;
+		std::atomic<int> pushedCount = 0;
+		std::vector<int> outputs;
+		auto pipeline = com::Pipeline<int>()
+							.addStage("hold", [&isReleased](int value)
+							{
+								/* the first item comes out after all the others pushed meanwhile */
+								while((value == 0) && !isReleased)
+									std::this_thread::yield();
+								return value;
+							}, { .parallelism = 2, .queueCapacity = 256 });
+		pipeline.start([&outputs](int value) { outputs.push_back(value); }, com::PipelineOutputOrder::Ordered, sinkQueueCapacity);
+		std::thread pusher([&]()
+		{
+			for(int i = 0; i < 1000; ++i)
+			{
+				pipeline.push(i);
+				++pushedCount;
+			}
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		/* push() waits for the first item to reach the sink, instead of the sink holding back all the others */
+		REQUIRE( pushedCount <= static_cast<int>(sinkQueueCapacity) );
+		isReleased = true;
+		pusher.join();
+		pipeline.close();
+		pipeline.wait();
+		REQUIRE( outputs.size() == 1000 );
+		bool isOrdered = true;
+		for(int i = 0; i < 1000; ++i)
+			isOrdered = isOrdered && (outputs[i] == i);
+		REQUIRE( isOrdered );
+	}
+
+	SECTION( "No stage" ) {
+		std::vector<int> outputs;
+		com::Pipeline<int> pipeline;
+		pipeline.start([&outputs](int value) { outputs.push_back(value); });
+		for(int i = 0; i < 100; ++i)
+			pipeline.push(i);
+		pipeline.close();
+		pipeline.wait();
+		REQUIRE( outputs.size() == 100 );
+		REQUIRE( outputs.back() == 99 );
+	}
+}
@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/ProducerConsumerBuffer.hpp>
+
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+
+TEST_CASE( "ProducerConsumerBuffer", "[producer-consumer-buffer]" ) {
+
+	SECTION( "Bulk push and pop" ) {
+		com::ProducerConsumerBuffer<int> buffer;
+		std::vector<int> values { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		REQUIRE( buffer.pushBulk(values) == values.size() );
+		std::vector<int> popped;
+		REQUIRE( buffer.popBulk(std::back_inserter(popped), 4) == 4 );
+		REQUIRE( popped == std::vector<int> { 0, 1, 2, 3 } );
+		int array[16];
+		REQUIRE( buffer.popBulk(array, 16) == 6 );
+		for(int i = 0; i < 6; ++i)
+			REQUIRE( array[i] == (i + 4) );
+	}
+
+	SECTION( "tryPop and popFor" ) {
+		com::ProducerConsumerBuffer<int> buffer;
+		REQUIRE( !buffer.tryPop().has_value() );
+		REQUIRE( !buffer.popFor(std::chrono::milliseconds(1)).has_value() );
+		buffer.push(5);
+		REQUIRE( buffer.popFor(std::chrono::milliseconds(1)) == 5 );
+		buffer.push(6);
+		REQUIRE( buffer.tryPop() == 6 );
+		REQUIRE( !buffer.tryPop().has_value() );
+	}
+
+	SECTION( "close() drains and then rejects" ) {
+		com::ProducerConsumerBuffer<int> buffer;
+		buffer.push(1);
+		buffer.push(2);
+		buffer.close();
+		REQUIRE( buffer.isClosed() );
+		REQUIRE( !buffer.push(3) );
+		std::vector<int> values { 4, 5 };
+		REQUIRE( buffer.pushBulk(values) == 0 );
+		REQUIRE( buffer.popFor(std::chrono::seconds(10)) == 1 );
+		std::vector<int> popped;
+		REQUIRE( buffer.popBulk(std::back_inserter(popped), 8) == 1 );
+		REQUIRE( popped == std::vector<int> { 2 } );
+		REQUIRE( buffer.popBulk(std::back_inserter(popped), 8) == 0 );
+		REQUIRE( !buffer.popFor(std::chrono::seconds(10)).has_value() );
+	}
+
+	SECTION( "close() wakes up the waiters" ) {
+		/* bounded, so that the producer waits for the space */
+		com::ProducerConsumerBuffer<int> full(1);
+		full.push(0);
+		com::ProducerConsumerBuffer<int> empty;
+		std::atomic<bool> isPushed = true;
+		std::size_t poppedCount = 1;
+		std::thread producer([&]() { isPushed = full.push(1); });
+		std::thread consumer([&]() { int value; poppedCount = empty.popBulk(&value, 1); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		full.close();
+		empty.close();
+		producer.join();
+		consumer.join();
+		REQUIRE( !isPushed );
+		REQUIRE( poppedCount == 0 );
+	}
+
+	SECTION( "close() releases the blocking pops" ) {
+		com::ProducerConsumerBuffer<int> buffer;
+		std::optional<int> popped = 0;
+		std::atomic<bool> isThrown = false;
+		std::thread consumer([&]() { popped = buffer.popUnlessClosed(); });
+		std::thread thrower([&]()
+		{
+			try { buffer.pop(); }
+			catch(const std::runtime_error&) { isThrown = true; }
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		buffer.close();
+		consumer.join();
+		thrower.join();
+		REQUIRE( !popped.has_value() );
+		REQUIRE( isThrown );
+		/* the elements pushed before close() are still popped */
+		com::ProducerConsumerBuffer<int> closed;
+		closed.push(1);
+		closed.close();
+		REQUIRE( closed.popUnlessClosed() == 1 );
+		REQUIRE( !closed.popUnlessClosed().has_value() );
+		REQUIRE_THROWS_AS( closed.pop(), std::runtime_error );
+	}
+
+	SECTION( "Bounded bulk transfer between threads" ) {
+		constexpr int count = 100000;
+		constexpr int batchSize = 64;
+		com::ProducerConsumerBuffer<int> buffer(batchSize * 2);
+		std::thread producer([&]()
+		{
+			std::vector<int> batch;
+			for(int i = 0; i < count; i += batchSize)
+			{
+				batch.clear();
+				for(int j = i; j < std::min(i + batchSize, count); ++j)
+					batch.push_back(j);
+				buffer.pushBulk(batch);
+			}
+			buffer.close();
+		});
+		long long sum = 0;
+		int expected = 0;
+		bool isOrdered = true;
+		int batch[batchSize];
+		while(std::size_t n = buffer.popBulk(batch, batchSize))
+			for(std::size_t i = 0; i < n; ++i)
+			{
+				isOrdered = isOrdered && (batch[i] == expected);
+				++expected;
+				sum += batch[i];
+			}
+		producer.join();
+		REQUIRE( isOrdered );
+		REQUIRE( expected == count );
+		REQUIRE( sum == (static_cast<long long>(count) * (count - 1) / 2) );
+	}
+}
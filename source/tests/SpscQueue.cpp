@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/SpscQueue.hpp>
+
+#include <thread>
+#include <memory>
+
+TEST_CASE( "SpscQueue", "[spsc-queue]" ) {
+
+	SECTION( "Single thread" ) {
+		auto queue = std::make_unique<com::SpscQueue<int, 8>>();
+		REQUIRE( queue->capacity() == 8 );
+		REQUIRE( queue->isEmpty() );
+		for(int i = 0; i < 8; ++i)
+			REQUIRE( queue->tryPush(i) );
+		REQUIRE( !queue->tryPush(8) );
+		int value = -1;
+		for(int i = 0; i < 8; ++i)
+		{
+			REQUIRE( queue->tryPop(value) );
+			REQUIRE( value == i );
+		}
+		REQUIRE( !queue->tryPop(value) );
+		REQUIRE( queue->isEmpty() );
+		/* wraps around */
+		for(int i = 0; i < 100; ++i)
+		{
+			queue->push(i);
+			REQUIRE( queue->pop() == i );
+		}
+	}
+
+	SECTION( "Non-trivial elements are destroyed" ) {
+		auto shared = std::make_shared<int>(1);
+		{
+			com::SpscQueue<std::shared_ptr<int>, 4> queue;
+			queue.push(shared);
+			queue.push(shared);
+			queue.push(shared);
+			REQUIRE( shared.use_count() == 4 );
+			auto popped = queue.pop();
+			REQUIRE( shared.use_count() == 4 );
+		}
+		REQUIRE( shared.use_count() == 1 );
+	}
+
+	SECTION( "Producer and consumer" ) {
+		constexpr int count = 200000;
+		/* small capacity, so that both sides find the queue full or empty */
+		com::SpscQueue<int, 16> queue;
+		std::thread producer([&queue]()
+		{
+			for(int i = 0; i < 200000; ++i)
+				queue.push(i);
+		});
+		bool isOrdered = true;
+		for(int i = 0; i < count; ++i)
+			isOrdered = (queue.pop() == i) && isOrdered;
+		producer.join();
+		REQUIRE( isOrdered );
+		REQUIRE( queue.isEmpty() );
+	}
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <common/StableDynamicPool.hpp>
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <type_traits>
+
+TEST_CASE( "StableDynamicPool", "[stable-dynamic-pool]" ) {
+
+	/* the std::function policy needs a create hook, so it can't be left out */
+	static_assert(!std::is_default_constructible_v<com::StableDynamicPool<int>>);
+
+	int createCount = 0;
+	int destroyCount = 0;
+	int returnCount = 0;
+	int recycleCount = 0;
+	auto onCreate = [&createCount]() { return createCount++; };
+	auto onDestroy = [&destroyCount](int&) { ++destroyCount; };
+	auto onReturn = [&returnCount](int&) { ++returnCount; };
+	auto onRecycle = [&recycleCount](int&) { ++recycleCount; };
+	using Pool = com::StableDynamicPool<int, com::DynamicPoolFunctionPolicy<int>, 4>;
+
+	SECTION( "The objects never move" ) {
+		Pool pool(onCreate, onDestroy, onReturn, onRecycle);
+		std::vector<int*> addresses;
+		/* several chunks */
+		for(int i = 0; i < 10; ++i)
+		{
+			int& value = pool.get();
+			REQUIRE( value == i );
+			addresses.push_back(&value);
+		}
+		REQUIRE( pool.size() == 10 );
+		REQUIRE( pool.activeCount() == 10 );
+		for(int i = 0; i < 10; ++i)
+			REQUIRE( *addresses[i] == i );
+
+		/* put back in the order they were taken out, none of the others moves */
+		pool.put(*addresses[0]);
+		pool.put(*addresses[1]);
+		REQUIRE( returnCount == 2 );
+		REQUIRE( pool.activeCount() == 8 );
+		for(int i = 2; i < 10; ++i)
+			REQUIRE( *addresses[i] == i );
+
+		/* recycled in place */
+		int& value = pool.get();
+		REQUIRE( ((&value == addresses[0]) || (&value == addresses[1])) );
+		REQUIRE( recycleCount == 1 );
+		REQUIRE( createCount == 10 );
+
+		/* growth doesn't move the existing ones either */
+		pool.reserve(100);
+		REQUIRE( pool.size() == 100 );
+		for(int i = 2; i < 10; ++i)
+			REQUIRE( *addresses[i] == i );
+
+		int activeCount = 0;
+		pool.forEachActive([&activeCount](int&) { ++activeCount; });
+		REQUIRE( activeCount == 9 );
+	}
+
+	SECTION( "Handles" ) {
+		Pool pool(onCreate, nullptr, onReturn);
+		auto h1 = pool.getHandle();
+		auto h2 = pool.getHandle();
+		int* p2 = &pool.getValue(h2);
+		pool.put(h1);
+		REQUIRE( !pool.isValid(h1) );
+		REQUIRE( pool.isValid(h2) );
+		REQUIRE( &pool.getValue(h2) == p2 );
+		/* stale and double puts are ignored */
+		pool.put(h1);
+		REQUIRE( pool.activeCount() == 1 );
+		auto h3 = pool.getHandle();
+		REQUIRE( h3.slot == h1.slot );
+		REQUIRE( !(h3 == h1) );
+		/* put by reference invalidates the handle as well */
+		pool.put(pool.getValue(h2));
+		REQUIRE( !pool.isValid(h2) );
+		REQUIRE( returnCount == 2 );
+		/* not from this pool */
+		int other = 0;
+		pool.put(other);
+		REQUIRE( pool.activeCount() == 1 );
+
+		pool.reclaim();
+		REQUIRE( !pool.isValid(h3) );
+		REQUIRE( returnCount == 3 );
+		auto h4 = pool.getHandle();
+		pool.clear();
+		REQUIRE( !pool.isValid(h4) );
+		REQUIRE( pool.size() == 0 );
+		auto h5 = pool.getHandle();
+		REQUIRE( h5.slot == 0 );
+		REQUIRE( pool.isValid(h5) );
+		REQUIRE( !pool.isValid(h4) );
+	}
+
+	SECTION( "Objects which can't be copied, destroyed with the pool" ) {
+		struct Policy
+		{
+			int* destroyCount;
+			std::unique_ptr<std::array<char, 4096>> create() { return std::make_unique<std::array<char, 4096>>(); }
+			void destroy(std::unique_ptr<std::array<char, 4096>>&) { ++(*destroyCount); }
+		};
+		{
+			com::StableDynamicPool<std::unique_ptr<std::array<char, 4096>>, Policy, 2> pool(Policy { &destroyCount }, false, 3);
+			REQUIRE( pool.size() == 3 );
+			auto& message = pool.get();
+			(*message)[0] = 'a';
+			pool.put(message);
+			REQUIRE( (*pool.get())[0] == 'a' );
+			/* moving the pool doesn't move the objects */
+			auto* address = &pool.get();
+			auto other = std::move(pool);
+			REQUIRE( pool.size() == 0 );
+			REQUIRE( other.size() == 3 );
+			other.put(*address);
+			REQUIRE( other.activeCount() == 1 );
+		}
+		REQUIRE( destroyCount == 3 );
+	}
+}